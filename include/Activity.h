@@ -0,0 +1,78 @@
+#ifndef ACTIVITY_H
+#define ACTIVITY_H
+
+#include "Battlefield.h"
+#include "Ship.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ActivityMonitor class
+ * - Puts ships to sleep while nothing can reach them and wakes them when
+ *   something might ("activity sleep" scenarios, see GameManager).
+ * - A ship may sleep after its action if no live enemy is within its reach:
+ *   the Chebyshev radius it can affect in one turn (one step plus its weapon
+ *   range, see reach()). SuperShips fire anywhere on the board and ships
+ *   off the board hit without range checks, so those never sleep.
+ * - A sleeper watches the 8x8 tiles its reach covers. Any enemy put on a
+ *   cell of a watched tile (a move, a ram, a respawn) wakes it, and so does
+ *   any hit on it. Tiles are kept in a hash map, so the watch lists cost
+ *   memory only where ships sleep, even on huge chunked boards.
+ * - Watch entries are not removed on wake-up: each carries the sleeper's
+ *   sleep generation, and stale entries are dropped when the tile is next
+ *   visited.
+ */
+class ActivityMonitor : public CellWatcher {
+public:
+  static const int TILE_BITS = 3; // 8x8 tiles
+
+  // Radius a ship of this type can affect in one turn, -1 if unbounded
+  static int reach(ShipType type);
+
+private:
+  struct Watch {
+    int32_t ship;
+    uint32_t generation;
+  };
+
+  const Battlefield *battlefield;
+  const std::vector<int> *teamOf;
+  int tileCols; // tiles per board row
+
+  std::unordered_map<uint64_t, std::vector<Watch>> watches; // per tile
+  std::vector<uint32_t> generation; // per ship, bumped on every sleep
+  std::vector<uint8_t> asleep;      // per ship
+  std::vector<int32_t> woken;       // woken since the last takeWoken()
+  size_t sleeperCount;
+
+  bool enemyWithin(int x, int y, int radius, int team) const;
+
+public:
+  ActivityMonitor();
+
+  // Start over with `teams` (fleet index -> team index): nobody asleep.
+  // The board and the team table must outlive the monitor's use.
+  void reset(const Battlefield &bf, const std::vector<int> &teams);
+
+  // Copy the sleepers and watch lists of `other` for a forked world
+  void forkFrom(const ActivityMonitor &other, const Battlefield &bf,
+                const std::vector<int> &teams);
+
+  // Put the ship to sleep if nothing is within its reach
+  bool trySleep(const Ship *s);
+
+  // Wake a sleeper (no-op if it is awake)
+  void wake(int32_t ship);
+
+  void cellOccupied(int x, int y, Ship *ship) override;
+
+  bool isAsleep(int32_t ship) const { return asleep[ship] != 0; }
+  size_t sleepers() const { return sleeperCount; }
+
+  // Ships woken since the last call; the caller clears the list
+  std::vector<int32_t> &takeWoken() { return woken; }
+};
+
+#endif // ACTIVITY_H
@@ -0,0 +1,55 @@
+#ifndef ALLOCAUDIT_H
+#define ALLOCAUDIT_H
+
+#include <cstddef>
+#include <ostream>
+
+/**
+ * Allocation audit
+ * - Built with -DALLOC_AUDIT (`make audit`), the global operator new is
+ *   replaced by a counting version. Allocations made on the simulation
+ *   thread are charged to the phase it is in.
+ * - GameManager marks processRespawns(), executeTurn() and handleUpgrades()
+ *   with a Scope. A steady-state turn must not allocate in any of them;
+ *   report() prints the counters and tells the caller whether that held.
+ * - In normal builds Scope compiles to nothing and the counters stay 0.
+ */
+namespace AllocAudit {
+
+enum Phase { UNTRACKED, RESPAWNS, TURN, UPGRADES, PHASE_COUNT };
+
+const char *phaseName(Phase phase);
+
+// True when the counting operator new is compiled in
+bool enabled();
+
+std::size_t allocations(Phase phase);
+std::size_t bytes(Phase phase);
+void reset();
+
+// Print the per-phase table. Returns false if an audited phase allocated.
+bool report(std::ostream &out);
+
+#ifdef ALLOC_AUDIT
+// Charge this thread's allocations to `phase` until the scope ends
+class Scope {
+private:
+  Phase previous;
+
+public:
+  explicit Scope(Phase phase);
+  ~Scope();
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+};
+#else
+class Scope {
+public:
+  explicit Scope(Phase) {}
+};
+#endif
+
+} // namespace AllocAudit
+
+#endif // ALLOCAUDIT_H
@@ -1,49 +1,237 @@
 #ifndef BATTLEFIELD_H
 #define BATTLEFIELD_H
 
+#include "BoardKernels.h"
+#include "ChunkedGrid.h"
 #include "Constants.h"
+#include "Random.h"
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 
 // Forward declaration
 class Ship;
+class TurnJournal;
+struct Position;
+
+// A horizontal strip of island cells (row, first column, length), the
+// terrain record of compiled scenario images
+struct IslandRun {
+  int32_t row;
+  int32_t col;
+  int32_t length;
+};
+
+// Told whenever a ship is put on a cell (see Battlefield::setWatcher)
+class CellWatcher {
+public:
+  virtual ~CellWatcher() {}
+  virtual void cellOccupied(int x, int y, Ship *ship) = 0;
+};
 
 /**
  * Battlefield class
- * - Maintains a 2D array or vector to represent the battlefield layout
- *   (0 => water, 1 => island, or it can store occupant references).
+ * - Maintains the battlefield layout (0 => water, 1 => island) plus occupant
+ *   references, sized at runtime from the config file.
+ * - Storage variants ("layout" keyword):
+ *     DENSE   : flat row-major arrays, best for small / crowded boards. They
+ *               are padded with a BOARD_BORDER ring of CELL_OUTSIDE sentinels,
+ *               so neighbour and weapon probes need no bounds checks.
+ *     TILED   : the same padded arrays stored as 8x8 tiles
+ *     MORTON  : the same padded arrays in Z-order
+ *               (both keep the rows above / below a ship nearby in memory,
+ *               which matters once boards are thousands of cells wide)
+ *     CHUNKED : lazily allocated 64x64 tiles (see ChunkedGrid), memory scales
+ *               with the active area instead of the board area
+ * - The layout only changes where cells live, never the simulation result.
+ * - forkFrom() copies a board for what-if branches: CHUNKED boards share
+ *   their tiles copy-on-write, the padded arrays are copied whole (they are
+ *   meant for boards small enough that this is cheap).
+ * - Dense boards of a common size (10x10, 32x32, 64x64, 256x256) run the
+ *   neighbourhood kernels compiled for that exact size (see BoardKernels.h);
+ *   any other size uses the runtime-sized versions.
  * - Provides methods to place / move ships, check occupancy, display, etc.
- *
- * Implementation will appear in Battlefield.cpp (Set 3).
  */
 class Battlefield {
+public:
+  enum Layout { DENSE, TILED, MORTON, CHUNKED };
+
+  // "dense" / "tiled" / "morton" / "chunked"
+  static const char *layoutName(Layout l);
+  static bool parseLayout(const std::string &name, Layout &out);
+
+  // Board sizes with precompiled kernels, picked in resize()
+  enum Shape { SHAPE_GENERIC, SHAPE_10, SHAPE_32, SHAPE_64, SHAPE_256 };
+
 private:
-  // We store the map of 0s & 1s from the config file, plus occupant info
-  // For occupant, we might keep a pointer to a Ship, or we just store a char.
-  // Let's keep a 2D of ints for the map, plus a 2D of Ship* for occupant.
-  int terrain[HEIGHT][WIDTH];    // 0=water, 1=island
-  Ship *occupant[HEIGHT][WIDTH]; // null if no ship
+  int width;
+  int height;
+  Layout layout;
+  Shape shape;
+
+  // DENSE / TILED / MORTON storage, padded, see cellIndex()
+  std::vector<unsigned char> terrain; // CELL_WATER / ISLAND / OUTSIDE
+  std::vector<Ship *> occupant;       // null if no ship (always in the ring)
+  int tilesPerRow;                    // TILED
+  std::vector<unsigned> mortonRow;    // MORTON: index part of each padded
+  std::vector<unsigned> mortonCol;    //         row and column
+  static const int MORTON_BLOCK = 64; // largest Z-order block side
+
+  // CHUNKED storage
+  ChunkedGrid chunked;
+
+  CellWatcher *watcher; // optional, see setWatcher()
+  TurnJournal *journal; // optional, see setJournal()
+
+  // Zobrist hash of the occupants (see Zobrist.h), kept by setOccupant()
+  // and livesChanged()
+  uint64_t stateHash;
+  uint64_t occupantKey(int x, int y, const Ship *s, int lives) const;
+
+  // Kernel accessor for the chunked grid; it has no ring, so it checks
+  struct ChunkedAt {
+    const Battlefield *bf;
+    Ship *occupant(int x, int y) const {
+      return bf->inBounds(x, y) ? bf->chunked.getOccupant(x, y) : nullptr;
+    }
+    bool outside(int x, int y) const { return !bf->inBounds(x, y); }
+  };
+
+  int cellIndex(int x, int y) const {
+    switch (layout) {
+    case TILED:
+      return BoardKernels::tiledIndex(x, y, tilesPerRow);
+    case MORTON:
+      return BoardKernels::mortonIndex(x, y, mortonRow.data(),
+                                       mortonCol.data());
+    default:
+      return BoardKernels::denseIndex<0>(x, y, width);
+    }
+  }
+  size_t allocateMorton(int paddedWidth, int paddedHeight);
+
+  // Call kernel(accessor) with the specialisation for this board
+  template <typename Kernel> bool dispatch(Kernel &&kernel) const;
 
 public:
   Battlefield();
   ~Battlefield() {}
 
-  // Called after reading from config
-  void setTerrain(const int newGrid[HEIGHT][WIDTH]);
+  // Resize the board (all water, no occupants) and pick the storage variant
+  void resize(int newWidth, int newHeight, Layout newLayout = DENSE);
 
-  // Checking or modifying occupant
-  bool isIsland(int x, int y) const;
-  bool isOccupied(int x, int y) const;
-  Ship *getOccupant(int x, int y) const;
+  // Called after reading from config: mark the given cells as islands
+  void setTerrain(const std::vector<Position> &islands);
+  void setTerrain(const IslandRun *runs, size_t count);
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  Layout getLayout() const { return layout; }
+  Shape getShape() const { return shape; }
+  bool inBounds(int x, int y) const {
+    return x >= TOP_BOUNDARY && x < height && y >= LEFT_BOUNDARY && y < width;
+  }
+
+  // Checking or modifying occupant. Reads may use any cell up to
+  // BOARD_BORDER outside the board: they see no island and no ship.
+  bool isIsland(int x, int y) const {
+    if (layout == CHUNKED)
+      return inBounds(x, y) && chunked.isIsland(x, y);
+    return terrain[cellIndex(x, y)] == CELL_ISLAND;
+  }
+  bool isOccupied(int x, int y) const { return getOccupant(x, y) != nullptr; }
+  Ship *getOccupant(int x, int y) const {
+    if (layout == CHUNKED)
+      return inBounds(x, y) ? chunked.getOccupant(x, y) : nullptr;
+    return occupant[cellIndex(x, y)];
+  }
   void setOccupant(int x, int y, Ship *shipPtr);
 
+  // The owner's ship list, indexed by Ship::getFleetIndex(): chunked boards
+  // store occupants by index and read them back through it
+  void setFleet(const std::vector<Ship *> *ships) { chunked.setFleet(ships); }
+
+  // Become a copy of `other` whose occupants are the ships with the same
+  // fleet index in `fleet`. Keeps this board's fleet list; no watcher.
+  void forkFrom(const Battlefield &other, const std::vector<Ship *> &fleet);
+  // Occupant tiles a chunked board had to copy since forkFrom()
+  size_t forkCopiedTiles() const { return chunked.getCopiedTiles(); }
+
+  // Called by Ship::takeDamage(): `s` had `oldLives` lives until now
+  void livesChanged(const Ship *s, int oldLives);
+
+  // Hash of (cell, type, team, lives) over every occupied cell
+  uint64_t getHash() const { return stateHash; }
+
+  // Report every ship put on a cell to `w` (nullptr: nobody)
+  void setWatcher(CellWatcher *w) { watcher = w; }
+
+  // Record every change to the board and its ships in `j` (nullptr: stop)
+  void setJournal(TurnJournal *j) { journal = j; }
+  TurnJournal *getJournal() const { return journal; }
+
+  // For TurnJournal::undoTurn(): put back a recorded occupant and hash,
+  // with no journal, watcher or position update
+  void restoreOccupant(int x, int y, Ship *shipPtr);
+  void restoreHash(uint64_t hash) { stateHash = hash; }
+
+  // In bounds and not occupied: a ship may step there
+  bool isFree(int x, int y) const;
+
+  // Scan the 8 neighbours of (x, y) for an enemy of self / a free cell
+  bool scanNeighbours(int x, int y, const Ship *self,
+                      BoardKernels::NeighbourScan &out) const;
+
   // Place a new ship at a random valid location (water & not occupied)
   // Return true if successful, false otherwise
-  bool placeShipRandomly(Ship *shipPtr);
+  bool placeShipRandomly(Ship *shipPtr, Random &rng);
+
+  // Rough heap footprint of the grid storage in bytes
+  size_t memoryUsage() const;
 
   // Utility to display the entire map
   void display(std::ostream &out = std::cout) const;
 };
 
+template <typename Kernel> bool Battlefield::dispatch(Kernel &&kernel) const {
+  using namespace BoardKernels;
+  if (layout == CHUNKED) {
+    return kernel(ChunkedAt{this});
+  }
+  const unsigned char *t = terrain.data();
+  Ship *const *cells = occupant.data();
+  if (layout == TILED) {
+    return kernel(TiledAt{t, cells, tilesPerRow});
+  }
+  if (layout == MORTON) {
+    return kernel(MortonAt{t, cells, mortonRow.data(), mortonCol.data()});
+  }
+  switch (shape) {
+  case SHAPE_10:
+    return kernel(DenseAt<10>{t, cells, width});
+  case SHAPE_32:
+    return kernel(DenseAt<32>{t, cells, width});
+  case SHAPE_64:
+    return kernel(DenseAt<64>{t, cells, width});
+  case SHAPE_256:
+    return kernel(DenseAt<256>{t, cells, width});
+  default:
+    return kernel(DenseAt<0>{t, cells, width});
+  }
+}
+
+inline bool Battlefield::isFree(int x, int y) const {
+  return dispatch(
+      [&](const auto &at) { return BoardKernels::isFree(at, x, y); });
+}
+
+inline bool
+Battlefield::scanNeighbours(int x, int y, const Ship *self,
+                            BoardKernels::NeighbourScan &out) const {
+  return dispatch([&](const auto &at) {
+    return BoardKernels::scanNeighbours(at, x, y, self, out);
+  });
+}
+
 #endif // BATTLEFIELD_H
@@ -0,0 +1,146 @@
+#ifndef BOARDKERNELS_H
+#define BOARDKERNELS_H
+
+#include "Constants.h"
+#include "Ship.h"
+#include "WeaponPatterns.h"
+
+/**
+ * Board kernels
+ * - The small neighbourhood scans every ship repeats each turn, written once.
+ * - Cells are read through an accessor so the same kernel runs on the dense
+ *   arrays and on the chunked grid. An accessor provides
+ *     occupant(x, y) : the ship there, nullptr when empty or off the board
+ *     outside(x, y)  : true when (x, y) is off the board
+ * - The dense arrays carry a BOARD_BORDER ring of sentinel cells, so for them
+ *   both calls are a single load with no bounds branches.
+ * - DenseAt<W> with W > 0 bakes the board width in: the row stride
+ *   constant-folds and the fixed 8-neighbour loop unrolls.
+ *   DenseAt<0> is the generic runtime-sized fallback.
+ * - TiledAt / MortonAt read the same padded board stored in 8x8 tiles or in
+ *   Z-order, which keeps vertical neighbours close together on wide boards.
+ */
+namespace BoardKernels {
+
+// The 8 neighbours, in the order the ships have always scanned them
+// (dx outer loop, dy inner loop)
+constexpr int NEIGHBOUR_COUNT = WeaponPatterns::RING_1.size;
+
+// Result of scanNeighbours()
+struct NeighbourScan {
+  Ship *enemy; // first live enemy found, or nullptr
+  int enemyX, enemyY;
+  int freeX, freeY; // first empty cell before the enemy, -1 if none
+};
+
+// Row-major index into a padded dense array
+template <int W> inline int denseIndex(int x, int y, int width) {
+  const int stride = (W > 0 ? W : width) + 2 * BOARD_BORDER;
+  return (x + BOARD_BORDER) * stride + (y + BOARD_BORDER);
+}
+
+// Dense padded arrays (see Battlefield)
+template <int W> struct DenseAt {
+  const unsigned char *terrain;
+  Ship *const *cells;
+  int width;
+
+  Ship *occupant(int x, int y) const {
+    return cells[denseIndex<W>(x, y, width)];
+  }
+  bool outside(int x, int y) const {
+    return terrain[denseIndex<W>(x, y, width)] == CELL_OUTSIDE;
+  }
+};
+
+// Padded board stored as 8x8 tiles (row-major inside a tile and across
+// tiles): a tile of Ship* is 512 bytes, one cache line per tile row
+constexpr int TILE_SHIFT = 3;
+constexpr int TILE_MASK = (1 << TILE_SHIFT) - 1;
+
+inline int tiledIndex(int x, int y, int tilesPerRow) {
+  int px = x + BOARD_BORDER;
+  int py = y + BOARD_BORDER;
+  int tile = (px >> TILE_SHIFT) * tilesPerRow + (py >> TILE_SHIFT);
+  return (tile << (2 * TILE_SHIFT)) | ((px & TILE_MASK) << TILE_SHIFT) |
+         (py & TILE_MASK);
+}
+
+struct TiledAt {
+  const unsigned char *terrain;
+  Ship *const *cells;
+  int tilesPerRow;
+
+  Ship *occupant(int x, int y) const {
+    return cells[tiledIndex(x, y, tilesPerRow)];
+  }
+  bool outside(int x, int y) const {
+    return terrain[tiledIndex(x, y, tilesPerRow)] == CELL_OUTSIDE;
+  }
+};
+
+// Padded board in Morton (Z-order) blocks. Each padded row's and column's
+// share of the index (block offset plus interleaved bits) is precomputed,
+// so an index is two loads and an add.
+inline int mortonIndex(int x, int y, const unsigned *rowBits,
+                       const unsigned *colBits) {
+  return static_cast<int>(rowBits[x + BOARD_BORDER] +
+                          colBits[y + BOARD_BORDER]);
+}
+
+struct MortonAt {
+  const unsigned char *terrain;
+  Ship *const *cells;
+  const unsigned *rowBits;
+  const unsigned *colBits;
+
+  Ship *occupant(int x, int y) const {
+    return cells[mortonIndex(x, y, rowBits, colBits)];
+  }
+  bool outside(int x, int y) const {
+    return terrain[mortonIndex(x, y, rowBits, colBits)] == CELL_OUTSIDE;
+  }
+};
+
+// In bounds and nobody there (islands count as free, as in move())
+template <typename At> inline bool isFree(const At &at, int x, int y) {
+  // '&' rather than '&&': both loads are cheap, skip the extra branch
+  return !at.outside(x, y) & !at.occupant(x, y);
+}
+
+/**
+ * Look at the 8 cells around (x, y).
+ * Stops at the first live ship of another team (returns true). Until then it
+ * remembers the first empty cell, which is where a Cruiser would move.
+ */
+template <typename At>
+inline bool scanNeighbours(const At &at, int x, int y, const Ship *self,
+                           NeighbourScan &out) {
+  out.enemy = nullptr;
+  out.enemyX = out.enemyY = -1;
+  out.freeX = out.freeY = -1;
+
+#pragma GCC unroll 8
+  for (int i = 0; i < NEIGHBOUR_COUNT; i++) {
+    int nx = x + WeaponPatterns::RING_1[i].dx;
+    int ny = y + WeaponPatterns::RING_1[i].dy;
+
+    // Off-board cells read as empty, so only the "free" test needs them
+    Ship *occ = at.occupant(nx, ny);
+    if (occ && occ->isAlive() && occ != self &&
+        occ->getTeam() != self->getTeam()) {
+      out.enemy = occ;
+      out.enemyX = nx;
+      out.enemyY = ny;
+      return true;
+    } else if (!occ && out.freeX < 0 && !at.outside(nx, ny)) {
+      out.freeX = nx;
+      out.freeY = ny;
+    }
+  }
+  return false;
+}
+
+} // namespace BoardKernels
+
+#endif // BOARDKERNELS_H
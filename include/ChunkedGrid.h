@@ -0,0 +1,137 @@
+#ifndef CHUNKEDGRID_H
+#define CHUNKEDGRID_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Forward declaration
+class Ship;
+
+/**
+ * ChunkedGrid class
+ * - Sparse storage for very large, mostly empty battlefields.
+ * - The board is cut into 64x64 chunks. Each chunk entry points at a terrain
+ *   tile and (optionally) an occupant tile.
+ * - All-water and all-island terrain tiles are shared constants, so only
+ *   coastlines cost memory.
+ * - Occupant tiles are allocated when the first ship enters a chunk and freed
+ *   again when the last ship leaves it. A few emptied tiles are kept as
+ *   spares, so ships crossing chunk borders every turn do not hit the heap.
+ * - Occupant cells hold fleet indices (+1, 0 = empty), resolved through the
+ *   owner's ship list (setFleet()). Tiles therefore mean the same thing in
+ *   every copy of a world, and forkFrom() shares them all: a tile is copied
+ *   the first time either side writes to it, so a fork costs the chunk
+ *   table plus the tiles that actually change. Reference counts are atomic,
+ *   so forks of one world may run on different threads.
+ *
+ * Callers are expected to pass in-bounds coordinates (same contract as the
+ * dense Battlefield arrays).
+ */
+class ChunkedGrid {
+public:
+  static constexpr int CHUNK_SHIFT = 6;
+  static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT; // 64
+  static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+  static constexpr int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+
+private:
+  struct TerrainTile {
+    unsigned char cell[CHUNK_CELLS]; // 0=water, 1=island
+  };
+
+  struct OccupantTile {
+    int32_t cell[CHUNK_CELLS]; // fleet index + 1, 0 = no ship
+    int count;             // number of ships, tile is freed when it hits 0
+    std::atomic<int> refs; // grids sharing the tile; written only when 1
+  };
+
+  struct Chunk {
+    const TerrainTile *terrain;
+    OccupantTile *occupants; // null if no ship in this chunk
+  };
+
+  int width;
+  int height;
+  int chunkCols;
+  int chunkRows;
+  std::vector<Chunk> chunks;
+
+  // Terrain tiles that are neither all-water nor all-island. Shared with
+  // forks; terrain is only edited right after resize(), on fresh tiles.
+  std::vector<std::shared_ptr<TerrainTile>> ownedTerrain;
+  size_t occupantTileCount;
+  size_t copiedTiles; // occupant tiles unshared since the last forkFrom()
+
+  const std::vector<Ship *> *fleet; // resolves occupant cells
+
+  // Emptied occupant tiles kept for reuse (at most MAX_SPARE_TILES)
+  static constexpr size_t MAX_SPARE_TILES = 8;
+  std::vector<OccupantTile *> spareTiles;
+
+  static const TerrainTile &waterTile();
+  static const TerrainTile &islandTile();
+
+  // The single chunk-table lookup used by every accessor
+  const Chunk &chunkAt(int x, int y) const {
+    return chunks[(x >> CHUNK_SHIFT) * chunkCols + (y >> CHUNK_SHIFT)];
+  }
+  Chunk &chunkAt(int x, int y) {
+    return chunks[(x >> CHUNK_SHIFT) * chunkCols + (y >> CHUNK_SHIFT)];
+  }
+  static int cellOffset(int x, int y) {
+    return ((x & CHUNK_MASK) << CHUNK_SHIFT) | (y & CHUNK_MASK);
+  }
+
+  TerrainTile *makeTerrainPrivate(Chunk &c);
+  OccupantTile *takeOccupantTile();
+  OccupantTile *unshare(Chunk &c);
+  void retireOccupantTile(OccupantTile *tile);
+  void releaseTile(OccupantTile *tile);
+  void freeOccupants();
+
+public:
+  ChunkedGrid();
+  ~ChunkedGrid();
+
+  ChunkedGrid(const ChunkedGrid &) = delete;
+  ChunkedGrid &operator=(const ChunkedGrid &) = delete;
+
+  // Reset to an all-water board of the given size with no occupants
+  void resize(int newWidth, int newHeight);
+
+  // Terrain editing; call compactTerrain() once the map is loaded
+  void setIsland(int x, int y, bool island);
+  void compactTerrain();
+
+  bool isIsland(int x, int y) const {
+    return chunkAt(x, y).terrain->cell[cellOffset(x, y)] == 1;
+  }
+
+  Ship *getOccupant(int x, int y) const {
+    const Chunk &c = chunkAt(x, y);
+    if (!c.occupants)
+      return nullptr;
+    int32_t id = c.occupants->cell[cellOffset(x, y)];
+    return id ? (*fleet)[id - 1] : nullptr;
+  }
+
+  // Occupants are stored by Ship::getFleetIndex() and read back from this
+  // list, which must outlive the grid
+  void setFleet(const std::vector<Ship *> *ships) { fleet = ships; }
+
+  void setOccupant(int x, int y, Ship *shipPtr);
+  void clearOccupants();
+
+  // Become a copy of `other` (same size, terrain and occupants) sharing
+  // all of its tiles. The fleet list is kept.
+  void forkFrom(const ChunkedGrid &other);
+  size_t getCopiedTiles() const { return copiedTiles; }
+
+  // Rough heap footprint in bytes (chunk table + private and spare tiles)
+  size_t memoryUsage() const;
+};
+
+#endif // CHUNKEDGRID_H
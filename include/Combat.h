@@ -0,0 +1,69 @@
+#ifndef COMBAT_H
+#define COMBAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Forward declarations
+class Battlefield;
+class Ship;
+
+/**
+ * CombatBuffer class
+ * - Optional combat stage ("combat batched" in the scenario file).
+ * - Instead of applying damage inside shoot()/ram(), every hit of the turn is
+ *   appended to one flat buffer. After all ships have acted, resolve() sorts
+ *   the hits by target cell and settles them in a single pass over the board.
+ * - Fire is simultaneous: a ship hit this turn still acts this turn, and the
+ *   result no longer depends on the order of the ships.
+ *
+ * Resolution rules (per target cell, then per ship in that cell):
+ * - The damage of all hits is summed and applied at once; a ram is lethal.
+ * - If the target dies, every distinct attacker that hit it is credited
+ *   with the kill (Ship::recordKill(), which may queue an upgrade).
+ * - A rammer moves into the cell of the ship it sank, unless it died itself,
+ *   has been moved, or another surviving rammer claims the same cell (then
+ *   the cell stays empty).
+ */
+class CombatBuffer {
+public:
+  enum Mode { IMMEDIATE, BATCHED };
+
+  static const char *modeName(Mode mode);
+  static bool parseMode(const std::string &name, Mode &mode);
+
+private:
+  struct Hit {
+    uint64_t cell;    // target cell, row-major
+    uint32_t arrival; // order the hit was recorded in
+    Ship *attacker;
+    Ship *target;
+    int x, y;
+    int damage;
+    bool ram;
+  };
+
+  std::vector<Hit> hits;
+  uint32_t arrivals;
+
+  void resolveCell(size_t begin, size_t end);
+  void settleRams(Battlefield &bf, size_t begin, size_t end);
+
+public:
+  CombatBuffer();
+
+  // Make room for a whole turn of hits up front
+  void reserve(size_t count) { hits.reserve(count); }
+  size_t size() const { return hits.size(); }
+
+  void addShot(Ship *attacker, Ship *target, int x, int y, int damage,
+               int boardWidth);
+  void addRam(Ship *attacker, Ship *target, int x, int y, int boardWidth);
+
+  // Apply everything recorded this turn, then empty the buffer
+  void resolve(Battlefield &bf);
+};
+
+#endif // COMBAT_H
@@ -1,11 +1,26 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
-// You can move these into a config or read them from file if you prefer dynamic
-// sizing
+// Default board size. The real size is read from the config file
+// ("width" / "height") and stored in the Battlefield at runtime.
 static const int WIDTH = 10;
 static const int HEIGHT = 10;
 
+// Boards with more cells than this are summarised instead of printed
+static const long long MAX_DISPLAY_CELLS = 200 * 200;
+
+// Terrain cell values. CELL_OUTSIDE marks the sentinel ring around the board.
+static const unsigned char CELL_WATER = 0;
+static const unsigned char CELL_ISLAND = 1;
+static const unsigned char CELL_OUTSIDE = 2;
+
+// Furthest any weapon or scan reaches from its ship (city-block 5 shots)
+static const int MAX_WEAPON_REACH = 5;
+
+// Width of the sentinel ring around dense boards: the weapon reach plus one,
+// so probes from a ship that could not be placed (-1,-1) stay in the array
+static const int BOARD_BORDER = MAX_WEAPON_REACH + 1;
+
 // Symbol to represent an empty cell in the battlefield array
 static const char EMPTY_CELL = 0;
 static const char EMPTY_DISPLAY = '.';
@@ -14,6 +29,13 @@ static const char EMPTY_DISPLAY = '.';
 static const int TOP_BOUNDARY = 0;
 static const int LEFT_BOUNDARY = 0;
 
+// Bump whenever the simulation rules change, so cached sweep results from
+// older builds are not reused
+static const int ENGINE_VERSION = 3;
+
+// Most hits one ship can make in a turn (SuperShip: a ram and 3 shots)
+static const int MAX_HITS_PER_SHIP = 4;
+
 // Default lives per ship
 static const int DEFAULT_LIVES = 3;
 
@@ -0,0 +1,85 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class GameManager;
+
+/**
+ * SimDaemon class
+ * - Long-running server mode, so a harness that plays thousands of battles
+ *   pays for process startup once:
+ *     warship_sim serve                  line protocol on stdin / stdout
+ *     warship_sim serve --socket PATH    same protocol per Unix socket
+ *                                        connection (one thread each)
+ * - Protocol, one request per line:
+ *     <scenario line>   any scenario file line, collected until "end"
+ *     end               play the scenario collected so far
+ *     file <path>       play a scenario file
+ *     quit              close this connection
+ *     shutdown          stop the daemon
+ * - Every battle is answered with one line:
+ *     ok seed=42 winner=A turns=20 kills=7 alive=A:3,B:0 us=85
+ *     error <message>
+ *   Scenarios without a seed get a fresh one, reported back so the battle
+ *   can be replayed.
+ * - Battles run silenced on GameManagers taken from a pool and reset after
+ *   use, so their containers (and the ship slots) are reused.
+ * - Finished connection threads are joined each time round the accept loop,
+ *   so only live connections hold a thread. On shutdown the remaining
+ *   clients are disconnected before their threads are joined.
+ */
+class SimDaemon {
+private:
+  std::mutex poolMutex;
+  std::vector<std::unique_ptr<GameManager>> idle;
+
+  std::atomic<uint64_t> battles;
+  std::atomic<bool> stopping;
+  uint64_t seedBase;
+  int listenFd;
+
+  // One socket client; `fd` is -1 once the connection has closed it
+  struct Connection {
+    std::thread thread;
+    int fd;
+  };
+  std::mutex connectionMutex;
+  std::list<Connection> connections;
+
+  std::unique_ptr<GameManager> acquire();
+  void release(std::unique_ptr<GameManager> manager);
+
+  // Handle one protocol line. `pending` holds the scenario being collected;
+  // a non-empty `reply` must be sent back. Returns false to end the session.
+  bool handleLine(const std::string &line, std::string &pending,
+                  std::string &reply);
+
+  void serveConnection(Connection *connection);
+  // Join the threads of closed connections
+  void reapConnections();
+
+public:
+  SimDaemon();
+  ~SimDaemon();
+
+  SimDaemon(const SimDaemon &) = delete;
+  SimDaemon &operator=(const SimDaemon &) = delete;
+
+  // Play one scenario and format its result line (without the newline)
+  std::string runScenario(const std::string &scenarioText);
+
+  // Both return a process exit code
+  int serveStream(std::istream &in, std::ostream &out);
+  int serveSocket(const std::string &path);
+};
+
+#endif // DAEMON_H
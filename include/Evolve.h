@@ -0,0 +1,95 @@
+#ifndef EVOLVE_H
+#define EVOLVE_H
+
+#include "parseFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Scheduler;
+
+/**
+ * Fleet optimiser description, read from a small keyword file:
+ *
+ *   scenario game1.txt      board, rules and the other teams' fleets
+ *   team A                  the team whose fleet is evolved
+ *   budget 20               points a fleet may spend
+ *   cost Battleship 5       price of one ship of a type; only types with a
+ *   cost Cruiser 3          cost line are used (scripted ones too)
+ *   maxShips 10             (optional) at most this many ships
+ *   population 24           fleets per generation
+ *   generations 20
+ *   elite 2                 best fleets kept unchanged
+ *   battles 64              seeded battles per opponent fleet (seeds
+ *   firstSeed 1              firstSeed.. , the same for every fleet)
+ *   cull 16                 after this many, drop clearly losing fleets
+ *                           (0 = play them all)
+ *   opponents 3             0 (default): the scenario's fleets; K: the best
+ *                           fleets of the last K generations, playing the
+ *                           other team (needs exactly two teams)
+ *   engine object           (optional) never use the LockstepEngine
+ *   seed 7                  drives selection, crossover and mutation
+ *   threads 8               worker threads (0 = all cores)
+ *   pin 1                   pin worker i to core i
+ *   output best.txt         (optional) the scenario with the best fleet
+ */
+struct EvolveSpec {
+  std::string scenarioFile;
+  std::string team;
+  int budget;
+
+  struct Cost {
+    std::string type;
+    int points;
+  };
+  std::vector<Cost> costs;
+  int maxShips;
+
+  int population;
+  int generations;
+  int elite;
+  int battles;
+  uint64_t firstSeed;
+  int cull;
+  int opponents;
+  bool objectEngine;
+  uint64_t seed;
+
+  int threads;
+  bool pin;
+  std::string output;
+};
+
+/**
+ * FleetEvolver class
+ * - Genetic search over the composition of one team's fleet: a genome is
+ *   a ship count per priced type, never over the budget. Each generation
+ *   keeps the elite, then fills up with children of tournament-picked
+ *   parents (uniform crossover, then one mutation: add, drop or swap a
+ *   ship), repaired back under the budget.
+ * - Fitness: wins plus half the draws and stalemates, over the battles
+ *   against every opponent fleet; ties go to the larger survivor margin,
+ *   then to the cheaper fleet.
+ * - Every (fleet, opponent) matchup is played under the same seeds, so
+ *   candidates are compared on the same dice. Its tally is cached under
+ *   SweepRunner::scenarioHash() of the battle's scenario text, so a fleet
+ *   that comes back (an elite, a duplicate child, an opponent seen before)
+ *   costs nothing, and extending a tally only plays the missing seeds.
+ * - Culling: every fleet first plays `cull` battles per opponent. One
+ *   whose win rate is below the best fleet's by more than both Hoeffding
+ *   margins (95%) stops there and ranks below every fully played one.
+ * - Battles of all fleets of a round go to the Scheduler together, in
+ *   groups of LockstepEngine::LANES seeds when the scenario allows it, so
+ *   one generation keeps every core busy. Results are folded in a fixed
+ *   order: a run depends on its seeds only, not on the thread count.
+ */
+class FleetEvolver {
+public:
+  EvolveSpec parseSpec(const std::string &filename);
+
+  // Run the search, printing one line per generation and the best fleet.
+  // Returns a process exit code.
+  int run(const EvolveSpec &spec, Scheduler &scheduler);
+};
+
+#endif // EVOLVE_H
@@ -1,21 +1,137 @@
 #ifndef GAMEMANAGER_H
 #define GAMEMANAGER_H
 
+#include "Activity.h"
 #include "Battlefield.h"
+#include "Combat.h"
+#include "Journal.h"
+#include "OutputPipeline.h"
+#include "Random.h"
 #include "Ship.h"
+#include "ShipScript.h"
+#include "TimingWheel.h"
+#include "TurnArena.h"
+#include "parseFile.h"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
+class GameManager;
+class ScenarioImage;
+
+// Notified at the end of every turn, after upgrades and the victory check
+class TurnObserver {
+public:
+  virtual ~TurnObserver() {}
+  virtual void turnEnded(const GameManager &manager, int turn) = 0;
+};
+
+// Externally chosen ship actions (see GameManager::setShipActions). HOLD and
+// the plain steps replace the ship's whole turn, so it does not fire; the
+// ATTACK ones run the ship's own turn without its move (Ship::isAnchored):
+// its own look, shots and rams, after the chosen step if any.
+enum ShipAction {
+  ACTION_AUTO,  // the ship's own behaviour
+  ACTION_HOLD,  // skip this turn
+  ACTION_UP,    // one step, if the cell is free
+  ACTION_DOWN,
+  ACTION_LEFT,
+  ACTION_RIGHT,
+  ACTION_ATTACK,       // stay put, then the ship's own attacks
+  ACTION_UP_ATTACK,    // one step, then the ship's own attacks
+  ACTION_DOWN_ATTACK,
+  ACTION_LEFT_ATTACK,
+  ACTION_RIGHT_ATTACK,
+  ACTION_COUNT
+};
+
 class GameManager {
 private:
   Battlefield battlefield;
   std::vector<Ship *> ships;
 
+  // Ship types defined by the scenario ("shiptype" blocks)
+  ShipCatalog catalog;
+
   std::vector<Ship *> respawnQueue;
   int maxRespawnsPerTurn;
   int maxShipRespawns;
   int totalIterations;
 
+  // Per-game RNG, so a seed fully determines the battle
+  Random rng;
+
+  // Outcome of the last runSimulation()
+  std::string winningTeam; // empty if nobody won
+  int turnsPlayed;
+
+  // Optional async writer; when set, each turn's log is one frame
+  OutputPipeline *output;
+
+  // Optional per-turn hook (e.g. the trace recorder)
+  TurnObserver *observer;
+
+  // Optional, one ShipAction per entry of `ships`; nullptr = all AUTO
+  const int8_t *shipActions;
+
+  // How hits are applied: straight away, or collected and resolved together
+  // after every ship has acted (see CombatBuffer)
+  CombatBuffer::Mode combatMode;
+  CombatBuffer combat;
+
+  // Memory for data that only lives through one turn; reset at the start
+  // of every playTurn() (see TurnArena). Declared before its users.
+  TurnArena turnArena;
+  void resetTurnMemory();
+
+  // Scheduled turn order (only once setActionRate() was called): each type
+  // acts every ratePeriod turns, higher rateInitiative first. Ships wait in
+  // a timing wheel keyed by turn, and the end-of-turn steps only visit the
+  // ships that acted, were hit or respawned ("touched"), so idle ships cost
+  // nothing. Without rates every ship acts every turn, in fleet order.
+  bool scheduled;
+  int ratePeriod[SHIP_TYPE_COUNT];
+  int rateInitiative[SHIP_TYPE_COUNT];
+  TimingWheel wheel;
+  std::pmr::vector<int32_t> due;     // ships due this turn (turn arena)
+  std::pmr::vector<int32_t> touched; // fleet indices, each once per turn
+  std::vector<uint8_t> touchedMark;  // per ship
+  std::vector<uint8_t> inWheel;      // per ship
+  std::vector<uint8_t> wasAlive;     // per ship, as of the last turn end
+  std::vector<int> teamOf;           // per ship, index into teamAlive
+  std::vector<int> teamAlive;        // alive ships per team
+  std::vector<std::string> teamNames;
+  int teamsAlive;
+
+  // "activity sleep": ships out of reach of every enemy skip their turns
+  // until something comes near (see ActivityMonitor); needs the scheduled
+  // turn order, so setSleeping() switches it on
+  bool sleeping;
+  ActivityMonitor activity;
+  void scheduleWoken();
+
+  // XOR of Zobrist::queueKey() over the respawn queue; with the board's
+  // hash it makes stateHash()
+  uint64_t queueHash;
+
+  // "stalemate N": end the battle once N turns pass without a hit, or as
+  // soon as the world is frozen out of reach (see checkStalemate())
+  int stalemateWindow;
+  int lastHitTurn;
+  uint64_t lastHash; // stateHash() at the end of the previous turn
+  bool stalemate;
+  bool checkStalemate(int turn);
+
+  // Optional undo log of the last turns (see setJournal())
+  std::unique_ptr<TurnJournal> journal;
+  void performJournaled(Ship *s);
+
+  void touch(const Ship *s);
+  void executeScheduledTurn(int turnNumber);
+  bool checkVictoryScheduled();
+
   // NEW: We'll reuse the same upgradeShip(...) function,
   // but we won't call it from ships directly. We'll call it
   // from handleUpgrades() after the turn ends.
@@ -24,23 +140,115 @@ public:
   GameManager();
   ~GameManager();
 
-  void setBattlefieldTerrain(const int grid[HEIGHT][WIDTH]);
+  void setBattlefieldTerrain(int width, int height,
+                             const std::vector<Position> &islands,
+                             Battlefield::Layout layout = Battlefield::DENSE);
   void addShip(Ship *newShip);
 
+  // Build the whole world (terrain, limits, seed, ships) from a config
+  void loadConfig(const GameConfig &config);
+
+  // Same from a compiled image; `seedOverride` (if set) replaces its seed
+  void loadImage(const ScenarioImage &image,
+                 const uint64_t *seedOverride = nullptr);
+
+  // Back to an empty world (ships deleted, counters and limits cleared), so
+  // the same manager can play another scenario reusing its containers
+  void reset();
+
+  // Become a copy of `other` for a what-if branch: ships (cloned), respawn
+  // queue, schedule, sleepers, RNG and counters. The board is shared
+  // copy-on-write on chunked layouts (see Battlefield::forkFrom), so forking
+  // a huge world costs its ship list plus the tiles either side changes
+  // afterwards. Only between turns (after prepareRun()); `other` must not
+  // change while it is being forked. The fork starts with no output,
+  // observer or ship actions; play on with playTurn(other's turn + 1).
+  void forkFrom(const GameManager &other);
+  // Occupant tiles copied since forkFrom()
+  size_t forkCopiedTiles() const { return battlefield.forkCopiedTiles(); }
+
+  void setRespawnLimits(int perTurn, int perShip) {
+    maxRespawnsPerTurn = perTurn;
+    maxShipRespawns = perShip;
+  }
+  void setSeed(uint64_t seed) { rng.seed(seed); }
+  int randomInt(int n) { return rng.nextInt(n); }
+  Random &getRandom() { return rng; }
+  const Random &getRandom() const { return rng; }
+
+  void setCombatMode(CombatBuffer::Mode mode) { combatMode = mode; }
+
+  // `type` acts every `period` turns (>= 1); within a turn ships act by
+  // descending initiative, then fleet order. Switches to the scheduled turn
+  // order; a ship that upgrades keeps its old period until its next action.
+  void setActionRate(ShipType type, int period, int initiative = 0);
+  bool isScheduled() const { return scheduled; }
+
+  // Let ships with nothing in reach sleep (changes the battle: a sleeper
+  // neither wanders nor draws random numbers)
+  void setSleeping(bool on);
+  size_t sleepingShips() const { return sleeping ? activity.sleepers() : 0; }
+
+  // 0 = play every turn (default)
+  void setStalemateWindow(int turns) { stalemateWindow = turns; }
+
+  // Keep an undo journal of the last `turns` turns for rewind() (0: none).
+  // Starts empty; needs the every-turn order (no rates, no sleeping).
+  void setJournal(size_t turns);
+  const TurnJournal *getJournal() const { return journal.get(); }
+  // Undo the last `turns` played turns, at most as many as the journal
+  // kept, and return how many were undone. The world is then exactly as
+  // it was before them; play on with playTurn(getTurnsPlayed() + 1).
+  int rewind(int turns);
+
+  // Zobrist hash of the world: every occupied cell (type, team, lives) and
+  // the respawn queue. Equal worlds hash equal in any layout or engine.
+  uint64_t stateHash() const { return battlefield.getHash() ^ queueHash; }
+  CombatBuffer::Mode getCombatMode() const { return combatMode; }
+
+  // Called by the ships for every hit on an enemy. A shot deals `damage`,
+  // a ram sinks the target and moves the attacker into its cell.
+  void applyHit(Ship *attacker, Ship *target, int x, int y, int damage);
+  void applyRam(Ship *attacker, Ship *target, int x, int y);
+
+  // The pipeline's stream must also be the current simLog() target
+  void setOutputPipeline(OutputPipeline *pipeline) { output = pipeline; }
+  void setTurnObserver(TurnObserver *o) { observer = o; }
+  // The array must outlive the turns it is used for
+  void setShipActions(const int8_t *actions) { shipActions = actions; }
+
+  // For containers that only live until the end of the current turn
+  std::pmr::memory_resource *turnMemory() { return &turnArena; }
+  const TurnArena &getTurnArena() const { return turnArena; }
+
   void runSimulation(int iterations);
+
+  // runSimulation() one turn at a time: prepareRun() once, then playTurn()
+  // for turns 1, 2, ... until it returns true (victory) or the turns run out
+  void prepareRun(int iterations);
+  bool playTurn(int turn);
+
   void executeTurn(int turnNumber);
+  void applyAction(Ship *s, int action);
 
   // Respawns
   void enqueueRespawn(Ship *deadShip);
   void processRespawns();
 
   // Upgrades
-  void upgradeShip(Ship *oldShip, const std::string &newType);
+  void upgradeShip(Ship *oldShip, ShipType newType);
 
   // NEW: after each turn, we'll check all ships for pending upgrades
   void handleUpgrades();
 
-  bool checkVictory() const;
+  bool checkVictory();
+
+  const std::string &getWinningTeam() const { return winningTeam; }
+  int getTurnsPlayed() const { return turnsPlayed; }
+  int getTotalIterations() const { return totalIterations; }
+  // The last run ended early with no possible progress left
+  bool isStalemate() const { return stalemate; }
+  const std::vector<Ship *> &getShips() const { return ships; }
 
   Battlefield &getBattlefield() { return battlefield; }
   const Battlefield &getBattlefield() const { return battlefield; }
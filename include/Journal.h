@@ -0,0 +1,125 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "parseFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+class Battlefield;
+class Ship;
+
+/**
+ * TurnJournal class
+ * - Optional undo log for debugging (GameManager::setJournal). While a
+ *   turn plays, every change to the world first appends the value it
+ *   overwrites: occupant cells, ship positions, lives, kills, respawn
+ *   counters, pending upgrades, ship behaviour state (Frigate sweep,
+ *   script registers), respawn queue edits and upgrades.
+ *   GameManager::rewind(k) plays them back in reverse, so stepping back
+ *   costs what the turns changed, not a replay from turn 1.
+ * - Entries are 16 bytes in one append-only buffer. Each turn starts with
+ *   a mark holding what is simply restored whole: the RNG counter, the
+ *   board and queue hashes and the stalemate counters.
+ * - Ships are referenced by fleet index, so entries stay valid across
+ *   upgrades. An upgraded ship is kept as a copy (Ship::clone) until its
+ *   turn is undone or dropped.
+ * - Only the last `keep` turns are kept. Older ones are dropped from the
+ *   front, and the buffer is compacted once the dropped part is half of
+ *   it, so memory stays bounded however long the run is.
+ */
+class TurnJournal {
+public:
+  enum Op : uint8_t {
+    CELL,        // a, b: cell; ship: previous occupant + 1 (0 = none)
+    POSITION,    // a, b: the ship's previous position
+    LIVES,       // a: previous lives
+    KILLS,       // a: previous kill count
+    RESPAWN,     // a: previous respawn count, b: awaiting respawn
+    PENDING,     // a: previous pending upgrade
+    STATE,       // a: word of Ship::behaviourState(), b: previous value
+    QUEUE_PUSH,  // a ship was appended to the respawn queue
+    QUEUE_ERASE, // a: position the ship was taken from
+    UPGRADE      // a: index of the replaced ship's copy in `upgraded`
+  };
+
+  struct Entry {
+    uint8_t op;
+    int32_t ship; // fleet index
+    int32_t a;
+    int32_t b;
+  };
+
+  // Restored whole when a turn is undone
+  struct TurnMark {
+    int turn;
+    size_t begin;         // first entry
+    size_t upgradeBegin;  // first kept ship copy
+    uint64_t rngCounter;
+    uint64_t boardHash;
+    uint64_t queueHash;
+    int lastHitTurn;
+    uint64_t lastHash;
+  };
+
+private:
+  size_t keep;
+  std::vector<Entry> entries;
+  std::vector<Ship *> upgraded; // ships replaced by upgrades, owned
+  size_t front;                 // entries of dropped turns end here
+  size_t upgradeFront;
+  std::deque<TurnMark> turns;
+
+  void push(uint8_t op, int32_t ship, int32_t a, int32_t b) {
+    Entry e = {op, ship, a, b};
+    entries.push_back(e);
+  }
+  void dropOldest();
+
+public:
+  explicit TurnJournal(size_t keepTurns);
+  ~TurnJournal();
+
+  TurnJournal(const TurnJournal &) = delete;
+  TurnJournal &operator=(const TurnJournal &) = delete;
+
+  // Start recording a turn (drops the oldest one if `keep` are kept)
+  void beginTurn(const TurnMark &mark);
+
+  // Called before the change they describe
+  void cell(int x, int y, const Ship *previous, const Ship *next);
+  void lives(const Ship *s);
+  void kills(const Ship *s);
+  void respawn(const Ship *s);
+  void pending(const Ship *s);
+  void state(const Ship *s, int word, int32_t previous);
+  void queuePush();
+  void queueErase(size_t position, const Ship *s);
+  // `replaced` is a copy of the ship about to be upgraded; owned from now
+  void upgrade(const Ship *s, Ship *replaced);
+
+  // Undo the last kept turn on this world; false if none is left. The
+  // caller restores the mark's scalars. Detach the journal from the board
+  // first, so the undo itself is not recorded.
+  bool undoTurn(std::vector<Ship *> &ships, Battlefield &bf,
+                std::vector<Ship *> &queue, TurnMark &mark);
+
+  size_t getKeep() const { return keep; }
+  size_t turnsKept() const { return turns.size(); }
+  size_t entryCount() const { return entries.size() - front; }
+  // Heap footprint of the buffers in bytes (ship copies excluded)
+  size_t memoryUsage() const {
+    return entries.capacity() * sizeof(Entry) +
+           upgraded.capacity() * sizeof(Ship *) +
+           turns.size() * sizeof(TurnMark);
+  }
+};
+
+// "step" command: play the scenario under commands read from `in` (next /
+// back / show / quit), keeping `keep` turns of undo journal
+int runStepper(const GameConfig &config, size_t keep, std::istream &in,
+               std::ostream &out);
+
+#endif // JOURNAL_H
@@ -0,0 +1,15 @@
+#ifndef LAYOUTBENCH_H
+#define LAYOUTBENCH_H
+
+/**
+ * Cell layout benchmark ("warship_sim bench-layout [size] [reps]")
+ * - Builds the same size x size board with the same scattered ships in every
+ *   Battlefield layout (dense, tiled, morton, chunked).
+ * - Times the scans ships do every turn: the 8-neighbour scan and the
+ *   city-block 5 diamond around each ship, visiting ships in fleet order.
+ * - Reports ns and (when perf counters are available) cache misses per
+ *   probe, plus a checksum that must be equal for every layout.
+ */
+int runLayoutBench(int size, int reps);
+
+#endif // LAYOUTBENCH_H
@@ -0,0 +1,111 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "Random.h"
+#include "Sweep.h"
+#include "parseFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * LockstepEngine class
+ * - Plays a batch of up to LANES battles of the same small scenario, one
+ *   battle per lane, for Monte Carlo runs. It gives exactly the battles
+ *   GameManager plays for the same seeds (same rules, same random draws, same
+ *   quirks), without Ship objects, strings, virtual calls or logging.
+ * - Lanes are independent, so each battle is played to its end before the
+ *   next one starts. Each lane's state is one contiguous block, so a battle
+ *   only touches its own few cache lines:
+ *     occupancy   one byte per cell: ship index + 1, 0 = empty
+ *     ships       position, lives, kills, respawns, type, ... per ship
+ *     terrain     one bitboard shared by every lane
+ * - There is no SIMD: the rules are scalar, branchy code with a per-lane
+ *   RNG. The speed-up over GameManager comes from dropping the Ship
+ *   objects, virtual calls and logging. The rules are written a second
+ *   time here, so make trace-check replays lockstep battles on GameManager
+ *   (montecarlo --verify) to catch the two drifting apart.
+ * - Occupancy keeps the ship index rather than a bit per team: every rule
+ *   needs to know which ship is hit (damage, kill credit, upgrades), so a
+ *   team bitboard would still need the index next to it.
+ * - Only for immediate combat without action rates, sleeping or stalemate
+ *   detection, boards up to MAX_CELLS cells and fleets up to MAX_SHIPS
+ *   ships; see supports().
+ */
+class LockstepEngine {
+public:
+  static const int LANES = 16;
+  static const int MAX_CELLS = 4096;
+  static const int MAX_SHIPS = 254;
+
+private:
+  int width, height, cells, iterations;
+  int perTurn, perShip;
+  int shipCount;
+  std::vector<std::string> teamNames;
+  std::vector<uint64_t> teamKeys; // Zobrist::teamKey() per team
+  std::vector<uint8_t> shipTeam; // per ship (never changes)
+  std::vector<uint8_t> shipType; // per ship, as configured
+  std::vector<uint64_t> islands; // bitboard, bit x * width + y
+
+  // Per-lane state, lane after lane (see cellAt() / shipAt())
+  std::vector<uint8_t> occupant;
+  std::vector<int16_t> posX, posY;
+  std::vector<int16_t> lives, kills, respawns;
+  std::vector<uint8_t> type, pending, awaiting, firing;
+  std::vector<uint8_t> queue; // respawn queue, [lane][slot]
+
+  Random rng[LANES];
+  int queueLength[LANES];
+  bool active[LANES]; // still fighting
+  int turns[LANES];
+  int winner[LANES]; // team index, -1 if none
+
+  // Each lane's state is one contiguous block: [lane][cell], [lane][ship]
+  int cellAt(int cell, int lane) const { return lane * cells + cell; }
+  int shipAt(int ship, int lane) const { return lane * shipCount + ship; }
+
+  bool inBounds(int x, int y) const {
+    return x >= 0 && x < height && y >= 0 && y < width;
+  }
+  bool isIsland(int x, int y) const {
+    int c = x * width + y;
+    return (islands[c >> 6] >> (c & 63)) & 1;
+  }
+  int occupantAt(int x, int y, int lane) const {
+    return inBounds(x, y) ? occupant[cellAt(x * width + y, lane)] : 0;
+  }
+  bool isFree(int x, int y, int lane) const {
+    return inBounds(x, y) && !occupant[cellAt(x * width + y, lane)];
+  }
+  bool alive(int ship, int lane) const { return lives[shipAt(ship, lane)] > 0; }
+
+  void setOccupant(int x, int y, int lane, int ship);
+  void clearOccupant(int x, int y, int lane);
+  bool placeRandomly(int ship, int lane);
+
+  void takeDamage(int ship, int lane, int damage);
+  void recordKill(int ship, int lane);
+  void hit(int attacker, int lane, int x, int y);
+  void ram(int attacker, int lane, int x, int y);
+  bool scan(int ship, int lane, int &ex, int &ey, int &fx, int &fy) const;
+  void step4(int ship, int lane);
+  void shootDiamond(int ship, int lane);
+
+  void startLane(int lane, uint64_t seed);
+  void processRespawns(int lane);
+  void stepShip(int ship, int lane);
+  void finishTurn(int lane);
+  uint64_t stateHash(int lane) const; // as GameManager::stateHash()
+
+public:
+  explicit LockstepEngine(const GameConfig &config);
+
+  // False (with the reason) if the config needs the object engine
+  static bool supports(const GameConfig &config, std::string &reason);
+
+  // Play `count` (<= LANES) battles, seeds[l] in lane l
+  void run(const uint64_t *seeds, int count, SweepResult *results);
+};
+
+#endif // LOCKSTEP_H
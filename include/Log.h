@@ -0,0 +1,31 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <iostream>
+
+/**
+ * Simulation log
+ * - All per-turn messages (ship actions, damage, the board display) go to
+ *   simLog() instead of std::cout directly.
+ * - The target is per thread, so batch modes can silence or capture the
+ *   output of each game they run without touching the others.
+ */
+std::ostream &simLog();
+
+// A stream that drops everything (formatting is skipped too)
+std::ostream &nullLog();
+
+// Redirect simLog() for the current thread until this object goes away
+class ScopedLog {
+private:
+  std::ostream *previous;
+
+public:
+  explicit ScopedLog(std::ostream &out);
+  ~ScopedLog();
+
+  ScopedLog(const ScopedLog &) = delete;
+  ScopedLog &operator=(const ScopedLog &) = delete;
+};
+
+#endif // LOG_H
@@ -0,0 +1,37 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "parseFile.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+class Scheduler;
+
+/**
+ * Monte Carlo runs
+ * - `warship_sim montecarlo game1.txt --battles 100000` plays one scenario
+ *   under seeds first..first+battles-1 and prints the win rate of each team,
+ *   the mean length and kills, percentiles of the outcome metrics and the
+ *   throughput.
+ * - Memory does not depend on the number of battles: every worker folds
+ *   its results into counters and QuantileSketches (see Sketch.h), merged
+ *   once at the end.
+ * - Battles go through the LockstepEngine in groups of LANES when the
+ *   scenario allows it (see LockstepEngine::supports()), otherwise through
+ *   GameManager; `--engine object` forces the latter. `--verify` plays every
+ *   battle on both engines and counts the ones that differ.
+ * - Groups are spread over the shared Scheduler.
+ */
+struct MonteCarloSpec {
+  uint64_t firstSeed = 1;
+  int battles = 10000;
+  bool objectEngine = false;
+  bool verify = false;
+};
+
+// Returns a process exit code (1 if --verify found a difference)
+int runMonteCarlo(const GameConfig &config, const MonteCarloSpec &spec,
+                  Scheduler &scheduler, std::ostream &out);
+
+#endif // MONTECARLO_H
@@ -0,0 +1,92 @@
+#ifndef OUTPUTPIPELINE_H
+#define OUTPUTPIPELINE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * OutputPipeline class
+ * - Moves terminal / pipe I/O off the simulation thread.
+ * - The simulation writes each turn (board display + ship events) into an
+ *   in-memory frame through stream(). endFrame() hands the frame to a
+ *   dedicated writer thread and continues with the next free buffer, so turn
+ *   N+1 is simulated while turn N is being written.
+ * - Frames travel through a fixed ring of buffers (single producer, single
+ *   consumer). When every buffer is still waiting to be written the policy
+ *   decides: BLOCK waits for the writer, DROP discards the new frame. Only
+ *   turn frames are dropped; the last frame (flush()) always waits, so the
+ *   end-of-run summary is never lost.
+ */
+class OutputPipeline {
+public:
+  enum Policy { BLOCK, DROP };
+
+private:
+  // streambuf that appends straight into the current frame buffer
+  class FrameBuf : public std::streambuf {
+  public:
+    std::string *target;
+    FrameBuf() : target(nullptr) {}
+
+  protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+  };
+
+  std::ostream &dest;
+  Policy policy;
+
+  std::vector<std::string> buffers;
+  // Filled frames waiting for the writer, as a ring of buffer indices
+  std::vector<size_t> ring;
+  size_t head;
+  size_t filled;
+  // Buffers nobody is using. The producer always owns buffers[current].
+  std::vector<size_t> freeList;
+  size_t current;
+
+  FrameBuf frameBuf;
+  std::ostream frameStream;
+
+  std::mutex mtx;
+  std::condition_variable frameReady;
+  std::condition_variable bufferFree;
+  bool stopping;
+  size_t droppedFrames;
+  size_t writtenFrames;
+
+  std::thread writer;
+
+  void writerLoop();
+
+public:
+  // bufferCount >= 2 (2 = classic double buffering)
+  OutputPipeline(std::ostream &destination, size_t bufferCount = 2,
+                 Policy backpressure = BLOCK,
+                 size_t reserveBytes = 64 * 1024);
+  ~OutputPipeline();
+
+  OutputPipeline(const OutputPipeline &) = delete;
+  OutputPipeline &operator=(const OutputPipeline &) = delete;
+
+  // Stream the simulation writes the current frame into
+  std::ostream &stream() { return frameStream; }
+
+  // Hand the current frame to the writer thread. `force` waits for a free
+  // buffer whatever the policy.
+  void endFrame(bool force = false);
+
+  // Submit the last frame and wait until everything has been written
+  void flush();
+
+  size_t getDroppedFrames() const { return droppedFrames; }
+  size_t getWrittenFrames() const { return writtenFrames; }
+};
+
+#endif // OUTPUTPIPELINE_H
@@ -0,0 +1,43 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+/**
+ * Random class
+ * - Small per-game random number generator (SplitMix64).
+ * - Each GameManager owns one, so runs are reproducible from a seed and
+ *   several games can run on different threads without sharing rand().
+ * - The generator is counter based: state = seed + counter * GAMMA, so the
+ *   full state is just (seed, counter).
+ */
+class Random {
+private:
+  static const uint64_t GAMMA = 0x9E3779B97F4A7C15ULL;
+  uint64_t seedValue;
+  uint64_t counter;
+
+public:
+  explicit Random(uint64_t seed = 0) : seedValue(seed), counter(0) {}
+
+  void seed(uint64_t s) {
+    seedValue = s;
+    counter = 0;
+  }
+  uint64_t getSeed() const { return seedValue; }
+  uint64_t getCounter() const { return counter; }
+  void setCounter(uint64_t c) { counter = c; }
+
+  uint64_t next() {
+    counter++;
+    uint64_t z = seedValue + counter * GAMMA;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform-ish integer in [0, n)
+  int nextInt(int n) { return static_cast<int>(next() % static_cast<uint64_t>(n)); }
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,74 @@
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+#include "GameManager.h"
+#include "parseFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How far and how often to look ahead
+struct RolloutSpec {
+  int depth;     // turns per rollout (capped at the scenario's last turn)
+  int samples;   // rollouts per candidate action
+  uint64_t seed; // for samples after the first
+
+  RolloutSpec() : depth(5), samples(8), seed(1) {}
+};
+
+/**
+ * RolloutRunner class
+ * - Lookahead by simulation: fork the world (GameManager::forkFrom), force
+ *   one ship's action for the first turn, let everyone play on by
+ *   themselves for `depth` turns and score the outcome for the ship's team.
+ *   A ship (or an analyst) compares candidate actions by their mean score.
+ * - Sample 0 continues the world's own random stream, so a single sample
+ *   is the exact what-if of the action. Sample k > 0 reseeds the fork from
+ *   (seed, k); every candidate sees the same samples, so differences in
+ *   score come from the action, not from the dice.
+ * - Score: the lives of the team's ships minus the lives of everyone
+ *   else's, at the end of the rollout.
+ * - One scratch world is reused for every rollout. Ship slots come back
+ *   from the pool and chunked boards share their tiles with the world, so
+ *   a rollout costs the ship list plus the tiles it changes.
+ * - Rollouts are silent (simLog() is dropped). The world must be between
+ *   turns and must not change during a call; runners on other threads may
+ *   fork the same world at the same time.
+ */
+class RolloutRunner {
+private:
+  GameManager scratch;
+  std::vector<int8_t> actions;
+  uint64_t rollouts;
+  uint64_t turns;
+  uint64_t copiedTiles;
+
+  double score(const std::string &team) const;
+
+public:
+  RolloutRunner();
+
+  // Mean score of `action` for the ship with fleet index `ship`
+  double evaluate(const GameManager &world, int ship, ShipAction action,
+                  const RolloutSpec &spec);
+
+  // The best of every ShipAction (first one on ties); the score
+  // of each goes to scores[ACTION_COUNT] if given
+  ShipAction choose(const GameManager &world, int ship,
+                    const RolloutSpec &spec, double *scores = nullptr);
+
+  uint64_t getRollouts() const { return rollouts; }
+  uint64_t getTurns() const { return turns; }
+  // Occupant tiles copied by all rollouts so far
+  uint64_t getCopiedTiles() const { return copiedTiles; }
+};
+
+// "auto", "hold", "up", "down", "left", "right"
+const char *shipActionName(ShipAction action);
+
+// "rollout" command: play the scenario to turn `atTurn`, then compare the
+// actions of the ship with symbol `symbol` and print the scores
+int runRollouts(const GameConfig &config, const std::string &symbol,
+                int atTurn, const RolloutSpec &spec);
+
+#endif // ROLLOUT_H
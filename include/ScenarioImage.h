@@ -0,0 +1,120 @@
+#ifndef SCENARIOIMAGE_H
+#define SCENARIOIMAGE_H
+
+#include "Battlefield.h"
+#include "parseFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Compiled scenario image
+ * - `warship_sim compile game.txt game.wsim` writes a scenario in a binary
+ *   form that is mapped straight into memory when run, with no tokenising,
+ *   no symbol building and no type-name lookups:
+ *
+ *     ImageHeader                  settings and section offsets
+ *     IslandRun[runCount]          terrain, one record per strip of islands
+ *     TeamRecord[teamCount]        team names (in the string table)
+ *     ShipRecord[shipCount]        the expanded fleet, one record per ship,
+ *                                  in creation order
+ *     char[stringBytes]            string table
+ *
+ * - Every section starts on an 8-byte boundary. Numbers are stored in the
+ *   byte order of the machine that compiled the image; the header records
+ *   it, so a foreign image is rejected instead of misread.
+ * - Bump IMAGE_VERSION whenever a record changes.
+ */
+struct ImageHeader {
+  char magic[8]; // "WSIMAGE\0"
+  uint32_t version;
+  uint32_t byteOrder; // IMAGE_BYTE_ORDER as written by the compiler
+  uint64_t fileSize;
+
+  int32_t iterations;
+  int32_t width;
+  int32_t height;
+  int32_t respawnsPerTurn;
+  int32_t shipRespawns;
+  uint8_t hasSeed;
+  uint8_t layout; // Battlefield::Layout
+  uint8_t combat; // CombatBuffer::Mode
+  uint8_t hasRates; // 1: scheduled turn order (GameConfig::rates)
+  uint64_t seed;
+
+  // Per ShipType; period 0 = no rate line (acts every turn, initiative 0)
+  uint16_t ratePeriod[SHIP_TYPE_COUNT];
+  int16_t rateInitiative[SHIP_TYPE_COUNT];
+  uint8_t sleeping; // 1: "activity sleep"
+  uint8_t reserved[3];
+  int32_t stalemateWindow;
+
+  uint64_t runOffset, runCount;
+  uint64_t teamOffset, teamCount;
+  uint64_t shipOffset, shipCount;
+  uint64_t stringOffset, stringBytes;
+};
+
+struct TeamRecord {
+  uint32_t nameOffset;
+  uint32_t nameLength;
+};
+
+struct ShipRecord {
+  uint32_t symbolOffset;
+  uint16_t symbolLength;
+  uint8_t type; // ShipType
+  uint8_t reserved;
+  uint32_t team; // index into the team table
+};
+
+/**
+ * ScenarioImage class
+ * - Read-only view of a compiled image, mapped with mmap() and checked once
+ *   on open (magic, version, byte order, section bounds).
+ */
+class ScenarioImage {
+public:
+  static const uint32_t IMAGE_VERSION = 4;
+  static const uint32_t IMAGE_BYTE_ORDER = 0x01020304;
+
+private:
+  const unsigned char *data;
+  size_t size;
+
+  void validate() const;
+
+public:
+  ScenarioImage();
+  ~ScenarioImage();
+
+  ScenarioImage(const ScenarioImage &) = delete;
+  ScenarioImage &operator=(const ScenarioImage &) = delete;
+
+  // Write `config` as an image (throws std::runtime_error on failure)
+  static void compile(const GameConfig &config, const std::string &path);
+
+  // True if the file starts with the image magic
+  static bool isImage(const std::string &path);
+
+  // Map an image (throws std::runtime_error if it is missing or invalid)
+  void open(const std::string &path);
+
+  const ImageHeader &header() const {
+    return *reinterpret_cast<const ImageHeader *>(data);
+  }
+  const IslandRun *runs() const {
+    return reinterpret_cast<const IslandRun *>(data + header().runOffset);
+  }
+  const TeamRecord *teams() const {
+    return reinterpret_cast<const TeamRecord *>(data + header().teamOffset);
+  }
+  const ShipRecord *ships() const {
+    return reinterpret_cast<const ShipRecord *>(data + header().shipOffset);
+  }
+  const char *strings() const {
+    return reinterpret_cast<const char *>(data + header().stringOffset);
+  }
+};
+
+#endif // SCENARIOIMAGE_H
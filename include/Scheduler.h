@@ -0,0 +1,249 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * WorkDeque class
+ * - Chase-Lev work-stealing deque of task pointers. The owning worker pushes
+ *   and pops at the bottom (LIFO, so it keeps working on what it just split),
+ *   other workers steal from the top (FIFO, so they take the big pieces).
+ * - The ring buffer doubles when full; old buffers are kept until the deque
+ *   goes away, because a thief may still be reading one.
+ */
+template <typename T> class WorkDeque {
+private:
+  struct Ring {
+    int64_t capacity;
+    std::unique_ptr<std::atomic<T *>[]> slots;
+
+    explicit Ring(int64_t cap)
+        : capacity(cap), slots(new std::atomic<T *>[cap]) {}
+    T *get(int64_t i) const {
+      return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+    void put(int64_t i, T *item) {
+      slots[i & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+  };
+
+  alignas(64) std::atomic<int64_t> top;
+  alignas(64) std::atomic<int64_t> bottom;
+  std::atomic<Ring *> ring;
+  std::vector<std::unique_ptr<Ring>> rings; // owner only
+
+  Ring *grow(Ring *old, int64_t t, int64_t b) {
+    rings.emplace_back(new Ring(old->capacity * 2));
+    Ring *bigger = rings.back().get();
+    for (int64_t i = t; i < b; i++) {
+      bigger->put(i, old->get(i));
+    }
+    ring.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+public:
+  explicit WorkDeque(int64_t capacity = 256) : top(0), bottom(0) {
+    rings.emplace_back(new Ring(capacity));
+    ring.store(rings.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkDeque(const WorkDeque &) = delete;
+  WorkDeque &operator=(const WorkDeque &) = delete;
+
+  // Owner only
+  void push(T *item) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Ring *r = ring.load(std::memory_order_relaxed);
+    if (b - t > r->capacity - 1) {
+      r = grow(r, t, b);
+    }
+    r->put(b, item);
+    bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only; nullptr if empty
+  T *pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Ring *r = ring.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *item = r->get(b);
+    if (t == b) {
+      // Last item: race the thieves for it
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread; nullptr if empty or another thief won
+  T *steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+      return nullptr;
+    Ring *r = ring.load(std::memory_order_acquire);
+    T *item = r->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+};
+
+/**
+ * Scheduler class
+ * - One pool of worker threads shared by every parallel mode (sweeps,
+ *   Monte Carlo batches, ...). The top-level code creates it once and hands
+ *   it to whatever needs parallelism, instead of each mode starting its own
+ *   std::threads.
+ * - Each worker owns a WorkDeque; idle workers steal from random victims and
+ *   sleep briefly when there is nothing to take.
+ * - The thread that creates the scheduler is worker 0: it runs tasks while
+ *   it waits, so `threads 1` means no extra threads at all.
+ * - Fork/join: spawn() tasks into a TaskGroup, then wait() for it.
+ *   parallelFor() splits an index range in halves down to `grain` indices,
+ *   so thieves take large pieces and the owner works through small ones.
+ * - wait() / parallelFor() must be called from worker 0 or from a task.
+ *   An exception thrown by a task is rethrown by wait().
+ */
+class Scheduler {
+public:
+  class TaskGroup;
+
+  class Task {
+  public:
+    virtual ~Task() {}
+    virtual void run(Scheduler &scheduler) = 0;
+
+  private:
+    friend class Scheduler;
+    TaskGroup *group = nullptr;
+  };
+
+  class TaskGroup {
+  public:
+    TaskGroup() : pending(0) {}
+
+  private:
+    friend class Scheduler;
+    std::atomic<int64_t> pending;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+  };
+
+  struct WorkerStats {
+    uint64_t tasks;
+    uint64_t steals;
+    double utilisation; // busy time / time since the stats were reset
+  };
+
+private:
+  struct alignas(64) Worker {
+    WorkDeque<Task> deque;
+    std::atomic<uint64_t> tasks{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> busyNanos{0};
+    uint64_t victimSeed = 0;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  bool pinned;
+
+  std::atomic<bool> stopping;
+  std::atomic<uint64_t> epoch; // bumped on every spawn, wakes sleepers
+  std::atomic<int> sleepers;
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+
+  std::chrono::steady_clock::time_point statsStart;
+
+  Task *findTask(int self);
+  void execute(int self, Task *task);
+  void workerMain(int index);
+
+  template <typename Body> class RangeTask : public Task {
+  private:
+    size_t begin, end, grain;
+    const Body *body;
+    TaskGroup *owner;
+
+  public:
+    RangeTask(size_t b, size_t e, size_t g, const Body *f, TaskGroup *t)
+        : begin(b), end(e), grain(g), body(f), owner(t) {}
+
+    void run(Scheduler &s) override {
+      while (end - begin > grain) {
+        size_t mid = begin + (end - begin) / 2;
+        s.spawn(*owner, new RangeTask(mid, end, grain, body, owner));
+        end = mid;
+      }
+      for (size_t i = begin; i < end; i++) {
+        (*body)(i);
+      }
+    }
+  };
+
+public:
+  // threadCount <= 0: one worker per hardware thread. `pinCores` binds
+  // worker i to core i (Linux only; ignored elsewhere).
+  explicit Scheduler(int threadCount = 0, bool pinCores = false);
+  ~Scheduler();
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  int workerCount() const { return static_cast<int>(workers.size()); }
+
+  // Index (0 .. workerCount() - 1) of the calling worker, e.g. to pick its
+  // slot in per-worker accumulators
+  int currentWorker() const;
+
+  // Queue a heap-allocated task; the scheduler deletes it after it ran
+  void spawn(TaskGroup &group, Task *task);
+
+  // Run tasks until every task of the group has finished
+  void wait(TaskGroup &group);
+
+  // body(i) for every i in [begin, end)
+  template <typename Body>
+  void parallelFor(size_t begin, size_t end, size_t grain, const Body &body) {
+    if (begin >= end)
+      return;
+    TaskGroup group;
+    spawn(group, new RangeTask<Body>(begin, end, grain ? grain : 1, &body,
+                                     &group));
+    wait(group);
+  }
+
+  std::vector<WorkerStats> stats() const;
+  void resetStats();
+
+  // One line per worker: tasks run, steals, utilisation
+  void report(std::ostream &out) const;
+};
+
+#endif // SCHEDULER_H
@@ -2,10 +2,15 @@
 #define SHIP_H
 
 #include "Constants.h"
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
 
 class Battlefield;
+class GameManager;
+class TurnJournal;
+struct ShipProgram;
 
 // Position struct
 struct Position {
@@ -13,8 +18,30 @@ struct Position {
   Position(int px = -1, int py = -1) : x(px), y(py) {}
 };
 
+// Concrete ship types, used for deferred upgrade requests and as the type
+// IDs of compiled scenario images (so only append new types at the end)
+enum ShipType {
+  SHIP_NONE,
+  BATTLESHIP,
+  CRUISER,
+  DESTROYER,
+  FRIGATE,
+  CORVETTE,
+  AMPHIBIOUS,
+  SUPERSHIP
+};
+const int SHIP_TYPE_COUNT = SUPERSHIP + 1;
+
+// "Battleship", "Cruiser", ... ("None" for SHIP_NONE)
+const char *shipTypeName(ShipType type);
+// Inverse of shipTypeName(); false for an unknown name
+bool parseShipType(const std::string &name, ShipType &type);
+
 /**
  * Base abstract Ship class
+ * - Ships are allocated from ShipPool (see ShipPool.h) through the class
+ *   operator new/delete, so replacing a ship during an upgrade reuses a slot
+ *   instead of going to the heap.
  */
 class Ship {
 protected:
@@ -22,19 +49,42 @@ protected:
   int lives;
   int killCount;
   int respawnCount;
+  bool awaitingRespawn; // already in the GameManager's respawn queue
+  bool anchored;        // own turn without the move (ACTION_ATTACK)
+  int fleetIndex;       // index in GameManager's ship list, kept on upgrade
 
   std::string symbol;
   std::string team;
+  uint64_t teamKey; // Zobrist::teamKey(team)
 
   Battlefield *battlefieldPtr;
 
-  // NEW: store a pending upgrade request (empty if none)
-  std::string pendingUpgrade;
+  // NEW: store a pending upgrade request (SHIP_NONE if none)
+  ShipType pendingUpgrade;
+
+  // Upgrade constructor: the new ship takes over the symbol and team of the
+  // ship it replaces (moved, not copied) and its place in the fleet.
+  // Everything else starts fresh.
+  explicit Ship(Ship *predecessor);
+
+  // The board's undo journal, if one is recording (see TurnJournal)
+  TurnJournal *journal() const;
+
+  // Undoing a turn writes the recorded values straight back
+  friend class TurnJournal;
 
 public:
   Ship(const std::string &sym, const std::string &teamName);
+  virtual ~Ship() {}
+
+  static void *operator new(std::size_t size);
+  static void operator delete(void *p, std::size_t size);
 
   virtual void performTurn() = 0; // each final derived must implement
+  virtual ShipType getType() const = 0;
+  // Same ship, same state, for a forked world run by `mgr` (see
+  // GameManager::forkFrom); the caller sets its battlefield
+  virtual Ship *clone(GameManager *mgr) const = 0;
 
   // Common ship methods
   bool isAlive() const { return lives > 0; }
@@ -43,14 +93,23 @@ public:
   int getRespawnCount() const { return respawnCount; }
 
   void takeDamage(int dmg = 1);
-  void incrementKills() { killCount++; }
+  void incrementKills();
+  // Credit one kill; types that upgrade on kills override this to queue it
+  virtual void recordKill() { incrementKills(); }
+  // Scripted ships (see ShipScript.h): their program, and the one a queued
+  // upgrade turns them into (nullptr: the built-in type)
+  virtual const ShipProgram *getProgram() const { return nullptr; }
+  virtual const ShipProgram *getUpgradeProgram() const { return nullptr; }
   bool canRespawn(int maxAllowed = 3) const;
-  void incrementRespawnCount() { respawnCount++; }
+  void incrementRespawnCount();
+  bool isAwaitingRespawn() const { return awaitingRespawn; }
+  // While anchored, performTurn() skips the ship's own step; shots, rams
+  // (and moving into a rammed ship's cell) still happen
+  bool isAnchored() const { return anchored; }
+  void setAnchored(bool value) { anchored = value; }
+  void setAwaitingRespawn(bool waiting);
   // isWithinBoundary()
-  bool isWithinBoundary() {
-    return (pos.x >= TOP_BOUNDARY && pos.x < HEIGHT && pos.y >= LEFT_BOUNDARY &&
-            pos.y < WIDTH);
-  }
+  bool isWithinBoundary();
 
   // Position, team, symbol
   void setPosition(int x, int y) {
@@ -58,16 +117,29 @@ public:
     pos.y = y;
   }
   Position getPosition() const { return pos; }
-  std::string getSymbol() const { return symbol; }
-  std::string getTeam() const { return team; }
+  const std::string &getSymbol() const { return symbol; }
+  const std::string &getTeam() const { return team; }
+  uint64_t getTeamKey() const { return teamKey; }
+
+  int getFleetIndex() const { return fleetIndex; }
+  void setFleetIndex(int index) { fleetIndex = index; }
 
   void setBattlefieldPtr(Battlefield *bf) { battlefieldPtr = bf; }
   Battlefield *getBattlefield() const { return battlefieldPtr; }
 
   // NEW: for deferred upgrade logic
-  void requestUpgrade(const std::string &newType) { pendingUpgrade = newType; }
-  std::string getPendingUpgradeType() const { return pendingUpgrade; }
-  void clearPendingUpgrade() { pendingUpgrade.clear(); }
+  void requestUpgrade(ShipType newType);
+  ShipType getPendingUpgradeType() const { return pendingUpgrade; }
+  void clearPendingUpgrade();
+
+  // State a type keeps between its turns (Frigate sweep position, script
+  // registers), as `words` ints; nullptr if none. Journaled turns compare
+  // it around performTurn().
+  static const int MAX_STATE_WORDS = 8;
+  virtual int32_t *behaviourState(int &words) {
+    words = 0;
+    return nullptr;
+  }
 };
 
 #endif
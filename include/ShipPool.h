@@ -0,0 +1,32 @@
+#ifndef SHIPPOOL_H
+#define SHIPPOOL_H
+
+#include <cstddef>
+
+/**
+ * ShipPool
+ * - Fixed-size slots for Ship objects (every concrete ship type fits in one
+ *   slot, checked in ShipTypes.cpp).
+ * - Freed slots go back on a free list and are never returned to the heap,
+ *   so once a game has set up its fleet, replacing a ship (upgrades) costs
+ *   no heap allocation.
+ * - Shared by all threads (sweep workers), guarded by a mutex. Ships are
+ *   only created and destroyed at setup and on upgrades, so it is not hot.
+ */
+namespace ShipPool {
+
+constexpr std::size_t SLOT_SIZE = 256;
+
+// Get / return a slot. Requests bigger than SLOT_SIZE go to the heap.
+void *acquire(std::size_t size);
+void release(void *p, std::size_t size);
+
+// Make sure at least `count` slots are free (grows the pool if needed)
+void reserve(std::size_t count);
+
+// Slots currently on the free list
+std::size_t freeSlots();
+
+} // namespace ShipPool
+
+#endif // SHIPPOOL_H
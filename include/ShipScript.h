@@ -0,0 +1,140 @@
+#ifndef SHIPSCRIPT_H
+#define SHIPSCRIPT_H
+
+#include "Ship.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class GameManager;
+
+// One bytecode instruction: opcode and up to four register operands (the
+// fourth shares its field with jump targets)
+struct ShipInstr {
+  uint8_t op;
+  uint8_t a, b, c;
+  int32_t d;
+};
+
+/**
+ * ShipProgram struct
+ * - A ship type defined in a scenario ("shiptype" block, see README) and
+ *   compiled by ShipCatalog: its weapon and ramming rules, its upgrade and
+ *   the bytecode run by ScriptedShip::performTurn() every turn.
+ * - The VM is register based. Every operand is a slot of one register file:
+ *     r0..r15   scratch, zero at the start of every turn
+ *     s0..s7    per-ship state, kept between turns (reset on upgrade)
+ *     constants the literals of the program, filled in at compile time
+ *   so no instruction needs a register / immediate variant.
+ * - `base` is the built-in type the ship reports (getType()) to everything
+ *   keyed by type: rates, traces, telemetry, hashes.
+ */
+struct ShipProgram {
+  static const int SCRATCH_REGS = 16;
+  static const int STATE_REGS = 8;
+  static const int FIRST_STATE = SCRATCH_REGS;
+  static const int FIRST_CONST = FIRST_STATE + STATE_REGS;
+  static const int MAX_REGS = 64;
+  static const int MAX_LOOPS = 4096; // backward jumps per turn, then stop
+
+  enum Metric { CITY_BLOCK, CHEBYSHEV, ANYWHERE };
+
+  std::string name;
+  ShipType base;
+
+  // "weapon city 5 offboard damage 1"
+  bool hasWeapon;
+  Metric weaponMetric;
+  int weaponRange;
+  int weaponDamage;
+  bool weaponOffboard; // only fires while the ship is off the board
+
+  // "ramming offboard": only rams while off the board
+  bool ramOffboard;
+
+  // "upgrade 4 Destroyer" (upgradeKills 0: never)
+  int upgradeKills;
+  std::string upgradeName;
+  ShipType upgradeBase;
+  const ShipProgram *upgradeProgram; // nullptr: the built-in type
+
+  std::vector<ShipInstr> code;
+  std::vector<int32_t> frame; // initial register file (constants set)
+
+  // Worked out from the code, for sleeping and stalemate detection: the
+  // radius the ship can affect in one turn (-1 if unbounded, see
+  // ActivityMonitor::reach) and whether it can ever leave its cell
+  int reach;
+  bool stationary;
+};
+
+/**
+ * ShipCatalog class
+ * - Compiles the "shiptype" blocks of a scenario into ShipPrograms and
+ *   looks them up by name. A block named after a built-in type replaces
+ *   that type for the whole scenario, upgrades included.
+ * - Errors (unknown instruction, bad operand, missing label...) throw
+ *   std::runtime_error naming the type and the offending line.
+ * - Compiled programs never change, so copies of a catalog (forked worlds)
+ *   share them.
+ */
+class ShipCatalog {
+private:
+  std::vector<std::shared_ptr<ShipProgram>> programs;
+  const ShipProgram *overrides[SHIP_TYPE_COUNT];
+
+public:
+  ShipCatalog();
+
+  // Replace the catalog with the blocks in `text` (may be empty)
+  void compile(const std::string &text);
+  void clear();
+
+  bool empty() const { return programs.empty(); }
+  const ShipProgram *find(const std::string &name) const;
+  // The script replacing a built-in type, if any
+  const ShipProgram *find(ShipType type) const { return overrides[type]; }
+};
+
+/**
+ * ScriptedShip class
+ * - A ship whose turn is a ShipProgram, run by a threaded-dispatch
+ *   interpreter (computed goto). The instructions reuse the engine's own
+ *   operations (random draws, board scans, GameManager::applyHit / applyRam)
+ *   so a script of a built-in type plays exactly the same battle.
+ * - Upgrades work like the built-in ones: the new ship keeps symbol, team,
+ *   fleet index, lost lives and kills, and starts off the board.
+ */
+class ScriptedShip : public Ship {
+private:
+  GameManager *manager;
+  const ShipProgram *program;
+  const ShipProgram *upgradeTo;
+  int32_t state[ShipProgram::STATE_REGS];
+
+  bool fire(int targetX, int targetY);
+  bool ramAt(int targetX, int targetY);
+
+public:
+  ScriptedShip(const ShipProgram *program, const std::string &symbol,
+               const std::string &team, GameManager *mgr);
+
+  // Upgrade constructor
+  ScriptedShip(Ship &oldShip, const ShipProgram *program, GameManager *mgr);
+
+  virtual void performTurn() override;
+  virtual ShipType getType() const override { return program->base; }
+  virtual Ship *clone(GameManager *mgr) const override;
+  virtual int32_t *behaviourState(int &words) override {
+    words = ShipProgram::STATE_REGS;
+    return state;
+  }
+  virtual void recordKill() override;
+  virtual const ShipProgram *getProgram() const override { return program; }
+  virtual const ShipProgram *getUpgradeProgram() const override {
+    return upgradeTo;
+  }
+};
+
+#endif // SHIPSCRIPT_H
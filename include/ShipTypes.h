@@ -34,6 +34,9 @@ public:
   virtual void move() override;
   virtual void shoot(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return BATTLESHIP; }
+  virtual Ship *clone(GameManager *mgr) const override;
+  virtual void recordKill() override;
 };
 
 /**
@@ -55,6 +58,9 @@ public:
   virtual void move() override;
   virtual void ram(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return CRUISER; }
+  virtual Ship *clone(GameManager *mgr) const override;
+  virtual void recordKill() override;
 };
 
 /**
@@ -76,13 +82,16 @@ public:
             GameManager *mgr);
 
   // Upgrade constructor (Battleship or Cruiser => Destroyer)
-  Destroyer(const Ship &oldShip, GameManager *mgr);
+  Destroyer(Ship &oldShip, GameManager *mgr);
 
   virtual void look(int offsetX, int offsetY) override;
   virtual void move() override;
   virtual void shoot(int targetX, int targetY) override;
   virtual void ram(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return DESTROYER; }
+  virtual Ship *clone(GameManager *mgr) const override;
+  virtual void recordKill() override;
 };
 
 /**
@@ -94,10 +103,7 @@ public:
 class Frigate : public ShootingShip {
 private:
   GameManager *manager;
-  int firingIndex;
-
-  static const int SEQ_LEN = 8;
-  static const int directions[SEQ_LEN][2];
+  int32_t firingIndex; // position in WeaponPatterns::FRIGATE_SWEEP
 
 public:
   Frigate(const std::string &symbol, const std::string &team,
@@ -105,13 +111,20 @@ public:
 
   virtual void shoot(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return FRIGATE; }
+  virtual Ship *clone(GameManager *mgr) const override;
+  virtual int32_t *behaviourState(int &words) override {
+    words = 1;
+    return &firingIndex;
+  }
+  virtual void recordKill() override;
 };
 
 /**
  * Corvette:
  *  - Inherits: ShootingShip
  *  - Does not move/look
- *  - Shoots a random neighbor each turn
+ *  - Shoots a random on-board neighbor each turn
  *  - Created from scratch OR upgraded from Frigate
  */
 class Corvette : public ShootingShip {
@@ -124,10 +137,12 @@ public:
            GameManager *mgr);
 
   // upgrade constructor (Frigate => Corvette)
-  Corvette(const Ship &oldShip, GameManager *mgr);
+  Corvette(Ship &oldShip, GameManager *mgr);
 
   virtual void shoot(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return CORVETTE; }
+  virtual Ship *clone(GameManager *mgr) const override;
 };
 
 /**
@@ -148,6 +163,9 @@ public:
   virtual void move() override;
   virtual void shoot(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return AMPHIBIOUS; }
+  virtual Ship *clone(GameManager *mgr) const override;
+  virtual void recordKill() override;
 };
 
 /**
@@ -172,13 +190,25 @@ public:
             GameManager *mgr);
 
   // Upgrade
-  SuperShip(const Ship &oldShip, GameManager *mgr);
+  SuperShip(Ship &oldShip, GameManager *mgr);
 
   virtual void look(int offsetX, int offsetY) override;
   virtual void move() override;
   virtual void shoot(int targetX, int targetY) override;
   virtual void ram(int targetX, int targetY) override;
   virtual void performTurn() override;
+  virtual ShipType getType() const override { return SUPERSHIP; }
+  virtual Ship *clone(GameManager *mgr) const override;
 };
 
+/**
+ * Factory used by the scenario loaders: build a fresh ship from its type name
+ * ("Battleship", "Cruiser", ...) or its ShipType ID. Returns nullptr for an
+ * unknown type.
+ */
+Ship *createShip(const std::string &type, const std::string &symbol,
+                 const std::string &team, GameManager *mgr);
+Ship *createShip(ShipType type, const std::string &symbol,
+                 const std::string &team, GameManager *mgr);
+
 #endif // SHIPTYPES_H
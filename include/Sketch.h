@@ -0,0 +1,73 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include "Random.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * QuantileSketch class
+ * - KLL streaming quantile sketch: approximate quantiles (p50, p95, ...) of
+ *   any number of values in O(k log(n / k)) memory.
+ * - Values are kept in levels; a value at level h stands for 2^h inputs.
+ *   When the sketch is over capacity, the lowest full level is sorted and
+ *   every other value (odd or even positions, by coin flip) is promoted to
+ *   the level above, the rest dropped. Higher levels get more room than
+ *   lower ones (factor 3/2 per level).
+ * - Rank error is about 1.7 / k with high probability; k = 200 gives ~1%.
+ * - Mergeable: merge() adds another sketch's levels and compacts, so
+ *   per-thread sketches can be combined at the end. Exact min / max and
+ *   count are kept on the side.
+ */
+class QuantileSketch {
+private:
+  int k;
+  uint64_t n;
+  double minValue, maxValue;
+  std::vector<std::vector<double>> levels;
+  Random coin;
+
+  size_t capacity(size_t level) const;
+  void compress();
+
+public:
+  explicit QuantileSketch(int k = 200, uint64_t seed = 1);
+
+  void add(double value);
+  void merge(const QuantileSketch &other);
+
+  uint64_t count() const { return n; }
+  double min() const { return minValue; }
+  double max() const { return maxValue; }
+
+  // Value at rank q * count() (q in [0, 1]); 0 if empty
+  double quantile(double q) const;
+
+  // Values currently held (memory is about 8 bytes each)
+  size_t retained() const;
+};
+
+/**
+ * DistinctSketch class
+ * - HyperLogLog counter of distinct 64-bit values (e.g. state hashes) in
+ *   REGISTERS bytes, about 1.6% standard error; exact-ish for small counts
+ *   thanks to the linear-counting correction. Mergeable like the above.
+ */
+class DistinctSketch {
+public:
+  static const int INDEX_BITS = 12;
+  static const int REGISTERS = 1 << INDEX_BITS;
+
+private:
+  std::vector<uint8_t> rank;
+
+public:
+  DistinctSketch();
+
+  void add(uint64_t value);
+  void merge(const DistinctSketch &other);
+  double estimate() const;
+};
+
+#endif // SKETCH_H
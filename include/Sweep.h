@@ -0,0 +1,105 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "parseFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GameManager;
+class Scheduler;
+
+/**
+ * Parameter sweep description, read from a small keyword file:
+ *
+ *   scenario game1.txt          base scenario every variant starts from
+ *   seeds 1 2 3 4               one run per seed for every variant
+ *   iterations 20 50            (optional axes: each lists the values to try,
+ *   width 10 20                  the sweep is the cartesian product)
+ *   height 10 20
+ *   respawnsPerTurn 1 2
+ *   shipRespawns 0 3
+ *   count A Battleship 1 2 3    vary how many of a ship type a team gets
+ *   shiptypes a.txt b.txt       ship type scripts to try, each replacing the
+ *                               scenario's shiptype blocks
+ *   threads 8                   worker threads (0 = all cores)
+ *   pin 1                       pin worker i to core i
+ *   cache .sweep_cache          directory for cached results
+ *   output results.csv          CSV table (stdout if omitted)
+ */
+struct SweepSpec {
+  std::string scenarioFile;
+  std::vector<uint64_t> seeds;
+
+  std::vector<int> iterations;
+  std::vector<int> widths;
+  std::vector<int> heights;
+  std::vector<int> respawnsPerTurn;
+  std::vector<int> shipRespawns;
+
+  struct CountAxis {
+    std::string team;
+    std::string type;
+    std::vector<int> values;
+  };
+  std::vector<CountAxis> counts;
+
+  std::vector<std::string> shipTypeFiles;
+
+  int threads;
+  bool pin;
+  std::string cacheDir;
+  std::string output;
+};
+
+// What we keep from one finished battle
+struct SweepResult {
+  std::string winner;     // "-" if nobody won, "stalemate" if ended early
+  int turns;
+  std::vector<int> alive; // ships alive per team, in scenario team order
+  int kills;              // total kills over all ships
+  int typeKills[SHIP_TYPE_COUNT]; // kills by ships of each (current) type
+  bool stalemate;
+  uint64_t stateHash;     // final GameManager::stateHash() (not cached)
+};
+
+/**
+ * SweepRunner class
+ * - Expands a SweepSpec into GameConfig variants x seeds.
+ * - Runs them in parallel on the given Scheduler, each game silenced and
+ *   seeded on its own.
+ * - Results are cached on disk under a hash of
+ *   (canonical config text, seed, ENGINE_VERSION), so reruns and
+ *   overlapping sweeps skip work that is already done.
+ */
+class SweepRunner {
+public:
+  SweepSpec parseSpec(const std::string &filename);
+
+  // Run the sweep and write the results table. Returns a process exit code.
+  int run(const SweepSpec &spec, Scheduler &scheduler);
+
+  // Play one seeded game quietly and summarise it
+  static SweepResult playGame(const GameConfig &config,
+                              const std::vector<std::string> &teams);
+
+  // Outcome of the game a manager has just played
+  static SweepResult summarise(const GameManager &manager,
+                               const std::vector<std::string> &teams);
+
+  // Team names in the order they first appear in the scenario
+  static std::vector<std::string> teamsOf(const GameConfig &config);
+
+  // 64-bit FNV-1a of (config text, seed, engine version)
+  static uint64_t scenarioHash(const std::string &configText, uint64_t seed);
+
+private:
+  std::vector<GameConfig> expandVariants(const SweepSpec &spec,
+                                         const GameConfig &base) const;
+  bool loadCached(const std::string &dir, uint64_t key, size_t teamCount,
+                  SweepResult &result) const;
+  void storeCached(const std::string &dir, uint64_t key,
+                   const SweepResult &result) const;
+};
+
+#endif // SWEEP_H
@@ -0,0 +1,80 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "GameManager.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * TelemetryWriter class
+ * - Records one row per ship per turn (turn, ship, x, y, lives, kills, type,
+ *   events) into a binary column file for offline analysis, instead of
+ *   scraping the text log.
+ * - Rows are buffered per column in chunks of CHUNK_ROWS. A full chunk is
+ *   encoded and written straight away, so memory stays the same however
+ *   long the run is.
+ * - Encoding, per column and chunk: a delta (turn and ship: to the previous
+ *   row; the others: to the same ship's previous row), zigzag,
+ *   then bit-packed in blocks of BLOCK_ROWS values, each block with its own
+ *   bit width. Rows are turn-major, so turn and ship deltas are 0 / 1 and a
+ *   ship's values barely change between turns: most blocks take 0-2 bits
+ *   per value. The per-ship bases carry across chunks, so files are
+ *   decoded front to back.
+ *
+ *   File:   "WSTELEM\0", uint32 version, uint32 ship count,
+ *           per ship: uint16 length + symbol, uint16 length + team,
+ *           then chunks until the end of the file
+ *   Chunk:  uint32 rows, then per column: uint32 bytes + packed blocks
+ *   Block:  uint8 bit width, then ceil(values * width / 8) bytes
+ *
+ * - Ship ids are indices into GameManager::getShips() (an upgraded ship
+ *   keeps its id). Ships off the board have x = y = -1.
+ */
+class TelemetryWriter : public TurnObserver {
+public:
+  static const uint32_t VERSION = 1;
+  static const size_t CHUNK_ROWS = 1 << 16;
+  static constexpr size_t BLOCK_ROWS = 128;
+
+  enum Column { TURN, SHIP, X, Y, LIVES, KILLS, TYPE, EVENTS, COLUMNS };
+  static const char *columnName(int column);
+
+  // Bits of the EVENTS column, against the ship's previous row
+  enum Event { EVENT_UPGRADED = 1, EVENT_SUNK = 2, EVENT_RESPAWNED = 4 };
+
+private:
+  std::ofstream file;
+  bool headerWritten;
+  std::vector<int32_t> columns[COLUMNS]; // current chunk
+  std::vector<uint8_t> packed;           // encode buffer, reused
+  std::vector<int32_t> shipPrev;         // per-ship delta bases
+
+  // Previous row per ship, for the events column
+  std::vector<int32_t> lastType, lastLives, lastRespawns;
+
+  uint64_t rowsWritten, bytesWritten;
+
+  void writeHeader(const GameManager &manager);
+  void flushChunk();
+
+public:
+  explicit TelemetryWriter(const std::string &path);
+  ~TelemetryWriter();
+
+  void turnEnded(const GameManager &manager, int turn) override;
+
+  // Write the partial chunk (also done by the destructor)
+  void finish();
+
+  uint64_t getRows() const { return rowsWritten; }
+  uint64_t getBytes() const { return bytesWritten; }
+
+  // Decode a telemetry file back to CSV, one line per row
+  static void dump(const std::string &path, std::ostream &out);
+};
+
+#endif // TELEMETRY_H
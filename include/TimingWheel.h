@@ -0,0 +1,60 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * TimingWheel class
+ * - Hierarchical timing wheel of integer items (e.g. ship indices) due at a
+ *   given tick: LEVELS wheels of SLOTS slots, level L slot s holding the
+ *   items whose tick differs from now only below bit 8 * (L + 1) and whose
+ *   level-L digit is s.
+ * - schedule() is O(1): the level comes from the highest bit in which the
+ *   tick differs from now. advance() moves one tick; when a lower wheel
+ *   wraps around, the matching slot of the wheel above is cascaded down.
+ *   A tick with nothing due costs a few index checks, however many items
+ *   wait further ahead.
+ * - Each slot is an intrusive FIFO list (one next link per item), so an
+ *   item may be scheduled at most once at a time and there is nothing to
+ *   allocate once resize() has run.
+ * - Ticks more than 2^32 ahead wait in the top wheel and are cascaded
+ *   around again until they are in range.
+ */
+class TimingWheel {
+public:
+  static const int LEVELS = 4;
+  static const int SLOT_BITS = 8;
+  static const int SLOTS = 1 << SLOT_BITS;
+
+private:
+  uint64_t now;
+  size_t count;
+
+  std::vector<int32_t> next; // per item, -1 = end of list
+  std::vector<uint64_t> due; // per item
+  int32_t head[LEVELS][SLOTS];
+  int32_t tail[LEVELS][SLOTS];
+
+  void place(int32_t item);
+  void cascade(int level);
+
+public:
+  TimingWheel();
+
+  // Room for items 0 .. items - 1, everything unscheduled, now = `start`
+  void reset(size_t items, uint64_t start = 0);
+
+  uint64_t getNow() const { return now; }
+  size_t size() const { return count; }
+
+  // Item is due at `tick` (ticks not after now are due on the next one)
+  void schedule(int32_t item, uint64_t tick);
+
+  // Step to now + 1 and append the items due then to `out`
+  void advance(std::pmr::vector<int32_t> &out);
+};
+
+#endif // TIMINGWHEEL_H
@@ -0,0 +1,71 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "GameManager.h"
+#include "parseFile.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Golden traces
+ * - `warship_sim trace <scenario> --seed N` plays a battle silently and
+ *   prints the world after every turn: one hash line per turn, then one line
+ *   per ship (cell, symbol, team, type, lives, kills, respawns), sorted by
+ *   cell. Ships that are not on the board are listed last with "- -".
+ *
+ *     trace 3 1                          engine version, seed
+ *     turn 1 9c3e01f2a7b45d10 57         turn, world hash, RNG draws so far
+ *     0 3 *1 A Battleship 3 0 0
+ *     - - $2 A Cruiser 0 0 1
+ *
+ * - With `--golden FILE` the battle is compared against a stored trace
+ *   instead and the first divergent turn and cell are reported (exit 1).
+ *   `make trace-golden` records traces for the sample scenarios and the
+ *   generated ones, `make trace-check` compares against them; record on a
+ *   known-good build, check after a change that must not alter battles.
+ * - The scenario "gen:K" is generated from K (board size, islands, fleets,
+ *   limits, layout, combat mode), so many shapes of battle are covered
+ *   without keeping scenario files around.
+ */
+class TraceRecorder : public TurnObserver {
+public:
+  struct Entry {
+    int x, y; // -1 if not on the board
+    std::string text;
+  };
+
+  struct Turn {
+    int turn;
+    uint64_t hash;
+    uint64_t rngCounter;
+    std::vector<Entry> entries;
+  };
+
+private:
+  std::vector<Turn> turns;
+
+public:
+  void turnEnded(const GameManager &manager, int turn) override;
+
+  const std::vector<Turn> &getTurns() const { return turns; }
+
+  void write(std::ostream &out, uint64_t seed) const;
+
+  // Read a trace written by write() (throws std::runtime_error if malformed)
+  static std::vector<Turn> read(std::istream &in, int &engine);
+
+  // Empty if the traces match, else where and how they first differ
+  static std::string compare(const std::vector<Turn> &golden,
+                             const std::vector<Turn> &actual);
+};
+
+// Deterministic scenario for "gen:K"
+GameConfig generateScenario(uint64_t k);
+
+// The trace subcommand; returns a process exit code
+int runTrace(const std::string &scenario, uint64_t seed, bool hasSeed,
+             const std::string &goldenFile);
+
+#endif // TRACE_H
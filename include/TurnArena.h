@@ -0,0 +1,63 @@
+#ifndef TURNARENA_H
+#define TURNARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * TurnArena class
+ * - Monotonic memory for data that lives for one turn (ships due, touched
+ *   lists, and whatever later turn steps need), as a std::pmr resource:
+ *   containers built with it allocate by bumping a pointer, and
+ *   deallocation does nothing.
+ * - reset() frees everything at once by rewinding to the first block. The
+ *   blocks themselves are kept, so after the first few turns the arena
+ *   never goes back to the heap.
+ * - A destroyed arena leaves its blocks to a small per-thread spare list
+ *   and new arenas start from it. A worker thread that plays one game after
+ *   another therefore keeps reusing the same memory.
+ * - Containers must not outlive the next reset(): drop (or re-create) them
+ *   first.
+ */
+class TurnArena : public std::pmr::memory_resource {
+public:
+  static const size_t MIN_BLOCK = 64 * 1024;
+
+private:
+  struct Block {
+    char *data;
+    size_t size;
+  };
+
+  std::vector<Block> blocks; // in use order; all kept across resets
+  size_t current;            // block being bumped
+  size_t offset;             // next free byte in it
+  size_t used, peak;         // bytes handed out since reset / ever
+
+  void nextBlock(size_t bytes, size_t alignment);
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+public:
+  TurnArena();
+  ~TurnArena();
+
+  TurnArena(const TurnArena &) = delete;
+  TurnArena &operator=(const TurnArena &) = delete;
+
+  // Forget every allocation; keeps the blocks
+  void reset();
+
+  size_t bytesUsed() const { return used; }
+  size_t peakBytes() const { return peak; }
+  size_t capacity() const;
+};
+
+#endif // TURNARENA_H
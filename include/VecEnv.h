@@ -0,0 +1,90 @@
+#ifndef VECENV_H
+#define VECENV_H
+
+#include "GameManager.h"
+#include "parseFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * VecEnv class
+ * - K copies of one scenario driven from outside, one turn per step(), for
+ *   training ship policies:
+ *
+ *     VecEnv env(config, 64);
+ *     std::vector<float> obs(env.envCount() * env.observationSize());
+ *     std::vector<float> rewards(env.envCount() * env.teamCount());
+ *     std::vector<uint8_t> dones(env.envCount());
+ *     env.reset(seeds);
+ *     env.observe(obs.data());
+ *     env.step(actions, VecEnv::PER_SHIP, rewards.data(), dones.data());
+ *
+ * - Actions are ShipAction values (GameManager.h), laid out [env][ship] in
+ *   fleet order (PER_SHIP) or [env][team] in team order (PER_TEAM).
+ *   ACTION_AUTO keeps the ship's own behaviour. HOLD and the plain steps
+ *   replace the whole turn, shot included; ACTION_ATTACK and the
+ *   step-then-attack actions keep the ship's own shots and rams and only
+ *   take its movement out of its hands.
+ * - Observations are float32 [env][channel][row][column]:
+ *     channel 0          terrain (1 = island)
+ *     channel 1 + t      live ships of team t
+ *     channel 1 + teams  lives of the ship there / DEFAULT_LIVES
+ * - Rewards are [env][team]: +1 for each enemy ship sunk during the step,
+ *   -1 for each own ship lost. An env is done after a victory or its last
+ *   turn; it then ignores steps until it is reset.
+ * - All output goes into caller-owned buffers. After reset(), step() and
+ *   observe() allocate nothing.
+ */
+class VecEnv {
+public:
+  enum ActionMode { PER_SHIP, PER_TEAM };
+
+private:
+  GameConfig config;
+  std::vector<std::string> teams;
+  std::vector<int> shipTeam; // per ship, in fleet order
+  int ships;
+  int width, height;
+
+  std::vector<std::unique_ptr<GameManager>> managers;
+  std::vector<int> turn;
+  std::vector<uint8_t> finished;
+
+  // Scratch, sized once: per-ship actions and alive flags of one env
+  std::vector<int8_t> actionScratch;
+  std::vector<uint8_t> aliveBefore;
+  std::vector<float> terrainPlane;
+
+public:
+  VecEnv(const GameConfig &config, int envs);
+
+  int envCount() const { return static_cast<int>(managers.size()); }
+  int shipCount() const { return ships; }
+  int teamCount() const { return static_cast<int>(teams.size()); }
+  int channelCount() const { return 2 + teamCount(); }
+  // Floats per env in observe()
+  size_t observationSize() const {
+    return static_cast<size_t>(channelCount()) * width * height;
+  }
+
+  // Start every env over with its own seed (seeds[envCount()])
+  void reset(const uint64_t *seeds);
+  void resetEnv(int env, uint64_t seed);
+
+  // One turn in every env that is not done
+  void step(const int8_t *actions, ActionMode mode, float *rewards,
+            uint8_t *dones);
+
+  // obs[envCount() * observationSize()]
+  void observe(float *obs) const;
+
+  const GameManager &manager(int env) const { return *managers[env]; }
+};
+
+// `warship_sim bench-env`: steps per second with built-in behaviour
+int runEnvBench(const GameConfig &config, int envs, int steps);
+
+#endif // VECENV_H
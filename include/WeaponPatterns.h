@@ -0,0 +1,154 @@
+#ifndef WEAPONPATTERNS_H
+#define WEAPONPATTERNS_H
+
+#include "Constants.h"
+#include "Random.h"
+
+/**
+ * Weapon patterns
+ * - Every footprint a ship aims with, generated at compile time as a flat
+ *   array of (dx, dy) offsets from the ship:
+ *     DIAMOND_5      city-block distance 1..5 (Battleship, Destroyer,
+ *                    Amphibious), 60 cells
+ *     RING_1         the 8 neighbours, in the order the neighbour scans
+ *                    have always used (Cruiser, Destroyer, SuperShip)
+ *     FRIGATE_SWEEP  the Frigate's fixed clockwise firing sequence
+ *     boardCell()    any cell of the board (SuperShip)
+ * - A random target is one draw, sample(pattern, rng). This
+ *   replaces rejection loops that drew from an 11x11 box and threw away
+ *   about half of the draws. The distribution is the same (uniform).
+ * - clip() keeps only the offsets that stay on the board for a given cell.
+ *   The ring's 16 edge cases are precomputed in RING_1_CLIPPED, see
+ *   clippedRing1(); bigger patterns can be clipped on demand.
+ */
+namespace WeaponPatterns {
+
+struct Offset {
+  int dx = 0;
+  int dy = 0;
+};
+
+template <int N> struct Pattern {
+  Offset cells[N];
+  int size = 0;
+
+  constexpr const Offset &operator[](int i) const { return cells[i]; }
+  constexpr void add(int dx, int dy) {
+    cells[size].dx = dx;
+    cells[size].dy = dy;
+    size++;
+  }
+};
+
+constexpr int absValue(int v) { return v < 0 ? -v : v; }
+constexpr int maxValue(int a, int b) { return a > b ? a : b; }
+
+// City-block distance 1..R (the ship's own cell excluded)
+constexpr int diamondSize(int r) { return 2 * r * (r + 1); }
+
+template <int R> constexpr Pattern<diamondSize(R)> makeDiamond() {
+  Pattern<diamondSize(R)> p;
+  for (int dx = -R; dx <= R; dx++) {
+    for (int dy = -R; dy <= R; dy++) {
+      int d = absValue(dx) + absValue(dy);
+      if (d >= 1 && d <= R)
+        p.add(dx, dy);
+    }
+  }
+  return p;
+}
+
+// Chebyshev distance exactly R
+constexpr int ringSize(int r) { return 8 * r; }
+
+template <int R> constexpr Pattern<ringSize(R)> makeRing() {
+  Pattern<ringSize(R)> p;
+  for (int dx = -R; dx <= R; dx++) {
+    for (int dy = -R; dy <= R; dy++) {
+      if (maxValue(absValue(dx), absValue(dy)) == R)
+        p.add(dx, dy);
+    }
+  }
+  return p;
+}
+
+constexpr Pattern<8> makeFrigateSweep() {
+  // North first, then clockwise
+  Pattern<8> p;
+  p.add(-1, 0);
+  p.add(-1, 1);
+  p.add(0, 1);
+  p.add(1, 1);
+  p.add(1, 0);
+  p.add(1, -1);
+  p.add(0, -1);
+  p.add(-1, -1);
+  return p;
+}
+
+/**
+ * The offsets of `p` that stay on the board for a cell with `up` rows above
+ * it, `down` rows below, `left` / `right` columns beside it (order kept).
+ */
+template <int N>
+constexpr Pattern<N> clip(const Pattern<N> &p, int up, int down, int left,
+                          int right) {
+  Pattern<N> out;
+  for (int i = 0; i < p.size; i++) {
+    const Offset &o = p.cells[i];
+    if (o.dx >= -up && o.dx <= down && o.dy >= -left && o.dy <= right)
+      out.add(o.dx, o.dy);
+  }
+  return out;
+}
+
+constexpr auto DIAMOND_5 = makeDiamond<MAX_WEAPON_REACH>();
+constexpr auto RING_1 = makeRing<1>();
+constexpr auto FRIGATE_SWEEP = makeFrigateSweep();
+
+static_assert(DIAMOND_5.size == diamondSize(MAX_WEAPON_REACH),
+              "diamond generator");
+static_assert(RING_1.size == 8 && RING_1[0].dx == -1 && RING_1[0].dy == -1 &&
+                  RING_1[7].dx == 1 && RING_1[7].dy == 1,
+              "ring order must match the neighbour scans");
+
+// RING_1 clipped for every edge case: index = up + 2*down + 4*left + 8*right
+// where each term is 1 if the cell has room on that side
+struct ClippedRing {
+  Pattern<8> variant[16];
+};
+
+constexpr ClippedRing makeClippedRing() {
+  ClippedRing t;
+  for (int k = 0; k < 16; k++) {
+    t.variant[k] =
+        clip(RING_1, k & 1, (k >> 1) & 1, (k >> 2) & 1, (k >> 3) & 1);
+  }
+  return t;
+}
+
+constexpr ClippedRing RING_1_CLIPPED = makeClippedRing();
+
+// The neighbours of (x, y) that are on a height x width board
+inline const Pattern<8> &clippedRing1(int x, int y, int height, int width) {
+  int k = (x > 0) | ((x < height - 1) << 1) | ((y > 0) << 2) |
+          ((y < width - 1) << 3);
+  return RING_1_CLIPPED.variant[k];
+}
+
+// One uniformly chosen offset (the pattern must not be empty)
+template <int N> inline const Offset &sample(const Pattern<N> &p, Random &rng) {
+  return p[rng.nextInt(p.size)];
+}
+
+// Whole board: one draw per axis is already uniform, rows first
+inline Offset boardCell(Random &rng, int height, int width) {
+  Offset o;
+  o.dx = rng.nextInt(height);
+  o.dy = rng.nextInt(width);
+  return o;
+}
+
+} // namespace WeaponPatterns
+
+#endif // WEAPONPATTERNS_H
@@ -0,0 +1,48 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Zobrist keys for world-state hashing
+ * - The state hash is the XOR of one key per occupied cell (cell, ship type,
+ *   team, lives) and one key per ship waiting in the respawn queue, so a
+ *   move, a hit or a queue change updates it with a couple of XORs.
+ * - Boards can be huge, so the keys are not a random table: each key is a
+ *   strong 64-bit mix of its inputs, computed when needed.
+ * - Cells are numbered x * width + y whatever the storage layout, so the
+ *   same world hashes the same in every layout and in both engines.
+ */
+namespace Zobrist {
+
+// SplitMix64 finaliser
+inline uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// FNV-1a of the team name, computed once per ship
+inline uint64_t teamKey(const std::string &team) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (unsigned char c : team) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+inline uint64_t cellKey(uint64_t cell, int type, uint64_t team, int lives) {
+  uint64_t ship = mix(team + (static_cast<uint64_t>(type) << 32) +
+                      static_cast<uint32_t>(lives));
+  return mix(cell * 0x9e3779b97f4a7c15ULL ^ ship);
+}
+
+inline uint64_t queueKey(int fleetIndex) {
+  return mix(0x51ed270b2701ccd5ULL + static_cast<uint64_t>(fleetIndex));
+}
+
+} // namespace Zobrist
+
+#endif // ZOBRIST_H
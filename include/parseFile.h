@@ -1,7 +1,10 @@
 #ifndef PARSEFILE_H
 #define PARSEFILE_H
 
-#include "GameManager.h"
+#include "Battlefield.h"
+#include "Combat.h"
+#include "Ship.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -11,8 +14,19 @@ struct GameConfig {
   int width;
   int height;
 
-  // For battlefield
-  int terrainGrid[10][10]; // or dynamically allocated if width/height vary
+  // Respawn limits ("respawnsPerTurn 2", "shipRespawns 3")
+  int respawnsPerTurn;
+  int shipRespawns;
+
+  // "seed 42" makes the run reproducible; otherwise the clock is used
+  bool hasSeed;
+  uint64_t seed;
+
+  // For battlefield: only island cells are stored, so huge mostly-water
+  // oceans stay cheap to describe
+  std::vector<Position> islands;
+  Battlefield::Layout layout; // "layout dense" (default), tiled, morton, chunked
+  CombatBuffer::Mode combat;  // "combat immediate" (default) or "combat batched"
 
   // For teams and ships
   struct ShipInfo {
@@ -24,6 +38,29 @@ struct GameConfig {
 
   // Collection of all ships to create
   std::vector<ShipInfo> allShips;
+
+  // "rate Battleship 2 1" => Battleships act every 2nd turn, initiative 1.
+  // Any rate line switches the battle to the scheduled turn order (see
+  // GameManager::setActionRate); types without one act every turn.
+  struct RateInfo {
+    std::string type; // e.g. "Battleship"
+    int period;       // turns between actions, >= 1
+    int initiative;   // higher acts first within a turn, default 0
+  };
+  std::vector<RateInfo> rates;
+
+  // "activity sleep": ships with no enemy in reach sleep until one comes
+  // near ("activity always", the default: every ship acts every turn)
+  bool sleeping;
+
+  // "stalemate 50": end the battle early once it cannot progress, at the
+  // latest after 50 turns without a hit (0, the default: never)
+  int stalemateWindow;
+
+  // Scripted ship types: "shiptype NAME [like TYPE]" ... "end" blocks,
+  // inline or from "shiptypes FILE", kept as canonical text (see
+  // ShipCatalog). Fleets use the names like built-in types.
+  std::string shipTypes;
 };
 
 /**
@@ -36,6 +73,16 @@ public:
 
   // Parse the file and fill a GameConfig structure
   GameConfig parseFile(const std::string &filename);
+
+  // Parse scenario text that is already in memory
+  GameConfig parseStream(std::istream &in);
+
+  // Canonical "shiptype" blocks of a side file (checked by compiling them)
+  std::string loadShipTypes(const std::string &filename) const;
+
+  // Write a config back out as scenario text (islands as "island" lines).
+  // The output is canonical, so it doubles as a cache / hash key.
+  std::string serialize(const GameConfig &config) const;
 };
 
 #endif // PARSEFILE_H
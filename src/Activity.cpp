@@ -0,0 +1,127 @@
+#include "Activity.h"
+#include "ShipScript.h"
+#include <algorithm>
+
+int ActivityMonitor::reach(ShipType type) {
+  switch (type) {
+  case BATTLESHIP:
+  case DESTROYER:
+  case AMPHIBIOUS:
+    return 6; // one step, then a city-block 5 diamond
+  case CRUISER:
+  case FRIGATE:
+  case CORVETTE:
+    return 1; // rams / shoots a neighbour (the Cruiser rams before moving)
+  default:
+    return -1; // SuperShip: three shots anywhere on the board
+  }
+}
+
+ActivityMonitor::ActivityMonitor()
+    : battlefield(nullptr), teamOf(nullptr), tileCols(0), sleeperCount(0) {}
+
+void ActivityMonitor::reset(const Battlefield &bf,
+                            const std::vector<int> &teams) {
+  battlefield = &bf;
+  teamOf = &teams;
+  tileCols = ((bf.getWidth() - 1) >> TILE_BITS) + 1;
+  watches.clear();
+  generation.assign(teams.size(), 0);
+  asleep.assign(teams.size(), 0);
+  woken.clear();
+  sleeperCount = 0;
+}
+
+void ActivityMonitor::forkFrom(const ActivityMonitor &other,
+                               const Battlefield &bf,
+                               const std::vector<int> &teams) {
+  battlefield = &bf;
+  teamOf = &teams;
+  tileCols = other.tileCols;
+  watches = other.watches;
+  generation = other.generation;
+  asleep = other.asleep;
+  woken = other.woken;
+  sleeperCount = other.sleeperCount;
+}
+
+bool ActivityMonitor::enemyWithin(int x, int y, int radius, int team) const {
+  const Battlefield &bf = *battlefield;
+  int x0 = std::max(0, x - radius);
+  int x1 = std::min(bf.getHeight() - 1, x + radius);
+  int y0 = std::max(0, y - radius);
+  int y1 = std::min(bf.getWidth() - 1, y + radius);
+  for (int cx = x0; cx <= x1; cx++) {
+    for (int cy = y0; cy <= y1; cy++) {
+      const Ship *o = bf.getOccupant(cx, cy);
+      if (o && o->isAlive() && (*teamOf)[o->getFleetIndex()] != team) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool ActivityMonitor::trySleep(const Ship *s) {
+  const ShipProgram *program = s->getProgram();
+  int radius = program ? program->reach : reach(s->getType());
+  Position p = s->getPosition();
+  int i = s->getFleetIndex();
+  if (radius < 0 || !battlefield->inBounds(p.x, p.y) ||
+      s->getPendingUpgradeType() != SHIP_NONE ||
+      enemyWithin(p.x, p.y, radius, (*teamOf)[i])) {
+    return false;
+  }
+
+  asleep[i] = 1;
+  generation[i]++;
+  sleeperCount++;
+  int tx0 = std::max(0, p.x - radius) >> TILE_BITS;
+  int tx1 = std::min(battlefield->getHeight() - 1, p.x + radius) >> TILE_BITS;
+  int ty0 = std::max(0, p.y - radius) >> TILE_BITS;
+  int ty1 = std::min(battlefield->getWidth() - 1, p.y + radius) >> TILE_BITS;
+  for (int tx = tx0; tx <= tx1; tx++) {
+    for (int ty = ty0; ty <= ty1; ty++) {
+      uint64_t tile = static_cast<uint64_t>(tx) * tileCols + ty;
+      watches[tile].push_back(Watch{i, generation[i]});
+    }
+  }
+  return true;
+}
+
+void ActivityMonitor::wake(int32_t ship) {
+  if (!asleep[ship])
+    return;
+  asleep[ship] = 0;
+  sleeperCount--;
+  woken.push_back(ship);
+}
+
+void ActivityMonitor::cellOccupied(int x, int y, Ship *ship) {
+  if (sleeperCount == 0 || !battlefield->inBounds(x, y))
+    return;
+  uint64_t tile =
+      static_cast<uint64_t>(x >> TILE_BITS) * tileCols + (y >> TILE_BITS);
+  auto it = watches.find(tile);
+  if (it == watches.end())
+    return;
+
+  // Wake the enemies of the newcomer, keep its sleeping friends, drop the
+  // stale entries
+  int team = (*teamOf)[ship->getFleetIndex()];
+  std::vector<Watch> &list = it->second;
+  size_t kept = 0;
+  for (const Watch &w : list) {
+    if (!asleep[w.ship] || generation[w.ship] != w.generation)
+      continue;
+    if ((*teamOf)[w.ship] != team) {
+      wake(w.ship);
+    } else {
+      list[kept++] = w;
+    }
+  }
+  list.resize(kept);
+  if (kept == 0) {
+    watches.erase(it);
+  }
+}
@@ -0,0 +1,100 @@
+#include "AllocAudit.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+#ifdef ALLOC_AUDIT
+thread_local AllocAudit::Phase currentPhase = AllocAudit::UNTRACKED;
+#endif
+
+std::atomic<std::size_t> allocCount[AllocAudit::PHASE_COUNT];
+std::atomic<std::size_t> allocBytes[AllocAudit::PHASE_COUNT];
+
+} // namespace
+
+namespace AllocAudit {
+
+const char *phaseName(Phase phase) {
+  switch (phase) {
+  case RESPAWNS:
+    return "processRespawns";
+  case TURN:
+    return "executeTurn";
+  case UPGRADES:
+    return "handleUpgrades";
+  default:
+    return "untracked";
+  }
+}
+
+bool enabled() {
+#ifdef ALLOC_AUDIT
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::size_t allocations(Phase phase) { return allocCount[phase].load(); }
+
+std::size_t bytes(Phase phase) { return allocBytes[phase].load(); }
+
+void reset() {
+  for (int p = 0; p < PHASE_COUNT; p++) {
+    allocCount[p] = 0;
+    allocBytes[p] = 0;
+  }
+}
+
+bool report(std::ostream &out) {
+  if (!enabled()) {
+    out << "Allocation audit: not compiled in (build with `make audit`)\n";
+    return true;
+  }
+  bool clean = true;
+  out << "Allocation audit:\n";
+  for (int p = 0; p < PHASE_COUNT; p++) {
+    Phase phase = static_cast<Phase>(p);
+    out << "  " << phaseName(phase) << ": " << allocations(phase)
+        << " allocations, " << bytes(phase) << " bytes\n";
+    if (phase != UNTRACKED && allocations(phase) > 0)
+      clean = false;
+  }
+  out << (clean ? "  turn loop is allocation-free\n"
+                : "  FAILED: the turn loop allocated\n");
+  return clean;
+}
+
+#ifdef ALLOC_AUDIT
+Scope::Scope(Phase phase) : previous(currentPhase) { currentPhase = phase; }
+
+Scope::~Scope() { currentPhase = previous; }
+#endif
+
+} // namespace AllocAudit
+
+#ifdef ALLOC_AUDIT
+
+// Counting replacements for the global allocation functions. The nothrow
+// and array forms in libstdc++ forward to these.
+void *operator new(std::size_t size) {
+  AllocAudit::Phase phase = currentPhase;
+  allocCount[phase].fetch_add(1, std::memory_order_relaxed);
+  allocBytes[phase].fetch_add(size, std::memory_order_relaxed);
+
+  void *p = std::malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+#endif // ALLOC_AUDIT
@@ -1,56 +1,256 @@
 #include "Battlefield.h"
+#include "Journal.h"
 #include "Ship.h"
-#include <cstdlib> // For rand(), srand()
-#include <ctime>   // For time()
+#include "Zobrist.h"
+#include <algorithm>
 #include <iostream>
 
 // Constructor
-Battlefield::Battlefield() {
-  // Initialize terrain and occupant arrays
-  for (int x = 0; x < HEIGHT; x++) {
-    for (int y = 0; y < WIDTH; y++) {
-      terrain[x][y] = 0;        // default: water
-      occupant[x][y] = nullptr; // no ship
+Battlefield::Battlefield()
+    : width(0), height(0), layout(DENSE), shape(SHAPE_GENERIC),
+      tilesPerRow(0), watcher(nullptr), journal(nullptr),
+      stateHash(0) {
+  // Default board matches the classic 10x10 assignment map
+  resize(WIDTH, HEIGHT, DENSE);
+}
+
+void Battlefield::resize(int newWidth, int newHeight, Layout newLayout) {
+  width = newWidth;
+  height = newHeight;
+  layout = newLayout;
+  stateHash = 0; // no occupants
+
+  // Use the size-specialised kernels when the board is one we compiled for
+  shape = SHAPE_GENERIC;
+  if (layout == DENSE && width == height) {
+    if (width == 10)
+      shape = SHAPE_10;
+    else if (width == 32)
+      shape = SHAPE_32;
+    else if (width == 64)
+      shape = SHAPE_64;
+    else if (width == 256)
+      shape = SHAPE_256;
+  }
+
+  if (layout == CHUNKED) {
+    // Drop any dense arrays so memory really scales with active area
+    std::vector<unsigned char>().swap(terrain);
+    std::vector<Ship *>().swap(occupant);
+    chunked.resize(width, height);
+  } else {
+    // Sentinel ring first, then the board itself is water
+    int paddedWidth = width + 2 * BOARD_BORDER;
+    int paddedHeight = height + 2 * BOARD_BORDER;
+    size_t padded = static_cast<size_t>(paddedWidth) * paddedHeight;
+    if (layout == TILED) {
+      // Round both sides up to whole 8x8 tiles
+      const int tile = 1 << BoardKernels::TILE_SHIFT;
+      tilesPerRow = (paddedWidth + tile - 1) / tile;
+      int tileRows = (paddedHeight + tile - 1) / tile;
+      padded = static_cast<size_t>(tilesPerRow) * tileRows * tile * tile;
+    } else if (layout == MORTON) {
+      padded = allocateMorton(paddedWidth, paddedHeight);
+    }
+    terrain.assign(padded, CELL_OUTSIDE);
+    occupant.assign(padded, nullptr);
+    for (int x = 0; x < height; x++) {
+      for (int y = 0; y < width; y++) {
+        terrain[cellIndex(x, y)] = CELL_WATER;
+      }
+    }
+    chunked.resize(0, 0);
+  }
+}
+
+size_t Battlefield::allocateMorton(int paddedWidth, int paddedHeight) {
+  // Z-order inside square blocks, blocks in row-major order. A block side is
+  // the shorter padded side rounded up to a power of two, at most
+  // MORTON_BLOCK, so memory stays within a block's rounding of the padded
+  // area instead of squaring up to the next power of two of each axis.
+  int shorter = std::min(paddedWidth, paddedHeight);
+  int bits = 0;
+  while ((1 << bits) < shorter && (1 << bits) < MORTON_BLOCK)
+    bits++;
+  int side = 1 << bits;
+  size_t blockCells = static_cast<size_t>(side) * side;
+  int blocksPerRow = (paddedWidth + side - 1) / side;
+  int blockRows = (paddedHeight + side - 1) / side;
+
+  // Row bit b goes to 2b + 1, column bit b to 2b
+  auto spread = [bits](int value, int lane) {
+    unsigned out = 0;
+    for (int b = 0; b < bits; b++) {
+      if ((value >> b) & 1)
+        out |= 1u << (2 * b + lane);
+    }
+    return out;
+  };
+
+  // The block offsets are folded into the tables: index = row + column
+  mortonRow.resize(paddedHeight);
+  mortonCol.resize(paddedWidth);
+  for (int r = 0; r < paddedHeight; r++) {
+    mortonRow[r] = static_cast<unsigned>((r >> bits) * blocksPerRow *
+                                         blockCells) +
+                   spread(r & (side - 1), 1);
+  }
+  for (int c = 0; c < paddedWidth; c++) {
+    mortonCol[c] =
+        static_cast<unsigned>((c >> bits) * blockCells) +
+        spread(c & (side - 1), 0);
+  }
+  return static_cast<size_t>(blockRows) * blocksPerRow * blockCells;
+}
+
+const char *Battlefield::layoutName(Layout l) {
+  switch (l) {
+  case TILED:
+    return "tiled";
+  case MORTON:
+    return "morton";
+  case CHUNKED:
+    return "chunked";
+  default:
+    return "dense";
+  }
+}
+
+bool Battlefield::parseLayout(const std::string &name, Layout &out) {
+  const Layout all[] = {DENSE, TILED, MORTON, CHUNKED};
+  for (Layout l : all) {
+    if (name == layoutName(l)) {
+      out = l;
+      return true;
     }
   }
-  // Initialize random seed once (optional, can do in main)
-  std::srand((unsigned)std::time(nullptr));
+  return false;
 }
 
-void Battlefield::setTerrain(const int newGrid[HEIGHT][WIDTH]) {
-  for (int x = 0; x < HEIGHT; x++) {
-    for (int y = 0; y < WIDTH; y++) {
-      terrain[x][y] = newGrid[x][y];
-      occupant[x][y] = nullptr; // reset occupant
+void Battlefield::setTerrain(const std::vector<Position> &islands) {
+  // reset occupant and terrain, keep the current size / layout
+  resize(width, height, layout);
+  for (const Position &p : islands) {
+    if (!inBounds(p.x, p.y))
+      continue;
+    if (layout == CHUNKED) {
+      chunked.setIsland(p.x, p.y, true);
+    } else {
+      terrain[cellIndex(p.x, p.y)] = CELL_ISLAND;
     }
   }
+  if (layout == CHUNKED) {
+    chunked.compactTerrain();
+  }
 }
 
-bool Battlefield::isIsland(int x, int y) const {
-  // Make sure x,y are in bounds if used externally
-  return (terrain[x][y] == 1);
+void Battlefield::setTerrain(const IslandRun *runs, size_t count) {
+  resize(width, height, layout);
+  for (size_t i = 0; i < count; i++) {
+    const IslandRun &run = runs[i];
+    for (int y = run.col; y < run.col + run.length; y++) {
+      if (!inBounds(run.row, y))
+        continue;
+      if (layout == CHUNKED) {
+        chunked.setIsland(run.row, y, true);
+      } else {
+        terrain[cellIndex(run.row, y)] = CELL_ISLAND;
+      }
+    }
+  }
+  if (layout == CHUNKED) {
+    chunked.compactTerrain();
+  }
 }
 
-bool Battlefield::isOccupied(int x, int y) const {
-  return (occupant[x][y] != nullptr);
+uint64_t Battlefield::occupantKey(int x, int y, const Ship *s,
+                                  int lives) const {
+  uint64_t cell = static_cast<uint64_t>(x) * width + y;
+  return Zobrist::cellKey(cell, s->getType(), s->getTeamKey(), lives);
 }
 
-Ship *Battlefield::getOccupant(int x, int y) const { return occupant[x][y]; }
+void Battlefield::livesChanged(const Ship *s, int oldLives) {
+  Position p = s->getPosition();
+  if (inBounds(p.x, p.y) && getOccupant(p.x, p.y) == s) {
+    stateHash ^= occupantKey(p.x, p.y, s, oldLives) ^
+                 occupantKey(p.x, p.y, s, s->getLives());
+  }
+}
 
 void Battlefield::setOccupant(int x, int y, Ship *shipPtr) {
-  occupant[x][y] = shipPtr;
+  if (journal) {
+    journal->cell(x, y, getOccupant(x, y), shipPtr);
+  }
+  // Out-of-board writes only touch the sentinel ring, which is never hashed
+  if (inBounds(x, y)) {
+    const Ship *old = getOccupant(x, y);
+    if (old) {
+      stateHash ^= occupantKey(x, y, old, old->getLives());
+    }
+    if (shipPtr) {
+      stateHash ^= occupantKey(x, y, shipPtr, shipPtr->getLives());
+    }
+  }
+  // Chunked boards have no ring; an unplaced ship's cell (-1, -1) is not
+  // stored and reads back empty
+  if (layout == CHUNKED) {
+    if (inBounds(x, y))
+      chunked.setOccupant(x, y, shipPtr);
+  } else {
+    occupant[cellIndex(x, y)] = shipPtr;
+  }
   if (shipPtr) {
     shipPtr->setPosition(x, y);
+    if (watcher) {
+      watcher->cellOccupied(x, y, shipPtr);
+    }
   }
 }
 
-bool Battlefield::placeShipRandomly(Ship *shipPtr) {
+void Battlefield::restoreOccupant(int x, int y, Ship *shipPtr) {
+  if (layout == CHUNKED) {
+    if (inBounds(x, y))
+      chunked.setOccupant(x, y, shipPtr);
+  } else {
+    occupant[cellIndex(x, y)] = shipPtr;
+  }
+}
+
+void Battlefield::forkFrom(const Battlefield &other,
+                           const std::vector<Ship *> &fleet) {
+  width = other.width;
+  height = other.height;
+  layout = other.layout;
+  shape = other.shape;
+  tilesPerRow = other.tilesPerRow;
+  mortonRow = other.mortonRow;
+  mortonCol = other.mortonCol;
+  watcher = nullptr;
+  journal = nullptr;
+  stateHash = other.stateHash;
+
+  if (layout == CHUNKED) {
+    std::vector<unsigned char>().swap(terrain);
+    std::vector<Ship *>().swap(occupant);
+    chunked.forkFrom(other.chunked);
+    return;
+  }
+  terrain = other.terrain;
+  occupant.resize(other.occupant.size());
+  for (size_t i = 0; i < occupant.size(); i++) {
+    const Ship *s = other.occupant[i];
+    occupant[i] = s ? fleet[s->getFleetIndex()] : nullptr;
+  }
+  chunked.resize(0, 0);
+}
+
+bool Battlefield::placeShipRandomly(Ship *shipPtr, Random &rng) {
   // Attempt a certain number of random placements
   // to find free water cell
   const int MAX_TRIES = 100;
   for (int i = 0; i < MAX_TRIES; i++) {
-    int rx = std::rand() % HEIGHT;
-    int ry = std::rand() % WIDTH;
+    int rx = rng.nextInt(height);
+    int ry = rng.nextInt(width);
 
     // If it's water (0) and unoccupied, place here
     if (!isIsland(rx, ry) && !isOccupied(rx, ry)) {
@@ -61,27 +261,40 @@ bool Battlefield::placeShipRandomly(Ship *shipPtr) {
   return false; // Could not place
 }
 
+size_t Battlefield::memoryUsage() const {
+  return terrain.capacity() * sizeof(unsigned char) +
+         occupant.capacity() * sizeof(Ship *) + chunked.memoryUsage();
+}
+
 void Battlefield::display(std::ostream &out) const {
+  // Printing a huge ocean every turn is useless, just summarise it
+  if (static_cast<long long>(width) * height > MAX_DISPLAY_CELLS) {
+    out << "Battlefield " << width << "x" << height
+        << " (too large to display)\n";
+    return;
+  }
+
   out << "   ";
-  for (int col = 0; col < WIDTH; col++) {
+  for (int col = 0; col < width; col++) {
     out << col << " ";
   }
   out << "\n";
 
-  for (int x = 0; x < HEIGHT; x++) {
+  for (int x = 0; x < height; x++) {
     out << x << ": ";
-    for (int y = 0; y < WIDTH; y++) {
-      if (terrain[x][y] == 1) {
+    for (int y = 0; y < width; y++) {
+      Ship *occ = getOccupant(x, y);
+      if (isIsland(x, y)) {
         // Island cell
         out << "# ";
-      } else if (occupant[x][y] == nullptr) {
+      } else if (occ == nullptr) {
         // Water cell, no ship
         out << EMPTY_DISPLAY << " ";
       } else {
         // There's a ship here, display a single char from its symbol or any
         // logic For multi-char symbol, you might show the first char or
         // something else
-        std::string sym = occupant[x][y]->getSymbol();
+        const std::string &sym = occ->getSymbol();
         out << (sym.empty() ? '?' : sym[0]) << " ";
       }
     }
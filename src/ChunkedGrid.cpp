@@ -0,0 +1,217 @@
+#include "ChunkedGrid.h"
+#include "Ship.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+const ChunkedGrid::TerrainTile &ChunkedGrid::waterTile() {
+  static const TerrainTile tile = [] {
+    TerrainTile t;
+    std::memset(t.cell, 0, sizeof(t.cell));
+    return t;
+  }();
+  return tile;
+}
+
+const ChunkedGrid::TerrainTile &ChunkedGrid::islandTile() {
+  static const TerrainTile tile = [] {
+    TerrainTile t;
+    std::memset(t.cell, 1, sizeof(t.cell));
+    return t;
+  }();
+  return tile;
+}
+
+ChunkedGrid::ChunkedGrid()
+    : width(0), height(0), chunkCols(0), chunkRows(0), occupantTileCount(0),
+      copiedTiles(0), fleet(nullptr) {
+  spareTiles.reserve(MAX_SPARE_TILES);
+}
+
+ChunkedGrid::~ChunkedGrid() {
+  freeOccupants();
+  for (OccupantTile *tile : spareTiles) {
+    delete tile;
+  }
+}
+
+void ChunkedGrid::resize(int newWidth, int newHeight) {
+  freeOccupants();
+  ownedTerrain.clear();
+
+  width = newWidth;
+  height = newHeight;
+  chunkCols = (width + CHUNK_MASK) >> CHUNK_SHIFT;
+  chunkRows = (height + CHUNK_MASK) >> CHUNK_SHIFT;
+
+  Chunk empty;
+  empty.terrain = &waterTile();
+  empty.occupants = nullptr;
+  chunks.assign(static_cast<size_t>(chunkRows) * chunkCols, empty);
+}
+
+ChunkedGrid::TerrainTile *ChunkedGrid::makeTerrainPrivate(Chunk &c) {
+  if (c.terrain == &waterTile() || c.terrain == &islandTile()) {
+    std::shared_ptr<TerrainTile> copy(new TerrainTile(*c.terrain));
+    c.terrain = copy.get();
+    ownedTerrain.push_back(std::move(copy));
+  }
+  // Only private tiles reach here, so dropping const is safe
+  return const_cast<TerrainTile *>(c.terrain);
+}
+
+void ChunkedGrid::setIsland(int x, int y, bool island) {
+  Chunk &c = chunkAt(x, y);
+  unsigned char value = island ? 1 : 0;
+  if (c.terrain->cell[cellOffset(x, y)] == value)
+    return;
+  makeTerrainPrivate(c)->cell[cellOffset(x, y)] = value;
+}
+
+void ChunkedGrid::compactTerrain() {
+  // Swap private tiles that turned out uniform for the shared constants.
+  // Cells past the board edge (partial chunks) are ignored.
+  for (int cr = 0; cr < chunkRows; cr++) {
+    for (int cc = 0; cc < chunkCols; cc++) {
+      Chunk &c = chunks[cr * chunkCols + cc];
+      if (c.terrain == &waterTile() || c.terrain == &islandTile())
+        continue;
+
+      int rows = std::min(CHUNK_SIZE, height - (cr << CHUNK_SHIFT));
+      int cols = std::min(CHUNK_SIZE, width - (cc << CHUNK_SHIFT));
+      unsigned char first = c.terrain->cell[0];
+      bool uniform = true;
+      for (int r = 0; r < rows && uniform; r++) {
+        for (int k = 0; k < cols; k++) {
+          if (c.terrain->cell[(r << CHUNK_SHIFT) | k] != first) {
+            uniform = false;
+            break;
+          }
+        }
+      }
+      if (uniform) {
+        c.terrain = first ? &islandTile() : &waterTile();
+      }
+    }
+  }
+
+  // Release the tiles nobody points at anymore
+  std::unordered_set<const TerrainTile *> used;
+  for (const Chunk &c : chunks) {
+    used.insert(c.terrain);
+  }
+  std::vector<std::shared_ptr<TerrainTile>> stillUsed;
+  for (auto &owned : ownedTerrain) {
+    if (used.count(owned.get())) {
+      stillUsed.push_back(std::move(owned));
+    }
+  }
+  ownedTerrain.swap(stillUsed);
+}
+
+void ChunkedGrid::setOccupant(int x, int y, Ship *shipPtr) {
+  Chunk &c = chunkAt(x, y);
+  int off = cellOffset(x, y);
+
+  if (!c.occupants) {
+    if (!shipPtr)
+      return; // clearing an empty chunk, nothing to do
+    c.occupants = takeOccupantTile();
+    occupantTileCount++;
+  }
+
+  int32_t id = shipPtr ? shipPtr->getFleetIndex() + 1 : 0;
+  if (c.occupants->cell[off] == id)
+    return;
+  OccupantTile *tile = unshare(c);
+  int32_t &cell = tile->cell[off];
+  if (cell && !id) {
+    tile->count--;
+  } else if (!cell && id) {
+    tile->count++;
+  }
+  cell = id;
+
+  if (c.occupants->count == 0) {
+    retireOccupantTile(c.occupants);
+    c.occupants = nullptr;
+    occupantTileCount--;
+  }
+}
+
+ChunkedGrid::OccupantTile *ChunkedGrid::takeOccupantTile() {
+  if (!spareTiles.empty()) {
+    // Spares are always empty (count hit 0), no need to clear them
+    OccupantTile *tile = spareTiles.back();
+    spareTiles.pop_back();
+    return tile;
+  }
+  OccupantTile *tile = new OccupantTile();
+  std::memset(tile->cell, 0, sizeof(tile->cell));
+  tile->count = 0;
+  tile->refs = 1;
+  return tile;
+}
+
+ChunkedGrid::OccupantTile *ChunkedGrid::unshare(Chunk &c) {
+  OccupantTile *shared = c.occupants;
+  if (shared->refs.load(std::memory_order_acquire) == 1)
+    return shared;
+  // Another grid still reads it: write to our own copy
+  OccupantTile *tile = takeOccupantTile();
+  std::memcpy(tile->cell, shared->cell, sizeof(tile->cell));
+  tile->count = shared->count;
+  releaseTile(shared);
+  c.occupants = tile;
+  copiedTiles++;
+  return tile;
+}
+
+void ChunkedGrid::releaseTile(OccupantTile *tile) {
+  if (tile->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete tile;
+  }
+}
+
+void ChunkedGrid::retireOccupantTile(OccupantTile *tile) {
+  if (spareTiles.size() < MAX_SPARE_TILES) {
+    spareTiles.push_back(tile);
+  } else {
+    delete tile;
+  }
+}
+
+void ChunkedGrid::clearOccupants() { freeOccupants(); }
+
+void ChunkedGrid::freeOccupants() {
+  for (Chunk &c : chunks) {
+    if (c.occupants) {
+      releaseTile(c.occupants);
+      c.occupants = nullptr;
+    }
+  }
+  occupantTileCount = 0;
+}
+
+void ChunkedGrid::forkFrom(const ChunkedGrid &other) {
+  freeOccupants();
+  width = other.width;
+  height = other.height;
+  chunkCols = other.chunkCols;
+  chunkRows = other.chunkRows;
+  ownedTerrain = other.ownedTerrain;
+  chunks = other.chunks;
+  for (Chunk &c : chunks) {
+    if (c.occupants) {
+      c.occupants->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  occupantTileCount = other.occupantTileCount;
+  copiedTiles = 0;
+}
+
+size_t ChunkedGrid::memoryUsage() const {
+  return chunks.size() * sizeof(Chunk) +
+         ownedTerrain.size() * sizeof(TerrainTile) +
+         (occupantTileCount + spareTiles.size()) * sizeof(OccupantTile);
+}
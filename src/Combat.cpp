@@ -0,0 +1,135 @@
+#include "Combat.h"
+#include "Battlefield.h"
+#include "Ship.h"
+#include <algorithm>
+
+const char *CombatBuffer::modeName(Mode mode) {
+  return mode == BATCHED ? "batched" : "immediate";
+}
+
+bool CombatBuffer::parseMode(const std::string &name, Mode &mode) {
+  if (name == "immediate") {
+    mode = IMMEDIATE;
+  } else if (name == "batched") {
+    mode = BATCHED;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+CombatBuffer::CombatBuffer() : arrivals(0) {}
+
+void CombatBuffer::addShot(Ship *attacker, Ship *target, int x, int y,
+                           int damage, int boardWidth) {
+  Hit h;
+  // 64-bit, so chunked oceans past 2^31 cells still get distinct cells
+  h.cell = static_cast<uint64_t>(x) * static_cast<uint64_t>(boardWidth) +
+           static_cast<uint64_t>(y);
+  h.arrival = arrivals++;
+  h.attacker = attacker;
+  h.target = target;
+  h.x = x;
+  h.y = y;
+  h.damage = damage;
+  h.ram = false;
+  hits.push_back(h);
+}
+
+void CombatBuffer::addRam(Ship *attacker, Ship *target, int x, int y,
+                          int boardWidth) {
+  addShot(attacker, target, x, y, 0, boardWidth);
+  hits.back().ram = true;
+}
+
+void CombatBuffer::resolve(Battlefield &bf) {
+  // Group the hits by target cell; the arrival number keeps the sort stable
+  std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) {
+    return a.cell != b.cell ? a.cell < b.cell : a.arrival < b.arrival;
+  });
+
+  size_t begin = 0;
+  while (begin < hits.size()) {
+    size_t end = begin + 1;
+    while (end < hits.size() && hits[end].cell == hits[begin].cell)
+      end++;
+    resolveCell(begin, end);
+    begin = end;
+  }
+
+  // Rammers only move once every cell has been settled
+  begin = 0;
+  while (begin < hits.size()) {
+    size_t end = begin + 1;
+    while (end < hits.size() && hits[end].cell == hits[begin].cell)
+      end++;
+    settleRams(bf, begin, end);
+    begin = end;
+  }
+
+  hits.clear();
+  arrivals = 0;
+}
+
+void CombatBuffer::resolveCell(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    Ship *target = hits[i].target;
+
+    // Each ship in the cell is handled at its first hit
+    bool seen = false;
+    for (size_t j = begin; j < i && !seen; j++) {
+      seen = hits[j].target == target;
+    }
+    // Already sunk (hit again after it moved to another cell)
+    if (seen || !target->isAlive())
+      continue;
+
+    int damage = 0;
+    bool lethal = false;
+    for (size_t k = i; k < end; k++) {
+      if (hits[k].target == target) {
+        damage += hits[k].damage;
+        lethal |= hits[k].ram;
+      }
+    }
+    target->takeDamage(lethal ? target->getLives() : damage);
+    if (target->isAlive())
+      continue;
+
+    // Every attacker that hit it shares the kill, once each
+    for (size_t k = i; k < end; k++) {
+      if (hits[k].target != target)
+        continue;
+      bool credited = false;
+      for (size_t j = i; j < k && !credited; j++) {
+        credited = hits[j].target == target &&
+                   hits[j].attacker == hits[k].attacker;
+      }
+      if (!credited)
+        hits[k].attacker->recordKill();
+    }
+  }
+}
+
+void CombatBuffer::settleRams(Battlefield &bf, size_t begin, size_t end) {
+  Ship *mover = nullptr;
+  int claims = 0;
+  for (size_t k = begin; k < end; k++) {
+    const Hit &h = hits[k];
+    if (h.ram && !h.target->isAlive() && h.attacker->isAlive() &&
+        h.attacker != mover) {
+      mover = h.attacker;
+      claims++;
+    }
+  }
+
+  const Hit &cell = hits[begin];
+  if (claims != 1 || bf.getOccupant(cell.x, cell.y))
+    return;
+
+  Position p = mover->getPosition();
+  if (bf.inBounds(p.x, p.y) && bf.getOccupant(p.x, p.y) == mover) {
+    bf.setOccupant(p.x, p.y, nullptr);
+  }
+  bf.setOccupant(cell.x, cell.y, mover);
+}
@@ -0,0 +1,278 @@
+#include "Daemon.h"
+#include "GameManager.h"
+#include "Log.h"
+#include "Sweep.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Buffered line reader over a socket
+class FdLineReader {
+private:
+  int fd;
+  char buf[4096];
+  size_t pos;
+  size_t len;
+
+public:
+  explicit FdLineReader(int f) : fd(f), pos(0), len(0) {}
+
+  bool readLine(std::string &line) {
+    line.clear();
+    for (;;) {
+      if (pos == len) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          return !line.empty();
+        pos = 0;
+        len = static_cast<size_t>(n);
+      }
+      char c = buf[pos++];
+      if (c == '\n')
+        return true;
+      if (c != '\r')
+        line += c;
+    }
+  }
+};
+
+bool writeAll(int fd, const std::string &text) {
+  size_t sent = 0;
+  while (sent < text.size()) {
+    ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+} // namespace
+
+SimDaemon::SimDaemon()
+    : battles(0), stopping(false),
+      seedBase(static_cast<uint64_t>(std::time(nullptr))), listenFd(-1) {}
+
+SimDaemon::~SimDaemon() {
+  if (listenFd >= 0)
+    ::close(listenFd);
+}
+
+std::unique_ptr<GameManager> SimDaemon::acquire() {
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (!idle.empty()) {
+      std::unique_ptr<GameManager> manager = std::move(idle.back());
+      idle.pop_back();
+      return manager;
+    }
+  }
+  return std::unique_ptr<GameManager>(new GameManager());
+}
+
+void SimDaemon::release(std::unique_ptr<GameManager> manager) {
+  // Free the ships now (their slots go back to ShipPool), keep the rest
+  manager->reset();
+  std::lock_guard<std::mutex> lock(poolMutex);
+  idle.push_back(std::move(manager));
+}
+
+std::string SimDaemon::runScenario(const std::string &scenarioText) {
+  auto start = std::chrono::steady_clock::now();
+  ScopedLog quiet(nullLog());
+
+  std::istringstream in(scenarioText);
+  GameParser parser;
+  GameConfig config = parser.parseStream(in);
+  if (config.allShips.empty()) {
+    throw std::runtime_error("Scenario has no ships");
+  }
+  uint64_t battle = battles++;
+  if (!config.hasSeed) {
+    config.hasSeed = true;
+    config.seed = seedBase + battle;
+  }
+  std::vector<std::string> teams = SweepRunner::teamsOf(config);
+
+  std::unique_ptr<GameManager> manager = acquire();
+  SweepResult result;
+  try {
+    manager->loadConfig(config);
+    manager->runSimulation(config.iterations);
+    result = SweepRunner::summarise(*manager, teams);
+  } catch (...) {
+    release(std::move(manager));
+    throw;
+  }
+  release(std::move(manager));
+
+  auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+  std::ostringstream out;
+  out << "ok seed=" << config.seed << " winner=" << result.winner
+      << " turns=" << result.turns << " kills=" << result.kills << " alive=";
+  for (size_t t = 0; t < teams.size(); t++) {
+    out << (t ? "," : "") << teams[t] << ":" << result.alive[t];
+  }
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx",
+                static_cast<unsigned long long>(result.stateHash));
+  out << " hash=" << hash << " us=" << micros;
+  return out.str();
+}
+
+bool SimDaemon::handleLine(const std::string &line, std::string &pending,
+                           std::string &reply) {
+  reply.clear();
+  std::istringstream iss(line);
+  std::string token;
+  iss >> token;
+
+  try {
+    if (token == "end") {
+      std::string text;
+      text.swap(pending);
+      reply = runScenario(text);
+    } else if (token == "file" && pending.empty()) {
+      std::string path;
+      iss >> path;
+      std::ifstream fin(path);
+      if (!fin.is_open()) {
+        throw std::runtime_error("Cannot open file: " + path);
+      }
+      std::ostringstream text;
+      text << fin.rdbuf();
+      reply = runScenario(text.str());
+    } else if (token == "quit" && pending.empty()) {
+      return false;
+    } else if (token == "shutdown" && pending.empty()) {
+      stopping = true;
+      if (listenFd >= 0) {
+        // Wakes up the accept() loop
+        ::shutdown(listenFd, SHUT_RDWR);
+      }
+      return false;
+    } else {
+      pending += line;
+      pending += '\n';
+    }
+  } catch (const std::exception &ex) {
+    pending.clear();
+    reply = std::string("error ") + ex.what();
+  }
+  return true;
+}
+
+int SimDaemon::serveStream(std::istream &in, std::ostream &out) {
+  std::string line, pending, reply;
+  while (std::getline(in, line)) {
+    bool more = handleLine(line, pending, reply);
+    if (!reply.empty()) {
+      out << reply << "\n" << std::flush;
+    }
+    if (!more)
+      break;
+  }
+  return 0;
+}
+
+void SimDaemon::serveConnection(Connection *connection) {
+  int fd = connection->fd;
+  FdLineReader reader(fd);
+  std::string line, pending, reply;
+  while (reader.readLine(line)) {
+    bool more = handleLine(line, pending, reply);
+    if (!reply.empty() && !writeAll(fd, reply + "\n"))
+      break;
+    if (!more)
+      break;
+  }
+  std::lock_guard<std::mutex> lock(connectionMutex);
+  ::close(fd);
+  connection->fd = -1;
+}
+
+void SimDaemon::reapConnections() {
+  std::lock_guard<std::mutex> lock(connectionMutex);
+  for (auto it = connections.begin(); it != connections.end();) {
+    if (it->fd < 0) {
+      it->thread.join(); // past its last statement, returns at once
+      it = connections.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int SimDaemon::serveSocket(const std::string &path) {
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + path);
+  }
+  std::strcpy(addr.sun_path, path.c_str());
+
+  listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+  }
+  ::unlink(path.c_str()); // stale socket from an earlier run
+  if (::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) <
+          0 ||
+      ::listen(listenFd, 64) < 0) {
+    throw std::runtime_error("Cannot listen on " + path + ": " +
+                             std::strerror(errno));
+  }
+  std::cerr << "Serving on " << path << "\n";
+
+  while (!stopping) {
+    int fd = ::accept(listenFd, nullptr, nullptr);
+    reapConnections();
+    if (fd < 0) {
+      if (errno == EINTR)
+        continue;
+      break; // shut down (or a real error)
+    }
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    connections.emplace_back();
+    Connection &c = connections.back();
+    c.fd = fd;
+    c.thread = std::thread(&SimDaemon::serveConnection, this, &c);
+  }
+
+  // Wake up clients blocked in recv(); a battle in progress still finishes
+  {
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    for (Connection &c : connections) {
+      if (c.fd >= 0)
+        ::shutdown(c.fd, SHUT_RDWR);
+    }
+  }
+  for (Connection &c : connections) {
+    c.thread.join();
+  }
+  connections.clear();
+
+  ::close(listenFd);
+  listenFd = -1;
+  ::unlink(path.c_str());
+  return 0;
+}
@@ -0,0 +1,617 @@
+#include "Evolve.h"
+#include "Lockstep.h"
+#include "Random.h"
+#include "Scheduler.h"
+#include "ShipScript.h"
+#include "Sweep.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// Ships per priced type, in EvolveSpec::costs order
+typedef std::vector<int> Genome;
+
+// Battles played so far in one matchup, from seed firstSeed on
+struct Tally {
+  int battles = 0;
+  double points = 0; // 1 per win, 1/2 per draw or stalemate
+  double margin = 0; // own survivors minus everyone else's, summed
+};
+
+int fleetCost(const Genome &g, const EvolveSpec &spec) {
+  int cost = 0;
+  for (size_t i = 0; i < g.size(); i++) {
+    cost += g[i] * spec.costs[i].points;
+  }
+  return cost;
+}
+
+int fleetSize(const Genome &g) {
+  int ships = 0;
+  for (int n : g) {
+    ships += n;
+  }
+  return ships;
+}
+
+bool fits(const Genome &g, const EvolveSpec &spec) {
+  return fleetCost(g, spec) <= spec.budget &&
+         (spec.maxShips <= 0 || fleetSize(g) <= spec.maxShips);
+}
+
+// One more ship of a random type that still fits; false if none does
+bool addRandomShip(Genome &g, const EvolveSpec &spec, Random &rng) {
+  std::vector<size_t> options;
+  for (size_t i = 0; i < g.size(); i++) {
+    g[i]++;
+    if (fits(g, spec)) {
+      options.push_back(i);
+    }
+    g[i]--;
+  }
+  if (options.empty())
+    return false;
+  g[options[rng.nextInt(static_cast<int>(options.size()))]]++;
+  return true;
+}
+
+void dropRandomShip(Genome &g, Random &rng) {
+  int ships = fleetSize(g);
+  if (ships == 0)
+    return;
+  int pick = rng.nextInt(ships);
+  for (int &n : g) {
+    if (pick < n) {
+      n--;
+      return;
+    }
+    pick -= n;
+  }
+}
+
+// Back under the budget, and never an empty fleet
+void repair(Genome &g, const EvolveSpec &spec, Random &rng) {
+  while (!fits(g, spec)) {
+    dropRandomShip(g, rng);
+  }
+  if (fleetSize(g) == 0) {
+    addRandomShip(g, spec, rng);
+  }
+}
+
+Genome randomFleet(const EvolveSpec &spec, Random &rng) {
+  Genome g(spec.costs.size(), 0);
+  while (addRandomShip(g, spec, rng)) {
+  }
+  return g;
+}
+
+void mutate(Genome &g, const EvolveSpec &spec, Random &rng) {
+  switch (rng.nextInt(3)) {
+  case 0:
+    addRandomShip(g, spec, rng);
+    break;
+  case 1:
+    dropRandomShip(g, rng);
+    break;
+  default:
+    dropRandomShip(g, rng);
+    addRandomShip(g, spec, rng);
+    break;
+  }
+  repair(g, spec, rng);
+}
+
+Genome crossover(const Genome &a, const Genome &b, const EvolveSpec &spec,
+                 Random &rng) {
+  Genome child(a.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    child[i] = rng.nextInt(2) ? a[i] : b[i];
+  }
+  repair(child, spec, rng);
+  return child;
+}
+
+std::string describe(const Genome &g, const EvolveSpec &spec) {
+  std::string text;
+  for (size_t i = 0; i < g.size(); i++) {
+    if (g[i] == 0)
+      continue;
+    if (!text.empty())
+      text += ", ";
+    text += std::to_string(g[i]) + " " + spec.costs[i].type;
+  }
+  return text.empty() ? "(no ships)" : text;
+}
+
+// `base` with the fleet of `team` replaced by `g`. The new block takes the
+// old one's place, so the team order (and SweepResult::alive) is unchanged;
+// symbols are the ones the team used for a type, else its first letter.
+GameConfig withFleet(const GameConfig &base, const std::string &team,
+                     const Genome &g, const EvolveSpec &spec) {
+  GameConfig c = base;
+  std::vector<GameConfig::ShipInfo> fleet;
+  for (size_t i = 0; i < g.size(); i++) {
+    if (g[i] == 0)
+      continue;
+    GameConfig::ShipInfo info;
+    info.type = spec.costs[i].type;
+    info.symbol = info.type.substr(0, 1);
+    for (const GameConfig::ShipInfo &old : base.allShips) {
+      if (old.team == team && old.type == info.type) {
+        info.symbol = old.symbol;
+        break;
+      }
+    }
+    info.count = g[i];
+    info.team = team;
+    fleet.push_back(info);
+  }
+
+  std::vector<GameConfig::ShipInfo> ships;
+  bool placed = false;
+  for (const GameConfig::ShipInfo &info : base.allShips) {
+    if (info.team != team) {
+      ships.push_back(info);
+    } else if (!placed) {
+      ships.insert(ships.end(), fleet.begin(), fleet.end());
+      placed = true;
+    }
+  }
+  if (!placed) {
+    ships.insert(ships.end(), fleet.begin(), fleet.end());
+  }
+  c.allShips = ships;
+  return c;
+}
+
+// 95% Hoeffding half-width of a mean of n results in [0, 1]
+double hoeffding(int n) {
+  return n > 0 ? std::sqrt(std::log(2.0 / 0.05) / (2.0 * n)) : 1.0;
+}
+
+// One battle scenario of a generation: a candidate fleet against one
+// opponent line-up
+struct Matchup {
+  GameConfig config;
+  std::vector<std::string> teams;
+  size_t self; // index of the evolved team in `teams`
+  bool lockstep;
+};
+
+struct Candidate {
+  Genome genome;
+  std::vector<uint64_t> matchups; // cache keys, one per opponent
+  int cost;
+  int battles;
+  double fitness;
+  double margin; // mean survivor margin
+  bool culled;
+};
+
+void addResult(const SweepResult &r, const Matchup &m, Tally &t) {
+  t.battles++;
+  if (r.winner == m.teams[m.self]) {
+    t.points += 1;
+  } else if (r.winner == "-" || r.stalemate) {
+    t.points += 0.5;
+  }
+  for (size_t i = 0; i < m.teams.size(); i++) {
+    t.margin += (i == m.self) ? r.alive[i] : -r.alive[i];
+  }
+}
+
+} // namespace
+
+EvolveSpec FleetEvolver::parseSpec(const std::string &filename) {
+  std::ifstream fin(filename);
+  if (!fin.is_open()) {
+    throw std::runtime_error("Cannot open evolve file: " + filename);
+  }
+
+  EvolveSpec spec;
+  spec.budget = 0;
+  spec.maxShips = 0;
+  spec.population = 24;
+  spec.generations = 20;
+  spec.elite = 2;
+  spec.battles = 64;
+  spec.firstSeed = 1;
+  spec.cull = 16;
+  spec.opponents = 0;
+  spec.objectEngine = false;
+  spec.seed = 1;
+  spec.threads = 0;
+  spec.pin = false;
+
+  std::string line;
+  while (std::getline(fin, line)) {
+    std::istringstream iss(line);
+    std::string token;
+    if (!(iss >> token) || token[0] == '#')
+      continue;
+
+    if (token == "scenario") {
+      iss >> spec.scenarioFile;
+    } else if (token == "team") {
+      iss >> spec.team;
+    } else if (token == "budget") {
+      iss >> spec.budget;
+    } else if (token == "cost") {
+      // Example: "cost Battleship 5"
+      EvolveSpec::Cost cost;
+      cost.points = 0;
+      iss >> cost.type >> cost.points;
+      if (cost.points <= 0) {
+        throw std::runtime_error("Evolve: cost of " + cost.type +
+                                 " must be positive");
+      }
+      spec.costs.push_back(cost);
+    } else if (token == "maxShips") {
+      iss >> spec.maxShips;
+    } else if (token == "population") {
+      iss >> spec.population;
+    } else if (token == "generations") {
+      iss >> spec.generations;
+    } else if (token == "elite") {
+      iss >> spec.elite;
+    } else if (token == "battles") {
+      iss >> spec.battles;
+    } else if (token == "firstSeed") {
+      iss >> spec.firstSeed;
+    } else if (token == "cull") {
+      iss >> spec.cull;
+    } else if (token == "opponents") {
+      iss >> spec.opponents;
+    } else if (token == "engine") {
+      std::string engine;
+      iss >> engine;
+      spec.objectEngine = engine == "object";
+    } else if (token == "seed") {
+      iss >> spec.seed;
+    } else if (token == "threads") {
+      iss >> spec.threads;
+    } else if (token == "pin") {
+      iss >> spec.pin;
+    } else if (token == "output") {
+      iss >> spec.output;
+    } else {
+      throw std::runtime_error("Unknown evolve keyword: " + token);
+    }
+  }
+
+  if (spec.scenarioFile.empty() || spec.team.empty()) {
+    throw std::runtime_error("Evolve file needs 'scenario' and 'team' lines");
+  }
+  if (spec.costs.empty()) {
+    throw std::runtime_error("Evolve file needs at least one 'cost' line");
+  }
+  int cheapest = spec.costs[0].points;
+  for (const EvolveSpec::Cost &c : spec.costs) {
+    cheapest = std::min(cheapest, c.points);
+  }
+  if (spec.budget < cheapest) {
+    throw std::runtime_error("Evolve: the budget buys no ship at all");
+  }
+  spec.population = std::max(spec.population, 2);
+  spec.generations = std::max(spec.generations, 1);
+  spec.elite = std::max(0, std::min(spec.elite, spec.population - 1));
+  spec.battles = std::max(spec.battles, 1);
+  return spec;
+}
+
+int FleetEvolver::run(const EvolveSpec &spec, Scheduler &scheduler) {
+  GameParser parser;
+  GameConfig base = parser.parseFile(spec.scenarioFile);
+  base.hasSeed = false; // seeds come from firstSeed
+
+  std::vector<std::string> teams = SweepRunner::teamsOf(base);
+  if (std::find(teams.begin(), teams.end(), spec.team) == teams.end()) {
+    throw std::runtime_error("Evolve: no team " + spec.team + " in " +
+                             spec.scenarioFile);
+  }
+  std::string rival;
+  if (spec.opponents > 0) {
+    if (teams.size() != 2) {
+      throw std::runtime_error(
+          "Evolve: evolving opponents needs exactly two teams");
+    }
+    rival = teams[0] == spec.team ? teams[1] : teams[0];
+  }
+
+  // Every priced type must exist: built in, or a shiptype of the scenario
+  ShipCatalog catalog;
+  catalog.compile(base.shipTypes);
+  for (const EvolveSpec::Cost &c : spec.costs) {
+    ShipType type;
+    if (!parseShipType(c.type, type) && !catalog.find(c.type)) {
+      throw std::runtime_error("Evolve: unknown ship type " + c.type);
+    }
+  }
+
+  Random rng(spec.seed);
+  std::vector<Genome> population;
+
+  // The hand-made fleet is the first candidate, if it can be priced
+  Genome given(spec.costs.size(), 0);
+  bool priced = true;
+  for (const GameConfig::ShipInfo &info : base.allShips) {
+    if (info.team != spec.team)
+      continue;
+    size_t i = 0;
+    while (i < spec.costs.size() && spec.costs[i].type != info.type)
+      i++;
+    if (i == spec.costs.size()) {
+      priced = false;
+      break;
+    }
+    given[i] += info.count;
+  }
+  if (priced && fleetSize(given) > 0 && fits(given, spec)) {
+    population.push_back(given);
+  }
+  while (population.size() < static_cast<size_t>(spec.population)) {
+    population.push_back(randomFleet(spec, rng));
+  }
+
+  std::unordered_map<uint64_t, Tally> cache;
+  std::deque<Genome> hallOfFame; // opponents: best of recent generations
+  bool warned = false;
+  uint64_t totalBattles = 0;
+  std::vector<Candidate> ranked;
+
+  std::cout << "Evolving team " << spec.team << ": budget " << spec.budget
+            << ", " << spec.population << " fleets, " << spec.battles
+            << " battles per opponent, seeds " << spec.firstSeed << "..\n";
+  scheduler.resetStats();
+  auto runStart = std::chrono::steady_clock::now();
+
+  for (int gen = 0; gen < spec.generations; gen++) {
+    auto genStart = std::chrono::steady_clock::now();
+
+    // Opponent line-ups: the scenario's, or recent champions on the rival
+    // team
+    std::vector<GameConfig> lineups;
+    for (const Genome &g : hallOfFame) {
+      lineups.push_back(withFleet(base, rival, g, spec));
+    }
+    if (lineups.empty()) {
+      lineups.push_back(base);
+    }
+
+    // Matchups of this generation, keyed (and ordered) by cache key
+    std::map<uint64_t, Matchup> matchups;
+    std::vector<Candidate> candidates(population.size());
+    for (size_t c = 0; c < population.size(); c++) {
+      Candidate &cand = candidates[c];
+      cand.genome = population[c];
+      cand.cost = fleetCost(cand.genome, spec);
+      cand.culled = false;
+      for (const GameConfig &lineup : lineups) {
+        GameConfig config = withFleet(lineup, spec.team, cand.genome, spec);
+        uint64_t key = SweepRunner::scenarioHash(parser.serialize(config),
+                                                 spec.firstSeed);
+        cand.matchups.push_back(key);
+        if (matchups.count(key))
+          continue;
+        Matchup m;
+        m.teams = SweepRunner::teamsOf(config);
+        m.self = std::find(m.teams.begin(), m.teams.end(), spec.team) -
+                 m.teams.begin();
+        std::string reason;
+        m.lockstep = !spec.objectEngine &&
+                     LockstepEngine::supports(config, reason);
+        if (!spec.objectEngine && !m.lockstep && !warned) {
+          std::cerr << "Evolve: " << reason << ", using the object engine\n";
+          warned = true;
+        }
+        m.config = config;
+        matchups.emplace(key, m);
+      }
+    }
+
+    // Play every listed matchup up to `target` battles, all in one go
+    uint64_t played = 0;
+    auto playRound = [&](const std::vector<uint64_t> &keys, int target) {
+      struct Job {
+        const Matchup *matchup;
+        uint64_t key;
+        int first; // battle index, seed firstSeed + first
+        int count;
+        Tally tally;
+      };
+      std::vector<Job> jobs;
+      for (uint64_t key : keys) {
+        const Matchup &m = matchups.at(key);
+        int step = m.lockstep ? LockstepEngine::LANES : 4;
+        for (int first = cache[key].battles; first < target; first += step) {
+          Job job;
+          job.matchup = &m;
+          job.key = key;
+          job.first = first;
+          job.count = std::min(step, target - first);
+          jobs.push_back(job);
+        }
+      }
+
+      scheduler.parallelFor(0, jobs.size(), 1, [&](size_t j) {
+        Job &job = jobs[j];
+        const Matchup &m = *job.matchup;
+        if (m.lockstep) {
+          LockstepEngine engine(m.config);
+          uint64_t seeds[LockstepEngine::LANES];
+          SweepResult results[LockstepEngine::LANES];
+          for (int l = 0; l < job.count; l++) {
+            seeds[l] = spec.firstSeed + job.first + l;
+          }
+          engine.run(seeds, job.count, results);
+          for (int l = 0; l < job.count; l++) {
+            addResult(results[l], m, job.tally);
+          }
+          return;
+        }
+        GameConfig c = m.config;
+        c.hasSeed = true;
+        for (int l = 0; l < job.count; l++) {
+          c.seed = spec.firstSeed + job.first + l;
+          addResult(SweepRunner::playGame(c, m.teams), m, job.tally);
+        }
+      });
+
+      // Fold in job order, so the sums never depend on the threads
+      for (const Job &job : jobs) {
+        Tally &t = cache[job.key];
+        t.battles += job.tally.battles;
+        t.points += job.tally.points;
+        t.margin += job.tally.margin;
+        played += job.tally.battles;
+      }
+    };
+
+    auto score = [&](Candidate &cand) {
+      Tally sum;
+      for (uint64_t key : cand.matchups) {
+        const Tally &t = cache[key];
+        sum.battles += t.battles;
+        sum.points += t.points;
+        sum.margin += t.margin;
+      }
+      cand.battles = sum.battles;
+      cand.fitness = sum.battles ? sum.points / sum.battles : 0;
+      cand.margin = sum.battles ? sum.margin / sum.battles : 0;
+    };
+
+    size_t cached = 0;
+    for (const Candidate &cand : candidates) {
+      bool done = true;
+      for (uint64_t key : cand.matchups) {
+        auto it = cache.find(key);
+        done = done && it != cache.end() && it->second.battles >= spec.battles;
+      }
+      cached += done;
+    }
+
+    // Round 1: `cull` battles each, then drop the clearly losing fleets
+    std::vector<uint64_t> all;
+    for (const auto &entry : matchups) {
+      all.push_back(entry.first);
+    }
+    bool culling = spec.cull > 0 && spec.cull < spec.battles;
+    playRound(all, culling ? spec.cull : spec.battles);
+    size_t culled = 0;
+    if (culling) {
+      double best = -1;
+      for (Candidate &cand : candidates) {
+        score(cand);
+        best = std::max(best, cand.fitness - hoeffding(cand.battles));
+      }
+      std::vector<uint64_t> rest;
+      for (Candidate &cand : candidates) {
+        if (cand.fitness + hoeffding(cand.battles) < best) {
+          cand.culled = true;
+          culled++;
+          continue;
+        }
+        rest.insert(rest.end(), cand.matchups.begin(), cand.matchups.end());
+      }
+      std::sort(rest.begin(), rest.end());
+      rest.erase(std::unique(rest.begin(), rest.end()), rest.end());
+      playRound(rest, spec.battles);
+    }
+    for (Candidate &cand : candidates) {
+      score(cand);
+    }
+
+    // Fully played fleets first, then by fitness, margin and cost
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &a, const Candidate &b) {
+                       if (a.culled != b.culled)
+                         return !a.culled;
+                       if (a.fitness != b.fitness)
+                         return a.fitness > b.fitness;
+                       if (a.margin != b.margin)
+                         return a.margin > b.margin;
+                       if (a.cost != b.cost)
+                         return a.cost < b.cost;
+                       return a.genome < b.genome;
+                     });
+    ranked = candidates;
+    totalBattles += played;
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - genStart)
+                         .count();
+    double mean = 0;
+    for (const Candidate &cand : candidates) {
+      mean += cand.fitness;
+    }
+    mean /= candidates.size();
+    const Candidate &top = candidates[0];
+    char line[160];
+    std::snprintf(line, sizeof(line),
+                  "gen %3d  best %.3f (margin %+.2f, %d pts)  mean %.3f  "
+                  "%llu battles, %zu cached, %zu culled, %.0f battles/s\n",
+                  gen, top.fitness, top.margin, top.cost, mean,
+                  static_cast<unsigned long long>(played), cached, culled,
+                  seconds > 0 ? played / seconds : 0.0);
+    std::cout << line << "         " << describe(top.genome, spec) << "\n";
+
+    if (spec.opponents > 0) {
+      if (hallOfFame.empty() || hallOfFame.back() != top.genome) {
+        hallOfFame.push_back(top.genome);
+      }
+      while (hallOfFame.size() > static_cast<size_t>(spec.opponents)) {
+        hallOfFame.pop_front();
+      }
+    }
+    if (gen + 1 == spec.generations)
+      break;
+
+    // Next generation: the elite, then children of tournament winners
+    // (the better rank of two random picks)
+    std::vector<Genome> next;
+    for (int e = 0; e < spec.elite; e++) {
+      next.push_back(candidates[e].genome);
+    }
+    int n = static_cast<int>(candidates.size());
+    while (next.size() < static_cast<size_t>(spec.population)) {
+      int a = std::min(rng.nextInt(n), rng.nextInt(n));
+      int b = std::min(rng.nextInt(n), rng.nextInt(n));
+      Genome child = crossover(candidates[a].genome, candidates[b].genome,
+                               spec, rng);
+      mutate(child, spec, rng);
+      next.push_back(child);
+    }
+    population.swap(next);
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - runStart)
+                       .count();
+  const Candidate &best = ranked[0];
+  std::cout << "Best fleet for team " << spec.team << " (" << best.cost << "/"
+            << spec.budget << " pts, fitness " << best.fitness << " over "
+            << best.battles << " battles): " << describe(best.genome, spec)
+            << "\n";
+  std::cout << totalBattles << " battles in " << seconds << " s, "
+            << cache.size() << " matchups cached\n";
+  scheduler.report(std::cerr);
+
+  if (!spec.output.empty()) {
+    std::ofstream out(spec.output);
+    if (!out.is_open()) {
+      throw std::runtime_error("Cannot write evolve output: " + spec.output);
+    }
+    out << parser.serialize(withFleet(base, spec.team, best.genome, spec));
+  }
+  return 0;
+}
@@ -1,11 +1,31 @@
 #include "GameManager.h"
+#include "AllocAudit.h"
 #include "ShipTypes.h"
+#include "Log.h"
+#include "ScenarioImage.h"
+#include "ShipPool.h"
+#include "ShipScript.h"
+#include "Zobrist.h"
 #include <algorithm>
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
+#include <stdexcept>
 
 GameManager::GameManager()
-    : maxRespawnsPerTurn(2), maxShipRespawns(3), totalIterations(100) {}
+    : maxRespawnsPerTurn(2), maxShipRespawns(3), totalIterations(100),
+      rng(static_cast<uint64_t>(std::time(nullptr))), turnsPlayed(0),
+      output(nullptr), observer(nullptr), shipActions(nullptr),
+      combatMode(CombatBuffer::IMMEDIATE), scheduled(false), due(&turnArena),
+      touched(&turnArena), teamsAlive(0),
+      sleeping(false), queueHash(0), stalemateWindow(0), lastHitTurn(0),
+      lastHash(0), stalemate(false) {
+  for (int t = 0; t < SHIP_TYPE_COUNT; t++) {
+    ratePeriod[t] = 1;
+    rateInitiative[t] = 0;
+  }
+  battlefield.setFleet(&ships);
+}
 
 GameManager::~GameManager() {
   for (Ship *s : ships) {
@@ -14,49 +34,405 @@ GameManager::~GameManager() {
   ships.clear();
 }
 
-void GameManager::setBattlefieldTerrain(const int grid[HEIGHT][WIDTH]) {
-  battlefield.setTerrain(grid);
+void GameManager::reset() {
+  for (Ship *s : ships) {
+    delete s;
+  }
+  // clear() keeps the capacity for the next scenario
+  ships.clear();
+  catalog.clear();
+  respawnQueue.clear();
+  queueHash = 0;
+  stalemateWindow = 0;
+  stalemate = false;
+  maxRespawnsPerTurn = 2;
+  maxShipRespawns = 3;
+  totalIterations = 100;
+  winningTeam.clear();
+  turnsPlayed = 0;
+  output = nullptr;
+  observer = nullptr;
+  shipActions = nullptr;
+  combatMode = CombatBuffer::IMMEDIATE;
+  scheduled = false;
+  sleeping = false;
+  battlefield.setWatcher(nullptr);
+  battlefield.setJournal(nullptr);
+  journal.reset();
+  for (int t = 0; t < SHIP_TYPE_COUNT; t++) {
+    ratePeriod[t] = 1;
+    rateInitiative[t] = 0;
+  }
+}
+
+void GameManager::forkFrom(const GameManager &other) {
+  reset();
+  catalog = other.catalog; // the programs are shared
+  maxRespawnsPerTurn = other.maxRespawnsPerTurn;
+  maxShipRespawns = other.maxShipRespawns;
+  totalIterations = other.totalIterations;
+  rng = other.rng;
+  winningTeam = other.winningTeam;
+  turnsPlayed = other.turnsPlayed;
+  combatMode = other.combatMode;
+  scheduled = other.scheduled;
+  for (int t = 0; t < SHIP_TYPE_COUNT; t++) {
+    ratePeriod[t] = other.ratePeriod[t];
+    rateInitiative[t] = other.rateInitiative[t];
+  }
+  sleeping = other.sleeping;
+  queueHash = other.queueHash;
+  stalemateWindow = other.stalemateWindow;
+  lastHitTurn = other.lastHitTurn;
+  lastHash = other.lastHash;
+  stalemate = other.stalemate;
+
+  // Ships first: the board and the queue find them by fleet index
+  ships.reserve(other.ships.size());
+  for (const Ship *s : other.ships) {
+    Ship *copy = s->clone(this);
+    copy->setBattlefieldPtr(&battlefield);
+    ships.push_back(copy);
+  }
+  battlefield.forkFrom(other.battlefield, ships);
+  respawnQueue.reserve(ships.size());
+  for (const Ship *s : other.respawnQueue) {
+    respawnQueue.push_back(ships[s->getFleetIndex()]);
+  }
+  combat.reserve(ships.size() * MAX_HITS_PER_SHIP);
+
+  if (scheduled) {
+    wheel = other.wheel;
+    touchedMark = other.touchedMark;
+    inWheel = other.inWheel;
+    wasAlive = other.wasAlive;
+    teamOf = other.teamOf;
+    teamAlive = other.teamAlive;
+    teamNames = other.teamNames;
+    teamsAlive = other.teamsAlive;
+    // The next playTurn() clears the marks of the last turn's ships
+    resetTurnMemory();
+    touched.assign(other.touched.begin(), other.touched.end());
+  }
+  if (sleeping) {
+    activity.forkFrom(other.activity, battlefield, teamOf);
+    battlefield.setWatcher(&activity);
+  }
+}
+
+void GameManager::setActionRate(ShipType type, int period, int initiative) {
+  ratePeriod[type] = period > 0 ? period : 1;
+  rateInitiative[type] = initiative;
+  scheduled = true;
+}
+
+void GameManager::setSleeping(bool on) {
+  sleeping = on;
+  if (on) {
+    scheduled = true;
+  }
+}
+
+void GameManager::setJournal(size_t turns) {
+  if (turns > 0 && scheduled) {
+    throw std::runtime_error(
+        "The undo journal needs the every-turn order (no rate or activity "
+        "lines)");
+  }
+  journal.reset(turns > 0 ? new TurnJournal(turns) : nullptr);
+  battlefield.setJournal(journal.get());
+}
+
+int GameManager::rewind(int turns) {
+  if (!journal) {
+    throw std::runtime_error("rewind() needs the undo journal (setJournal)");
+  }
+  // Undoing must not record anything itself
+  battlefield.setJournal(nullptr);
+  int undone = 0;
+  TurnJournal::TurnMark mark;
+  while (undone < turns &&
+         journal->undoTurn(ships, battlefield, respawnQueue, mark)) {
+    rng.setCounter(mark.rngCounter);
+    battlefield.restoreHash(mark.boardHash);
+    queueHash = mark.queueHash;
+    lastHitTurn = mark.lastHitTurn;
+    lastHash = mark.lastHash;
+    turnsPlayed = mark.turn - 1;
+    undone++;
+  }
+  if (undone > 0) {
+    // Only the last turn of a run can have ended it
+    winningTeam.clear();
+    stalemate = false;
+  }
+  battlefield.setJournal(journal.get());
+  return undone;
+}
+
+void GameManager::setBattlefieldTerrain(int width, int height,
+                                        const std::vector<Position> &islands,
+                                        Battlefield::Layout layout) {
+  battlefield.resize(width, height, layout);
+  battlefield.setTerrain(islands);
+}
+
+void GameManager::loadConfig(const GameConfig &config) {
+  // Seed first: ship placement already draws random numbers
+  if (config.hasSeed) {
+    setSeed(config.seed);
+  }
+  setRespawnLimits(config.respawnsPerTurn, config.shipRespawns);
+  setCombatMode(config.combat);
+  setBattlefieldTerrain(config.width, config.height, config.islands,
+                        config.layout);
+  setSleeping(config.sleeping);
+  setStalemateWindow(config.stalemateWindow);
+  for (const auto &rate : config.rates) {
+    ShipType type;
+    if (parseShipType(rate.type, type)) {
+      setActionRate(type, rate.period, rate.initiative);
+    }
+  }
+  catalog.compile(config.shipTypes);
+
+  // For each ShipInfo in config.allShips
+  for (const auto &info : config.allShips) {
+    // For each ship in the count
+    for (int i = 0; i < info.count; i++) {
+      // Build a unique symbol, e.g. "*1", "*2", etc.
+      std::string uniqueSymbol = info.symbol;
+      uniqueSymbol += std::to_string(i + 1);
+
+      // Scripted types (including scripts replacing a built-in) come first
+      const ShipProgram *program = catalog.find(info.type);
+      Ship *newShip =
+          program ? new ScriptedShip(program, uniqueSymbol, info.team, this)
+                  : createShip(info.type, uniqueSymbol, info.team, this);
+      if (!newShip) {
+        std::cerr << "Unknown ship type: " << info.type << std::endl;
+        continue;
+      }
+      // Add the ship if it was successfully created
+      addShip(newShip);
+    }
+  }
+}
+
+void GameManager::loadImage(const ScenarioImage &image,
+                            const uint64_t *seedOverride) {
+  const ImageHeader &h = image.header();
+  if (seedOverride) {
+    setSeed(*seedOverride);
+  } else if (h.hasSeed) {
+    setSeed(h.seed);
+  }
+  setRespawnLimits(h.respawnsPerTurn, h.shipRespawns);
+  setCombatMode(static_cast<CombatBuffer::Mode>(h.combat));
+  battlefield.resize(h.width, h.height,
+                     static_cast<Battlefield::Layout>(h.layout));
+  battlefield.setTerrain(image.runs(), h.runCount);
+  setSleeping(h.sleeping != 0);
+  setStalemateWindow(h.stalemateWindow);
+  if (h.hasRates) {
+    for (int t = BATTLESHIP; t < SHIP_TYPE_COUNT; t++) {
+      if (h.ratePeriod[t]) {
+        setActionRate(static_cast<ShipType>(t), h.ratePeriod[t],
+                      h.rateInitiative[t]);
+      }
+    }
+  }
+
+  // Team names are shared by many ships: build each string once
+  const char *strings = image.strings();
+  std::vector<std::string> teams;
+  teams.reserve(h.teamCount);
+  for (uint64_t t = 0; t < h.teamCount; t++) {
+    const TeamRecord &r = image.teams()[t];
+    teams.emplace_back(strings + r.nameOffset, r.nameLength);
+  }
+
+  // The fleet is already expanded and validated: no parsing, no lookups
+  ships.reserve(ships.size() + h.shipCount);
+  std::string symbol;
+  for (uint64_t i = 0; i < h.shipCount; i++) {
+    const ShipRecord &r = image.ships()[i];
+    symbol.assign(strings + r.symbolOffset, r.symbolLength);
+    addShip(createShip(static_cast<ShipType>(r.type), symbol, teams[r.team],
+                       this));
+  }
 }
 
 void GameManager::addShip(Ship *newShip) {
   if (!newShip)
     return;
   newShip->setBattlefieldPtr(&battlefield);
+  newShip->setFleetIndex(static_cast<int>(ships.size()));
+  // Listed before it is placed: chunked boards look occupants up by index
+  ships.push_back(newShip);
 
-  bool placed = battlefield.placeShipRandomly(newShip);
+  bool placed = battlefield.placeShipRandomly(newShip, rng);
   if (!placed) {
-    std::cout << "Warning: Could not place ship " << newShip->getSymbol()
+    simLog() << "Warning: Could not place ship " << newShip->getSymbol()
               << "!\n";
   }
-  ships.push_back(newShip);
 }
 
-void GameManager::runSimulation(int iterations) {
+void GameManager::prepareRun(int iterations) {
+  // Size the per-turn containers up front, so the turn loop never grows them:
+  // every ship is in the respawn queue at most once, and an upgrade builds
+  // the new ship before the old one's pool slot is released
+  respawnQueue.reserve(ships.size());
+  combat.reserve(ships.size() * MAX_HITS_PER_SHIP);
+  ShipPool::reserve(1);
+
   totalIterations = iterations;
-  for (int turn = 1; turn <= totalIterations; turn++) {
-    std::cout << "\n--- Turn " << turn << " ---\n";
-    battlefield.display(std::cout);
+  winningTeam.clear();
+  turnsPlayed = 0;
+  stalemate = false;
+  lastHitTurn = 0;
+  lastHash = stateHash();
+  if (journal) {
+    setJournal(journal->getKeep()); // empty again, and checks the order
+  }
+
+  if (!scheduled)
+    return;
+
+  // Everyone acts on turn 1, then every ratePeriod turns
+  size_t n = ships.size();
+  wheel.reset(n);
+  resetTurnMemory();
+  touchedMark.assign(n, 0);
+  inWheel.assign(n, 0);
+  wasAlive.assign(n, 0);
+  teamOf.assign(n, 0);
+  teamNames.clear();
+  teamAlive.clear();
+  teamsAlive = 0;
+  for (size_t i = 0; i < n; i++) {
+    const Ship *s = ships[i];
+    size_t t = 0;
+    while (t < teamNames.size() && teamNames[t] != s->getTeam())
+      t++;
+    if (t == teamNames.size()) {
+      teamNames.push_back(s->getTeam());
+      teamAlive.push_back(0);
+    }
+    teamOf[i] = static_cast<int>(t);
+    if (s->isAlive()) {
+      wasAlive[i] = 1;
+      if (teamAlive[t]++ == 0)
+        teamsAlive++;
+      wheel.schedule(static_cast<int32_t>(i), 1);
+      inWheel[i] = 1;
+    }
+  }
+
+  if (sleeping) {
+    activity.reset(battlefield, teamOf);
+    battlefield.setWatcher(&activity);
+  }
+}
+
+void GameManager::resetTurnMemory() {
+  // Let go of last turn's containers before their memory is reused
+  due = std::pmr::vector<int32_t>(&turnArena);
+  touched = std::pmr::vector<int32_t>(&turnArena);
+  turnArena.reset();
+
+  // Sized up front, so the turn never grows them
+  if (scheduled) {
+    due.reserve(ships.size());
+    touched.reserve(ships.size());
+  }
+}
+
+bool GameManager::playTurn(int turn) {
+  if (journal) {
+    TurnJournal::TurnMark mark;
+    mark.turn = turn;
+    mark.rngCounter = rng.getCounter();
+    mark.boardHash = battlefield.getHash();
+    mark.queueHash = queueHash;
+    mark.lastHitTurn = lastHitTurn;
+    mark.lastHash = lastHash;
+    journal->beginTurn(mark);
+  }
+  turnsPlayed = turn;
+  if (scheduled) {
+    for (int32_t i : touched) {
+      touchedMark[i] = 0;
+    }
+  }
+  resetTurnMemory();
+  simLog() << "\n--- Turn " << turn << " ---\n";
+  battlefield.display(simLog());
+
+  processRespawns(); // handle queue
+  if (sleeping) {
+    scheduleWoken();
+  }
+  executeTurn(turn); // all ships do their turn
+  handleUpgrades();  // new step: apply pending upgrades
 
-    processRespawns(); // handle queue
-    executeTurn(turn); // all ships do their turn
-    handleUpgrades();  // new step: apply pending upgrades
+  bool victory = checkVictory();
+  if (victory) {
+    simLog() << "Victory condition met! Ending simulation.\n";
+  } else if (stalemateWindow > 0 && checkStalemate(turn)) {
+    simLog() << "Stalemate! Ending simulation.\n";
+    victory = true; // ends the run all the same
+  }
+  if (observer) {
+    observer->turnEnded(*this, turn);
+  }
+
+  // Hand this turn's text to the writer thread (if any) and move on
+  if (output) {
+    output->endFrame();
+  }
+  return victory;
+}
 
-    if (checkVictory()) {
-      std::cout << "Victory condition met! Ending simulation.\n";
+void GameManager::runSimulation(int iterations) {
+  prepareRun(iterations);
+  for (int turn = 1; turn <= totalIterations; turn++) {
+    if (playTurn(turn)) {
       break;
     }
   }
-  std::cout << "\nSimulation ended after " << totalIterations << " turns.\n";
+  simLog() << "\nSimulation ended after " << totalIterations << " turns.\n";
+  if (output) {
+    output->flush();
+  }
 }
 
 void GameManager::executeTurn(int turnNumber) {
-  // 1) Each alive ship performs its turn
-  for (Ship *s : ships) {
-    if (s->isAlive()) {
+  if (scheduled) {
+    executeScheduledTurn(turnNumber);
+    return;
+  }
+  AllocAudit::Scope audit(AllocAudit::TURN);
+
+  // 1) Each alive ship performs its turn (or the external action, if any)
+  for (size_t i = 0; i < ships.size(); i++) {
+    Ship *s = ships[i];
+    if (!s->isAlive())
+      continue;
+    if (shipActions && shipActions[i] != ACTION_AUTO) {
+      applyAction(s, shipActions[i]);
+    } else if (journal) {
+      performJournaled(s);
+    } else {
       s->performTurn();
     }
   }
 
+  // Batched combat: settle every hit of the turn at once
+  if (combatMode == CombatBuffer::BATCHED) {
+    combat.resolve(battlefield);
+  }
+
   // 2) Handle destroyed ships (respawn queue, etc.)
   for (Ship *s : ships) {
     if (!s->isAlive()) {
@@ -68,32 +444,226 @@ void GameManager::executeTurn(int turnNumber) {
 
   // 3) "Belt & Braces" occupant cleaning
   //    If occupant is not alive => set that cell to nullptr
-  for (int x = 0; x < HEIGHT; x++) {
-    for (int y = 0; y < WIDTH; y++) {
-      Ship *occupant = battlefield.getOccupant(x, y);
-      // occupant is a pointer; if the occupant is dead, remove it
+  //    Every occupant is one of our ships, so walk the ships instead of the
+  //    whole board (which may be huge and mostly empty).
+  for (Ship *s : ships) {
+    if (s->isAlive())
+      continue;
+    Position p = s->getPosition();
+    if (battlefield.inBounds(p.x, p.y) &&
+        battlefield.getOccupant(p.x, p.y) == s) {
+      battlefield.setOccupant(p.x, p.y, nullptr);
+    }
+  }
+}
 
-      if (occupant && !occupant->isAlive()) {
-        battlefield.setOccupant(x, y, nullptr);
-      }
+void GameManager::performJournaled(Ship *s) {
+  // Behaviour state only changes inside the ship's own turn, so compare it
+  // around the call instead of hooking every write
+  int words = 0;
+  int32_t *state = s->behaviourState(words);
+  int32_t before[Ship::MAX_STATE_WORDS];
+  std::copy(state, state + words, before);
+  s->performTurn();
+  for (int w = 0; w < words; w++) {
+    if (state[w] != before[w]) {
+      journal->state(s, w, before[w]);
+    }
+  }
+}
+
+void GameManager::touch(const Ship *s) {
+  int i = s->getFleetIndex();
+  if (!touchedMark[i]) {
+    touchedMark[i] = 1;
+    touched.push_back(i);
+  }
+}
+
+void GameManager::executeScheduledTurn(int turnNumber) {
+  AllocAudit::Scope audit(AllocAudit::TURN);
+
+  // 1) The ships due this turn act, by initiative, then fleet order
+  due.clear();
+  while (wheel.getNow() < static_cast<uint64_t>(turnNumber)) {
+    wheel.advance(due);
+  }
+  std::sort(due.begin(), due.end(), [this](int32_t a, int32_t b) {
+    int ia = rateInitiative[ships[a]->getType()];
+    int ib = rateInitiative[ships[b]->getType()];
+    return ia != ib ? ia > ib : a < b;
+  });
+  for (int32_t i : due) {
+    inWheel[i] = 0;
+  }
+  for (int32_t i : due) {
+    Ship *s = ships[i];
+    if (!s->isAlive())
+      continue; // sunk: drops out of the wheel
+    touch(s);
+    if (shipActions && shipActions[i] != ACTION_AUTO) {
+      applyAction(s, shipActions[i]);
+    } else {
+      s->performTurn();
+    }
+    if (s->isAlive() && !inWheel[i] && !(sleeping && activity.trySleep(s))) {
+      wheel.schedule(i, turnNumber + ratePeriod[s->getType()]);
+      inWheel[i] = 1;
+    }
+  }
+
+  if (combatMode == CombatBuffer::BATCHED) {
+    combat.resolve(battlefield);
+  }
+  if (sleeping) {
+    scheduleWoken();
+  }
+
+  // 2) and 3) as in executeTurn, for the touched ships only: nobody else
+  // can have died or been placed this turn. Fleet order keeps the respawn
+  // queue in the same order as the full walk.
+  std::sort(touched.begin(), touched.end());
+  for (int32_t i : touched) {
+    Ship *s = ships[i];
+    if (s->isAlive())
+      continue;
+    if (s->canRespawn(maxShipRespawns)) {
+      enqueueRespawn(s);
+    }
+    Position p = s->getPosition();
+    if (battlefield.inBounds(p.x, p.y) &&
+        battlefield.getOccupant(p.x, p.y) == s) {
+      battlefield.setOccupant(p.x, p.y, nullptr);
+    }
+  }
+}
+
+void GameManager::scheduleWoken() {
+  // Woken before the turn's ships act: this turn, otherwise the next one
+  std::vector<int32_t> &woken = activity.takeWoken();
+  for (int32_t i : woken) {
+    if (ships[i]->isAlive() && !inWheel[i] && !activity.isAsleep(i)) {
+      wheel.schedule(i, wheel.getNow() + 1);
+      inWheel[i] = 1;
+    }
+  }
+  woken.clear();
+}
+
+void GameManager::applyAction(Ship *s, int action) {
+  // One step in a fixed direction if the cell is free, like move()
+  static const int DX[4] = {-1, 1, 0, 0};
+  static const int DY[4] = {0, 0, -1, 1};
+  int step = -1;
+  bool attack = false;
+  if (action >= ACTION_UP && action <= ACTION_RIGHT) {
+    step = action - ACTION_UP;
+  } else if (action >= ACTION_UP_ATTACK && action <= ACTION_RIGHT_ATTACK) {
+    step = action - ACTION_UP_ATTACK;
+    attack = true;
+  } else if (action == ACTION_ATTACK) {
+    attack = true;
+  } // ACTION_HOLD (or unknown): do nothing this turn
+
+  if (step >= 0) {
+    Position p = s->getPosition();
+    int nx = p.x + DX[step];
+    int ny = p.y + DY[step];
+    if (battlefield.isFree(nx, ny)) {
+      battlefield.setOccupant(p.x, p.y, nullptr);
+      battlefield.setOccupant(nx, ny, s);
+    }
+  }
+
+  // The ship's own turn from where it now is, minus its own step
+  if (attack) {
+    s->setAnchored(true);
+    if (journal) {
+      performJournaled(s);
+    } else {
+      s->performTurn();
     }
+    s->setAnchored(false);
   }
 }
 
+void GameManager::applyHit(Ship *attacker, Ship *target, int x, int y,
+                           int damage) {
+  lastHitTurn = turnsPlayed;
+  if (scheduled) {
+    touch(target);
+    if (sleeping) {
+      activity.wake(target->getFleetIndex());
+    }
+  }
+  if (combatMode == CombatBuffer::BATCHED) {
+    combat.addShot(attacker, target, x, y, damage, battlefield.getWidth());
+    return;
+  }
+  target->takeDamage(damage);
+  if (!target->isAlive()) {
+    attacker->recordKill();
+  }
+}
+
+void GameManager::applyRam(Ship *attacker, Ship *target, int x, int y) {
+  lastHitTurn = turnsPlayed;
+  if (scheduled) {
+    touch(target);
+    if (sleeping) {
+      activity.wake(target->getFleetIndex());
+    }
+  }
+  if (combatMode == CombatBuffer::BATCHED) {
+    combat.addRam(attacker, target, x, y, battlefield.getWidth());
+    return;
+  }
+  target->takeDamage(target->getLives());
+  attacker->recordKill();
+  // move in
+  Position p = attacker->getPosition();
+  battlefield.setOccupant(p.x, p.y, nullptr);
+  battlefield.setOccupant(x, y, attacker);
+}
+
 void GameManager::enqueueRespawn(Ship *deadShip) {
+  // A ship waits in the queue once, however many turns it stays there
+  if (deadShip->isAwaitingRespawn())
+    return;
+  deadShip->setAwaitingRespawn(true);
+  if (journal) {
+    journal->queuePush();
+  }
   respawnQueue.push_back(deadShip);
+  queueHash ^= Zobrist::queueKey(deadShip->getFleetIndex());
 }
 
 void GameManager::processRespawns() {
+  AllocAudit::Scope audit(AllocAudit::RESPAWNS);
+
   int respawnsThisTurn = 0;
   auto it = respawnQueue.begin();
   while (it != respawnQueue.end() && respawnsThisTurn < maxRespawnsPerTurn) {
     Ship *s = *it;
-    bool placed = battlefield.placeShipRandomly(s);
+    bool placed = battlefield.placeShipRandomly(s, rng);
     if (placed) {
       s->incrementRespawnCount();
+      s->setAwaitingRespawn(false);
+      queueHash ^= Zobrist::queueKey(s->getFleetIndex());
+      if (journal) {
+        journal->queueErase(
+            static_cast<size_t>(it - respawnQueue.begin()), s);
+      }
       it = respawnQueue.erase(it);
       respawnsThisTurn++;
+      if (scheduled) {
+        touch(s);
+        int i = s->getFleetIndex();
+        if (s->isAlive() && !inWheel[i]) {
+          wheel.schedule(i, turnsPlayed);
+          inWheel[i] = 1;
+        }
+      }
     } else {
       ++it;
     }
@@ -102,86 +672,184 @@ void GameManager::processRespawns() {
 
 // NEW method: after each turn, we check if a ship requested upgrade
 void GameManager::handleUpgrades() {
-  for (Ship *s : ships) {
+  AllocAudit::Scope audit(AllocAudit::UPGRADES);
+
+  // Only a ship that acted can have earned an upgrade this turn
+  size_t count = scheduled ? touched.size() : ships.size();
+  for (size_t k = 0; k < count; k++) {
+    Ship *s = scheduled ? ships[touched[k]] : ships[k];
     // only do something if it's alive
     if (s->isAlive()) {
-      std::string upgradeType = s->getPendingUpgradeType();
-      if (!upgradeType.empty()) {
+      ShipType upgradeType = s->getPendingUpgradeType();
+      if (upgradeType != SHIP_NONE) {
+        // Cleared first: upgradeShip() deletes `s`
+        s->clearPendingUpgrade();
         upgradeShip(s, upgradeType);
         // no need to 'return;' because we are deferring
         // but we can break if you'd like to avoid re-checking the new ship
-        // For safety, we might also do `s->clearPendingUpgrade()`
-        // inside upgradeShip. But let's do it after:
-        s->clearPendingUpgrade();
       }
     }
   }
 }
 
-void GameManager::upgradeShip(Ship *oldShip, const std::string &newType) {
-  auto it = std::find(ships.begin(), ships.end(), oldShip);
-  if (it == ships.end()) {
-    std::cout << "Error: upgradeShip could not find oldShip.\n";
+void GameManager::upgradeShip(Ship *oldShip, ShipType newType) {
+  int index = oldShip->getFleetIndex();
+  if (index < 0 || static_cast<size_t>(index) >= ships.size() ||
+      ships[index] != oldShip) {
+    simLog() << "Error: upgradeShip could not find oldShip.\n";
     return;
   }
+  // The new ship takes the old one's name: keep a copy to undo the upgrade
+  if (journal) {
+    journal->upgrade(oldShip, oldShip->clone(this));
+  }
 
+  // The new ship comes from ShipPool (see Ship::operator new). A scripted
+  // target, or a script replacing the built-in target type, wins.
+  const ShipProgram *program = oldShip->getUpgradeProgram();
+  if (!program) {
+    program = catalog.find(newType);
+  }
   Ship *newShip = nullptr;
-  if (newType == "Destroyer") {
-    newShip = new Destroyer(*oldShip, this);
-  } else if (newType == "SuperShip") {
-    newShip = new SuperShip(*oldShip, this);
-  } else if (newType == "Corvette") {
-    newShip = new Corvette(*oldShip, this);
+  if (program) {
+    newShip = new ScriptedShip(*oldShip, program, this);
   } else {
-    std::cout << "Unknown upgrade type: " << newType << std::endl;
-    return;
+    switch (newType) {
+    case DESTROYER:
+      newShip = new Destroyer(*oldShip, this);
+      break;
+    case SUPERSHIP:
+      newShip = new SuperShip(*oldShip, this);
+      break;
+    case CORVETTE:
+      newShip = new Corvette(*oldShip, this);
+      break;
+    default:
+      simLog() << "Unknown upgrade type: " << shipTypeName(newType)
+               << std::endl;
+      return;
+    }
   }
 
   if (!newShip) {
-    std::cout << "Failed to create newShip.\n";
+    simLog() << "Failed to create newShip.\n";
     return;
   }
 
   // old position
   Position oldPos = oldShip->getPosition();
   // remove occupant
-  if (oldPos.x >= 0 && oldPos.x < HEIGHT && oldPos.y >= 0 && oldPos.y < WIDTH) {
+  if (battlefield.inBounds(oldPos.x, oldPos.y)) {
     battlefield.setOccupant(oldPos.x, oldPos.y, nullptr);
   }
 
-  std::cout << "Upgrading ship at (" << oldPos.x << ", " << oldPos.y
+  simLog() << "Upgrading ship at (" << oldPos.x << ", " << oldPos.y
             << "): old ship " << oldShip << " -> new ship " << newShip << "\n";
 
   // place new occupant
   battlefield.setOccupant(oldPos.x, oldPos.y, newShip);
 
   // replace in ships vector
-  *it = newShip;
+  ships[index] = newShip;
 
   // delete old
   delete oldShip;
   battlefield.setOccupant(oldPos.x, oldPos.y, nullptr);
 
-  std::cout << "Ship upgraded to " << newType << " at (" << oldPos.x << ", "
+  simLog() << "Ship upgraded to " << shipTypeName(newType) << " at (" << oldPos.x << ", "
             << oldPos.y << ")\n";
 }
 
-bool GameManager::checkVictory() const {
-  std::string survivingTeam;
+bool GameManager::checkVictory() {
+  if (scheduled) {
+    return checkVictoryScheduled();
+  }
+  // Point at the first survivor's team name rather than copying it
+  const std::string *survivingTeam = nullptr;
   for (Ship *s : ships) {
     if (s->isAlive()) {
-      if (survivingTeam.empty()) {
-        survivingTeam = s->getTeam();
-      } else if (survivingTeam != s->getTeam()) {
+      if (!survivingTeam) {
+        survivingTeam = &s->getTeam();
+      } else if (*survivingTeam != s->getTeam()) {
         // more than one team
         return false;
       }
     }
   }
-  if (!survivingTeam.empty()) {
-    std::cout << "Team " << survivingTeam << " is victorious!\n";
+  if (survivingTeam) {
+    winningTeam = *survivingTeam;
+    simLog() << "Team " << *survivingTeam << " is victorious!\n";
     return true;
   }
   // else no ships alive => draw
   return false;
 }
+
+bool GameManager::checkVictoryScheduled() {
+  // Keep the per-team alive counts up to date from the touched ships
+  for (int32_t i : touched) {
+    uint8_t alive = ships[i]->isAlive() ? 1 : 0;
+    if (alive == wasAlive[i])
+      continue;
+    wasAlive[i] = alive;
+    int t = teamOf[i];
+    if (alive) {
+      if (teamAlive[t]++ == 0)
+        teamsAlive++;
+    } else if (--teamAlive[t] == 0) {
+      teamsAlive--;
+    }
+  }
+  if (teamsAlive != 1)
+    return false; // several teams left, or nobody (a draw)
+
+  size_t t = 0;
+  while (teamAlive[t] == 0)
+    t++;
+  winningTeam = teamNames[t];
+  simLog() << "Team " << winningTeam << " is victorious!\n";
+  return true;
+}
+
+bool GameManager::checkStalemate(int turn) {
+  uint64_t hash = stateHash();
+  bool unchanged = (hash == lastHash);
+  lastHash = hash;
+
+  // No shot or ram has hit for a whole window
+  if (turn - lastHitTurn >= stalemateWindow) {
+    simLog() << "No hits in the last " << stalemateWindow << " turns.\n";
+    stalemate = true;
+    return true;
+  }
+
+  // Frozen world: nothing changed this turn, nothing was hit, and every
+  // survivor is a Frigate or Corvette (they never move) with no enemy next
+  // to it, or a script that never moves and reaches no further. Respawned
+  // ships never come back alive, so it stays like this.
+  if (!unchanged || lastHitTurn == turn)
+    return false;
+  for (const Ship *s : ships) {
+    if (!s->isAlive())
+      continue;
+    const ShipProgram *program = s->getProgram();
+    bool still = program ? program->stationary && program->reach >= 0 &&
+                               program->reach <= 1
+                         : s->getType() == FRIGATE || s->getType() == CORVETTE;
+    if (!still)
+      return false;
+    Position p = s->getPosition();
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        if (!battlefield.inBounds(p.x + dx, p.y + dy))
+          continue;
+        const Ship *o = battlefield.getOccupant(p.x + dx, p.y + dy);
+        if (o && o != s && o->isAlive() && o->getTeam() != s->getTeam())
+          return false;
+      }
+    }
+  }
+  simLog() << "Every survivor is stationary and out of reach.\n";
+  stalemate = true;
+  return true;
+}
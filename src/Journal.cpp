@@ -0,0 +1,230 @@
+#include "Journal.h"
+#include "Battlefield.h"
+#include "GameManager.h"
+#include "Log.h"
+#include "Ship.h"
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+TurnJournal::TurnJournal(size_t keepTurns)
+    : keep(keepTurns > 0 ? keepTurns : 1), front(0), upgradeFront(0) {}
+
+TurnJournal::~TurnJournal() {
+  for (size_t i = upgradeFront; i < upgraded.size(); i++) {
+    delete upgraded[i];
+  }
+}
+
+void TurnJournal::dropOldest() {
+  turns.pop_front();
+  size_t end = turns.empty() ? entries.size() : turns.front().begin;
+  size_t upgradeEnd =
+      turns.empty() ? upgraded.size() : turns.front().upgradeBegin;
+  for (size_t i = upgradeFront; i < upgradeEnd; i++) {
+    delete upgraded[i];
+  }
+  front = end;
+  upgradeFront = upgradeEnd;
+
+  // Slide the kept turns to the start once the dropped part is half of the
+  // buffer: amortised O(1) per entry, and memory stays at about two windows
+  if (front > entries.size() / 2) {
+    entries.erase(entries.begin(), entries.begin() + front);
+    upgraded.erase(upgraded.begin(), upgraded.begin() + upgradeFront);
+    for (TurnMark &m : turns) {
+      m.begin -= front;
+      m.upgradeBegin -= upgradeFront;
+    }
+    front = 0;
+    upgradeFront = 0;
+  }
+}
+
+void TurnJournal::beginTurn(const TurnMark &mark) {
+  while (turns.size() >= keep) {
+    dropOldest();
+  }
+  turns.push_back(mark);
+  turns.back().begin = entries.size();
+  turns.back().upgradeBegin = upgraded.size();
+}
+
+void TurnJournal::cell(int x, int y, const Ship *previous, const Ship *next) {
+  push(CELL, previous ? previous->getFleetIndex() + 1 : 0, x, y);
+  if (next) {
+    Position p = next->getPosition();
+    push(POSITION, next->getFleetIndex(), p.x, p.y);
+  }
+}
+
+void TurnJournal::lives(const Ship *s) {
+  push(LIVES, s->getFleetIndex(), s->getLives(), 0);
+}
+
+void TurnJournal::kills(const Ship *s) {
+  push(KILLS, s->getFleetIndex(), s->getKillCount(), 0);
+}
+
+void TurnJournal::respawn(const Ship *s) {
+  push(RESPAWN, s->getFleetIndex(), s->getRespawnCount(),
+       s->isAwaitingRespawn() ? 1 : 0);
+}
+
+void TurnJournal::pending(const Ship *s) {
+  push(PENDING, s->getFleetIndex(), s->getPendingUpgradeType(), 0);
+}
+
+void TurnJournal::state(const Ship *s, int word, int32_t previous) {
+  push(STATE, s->getFleetIndex(), word, previous);
+}
+
+void TurnJournal::queuePush() { push(QUEUE_PUSH, 0, 0, 0); }
+
+void TurnJournal::queueErase(size_t position, const Ship *s) {
+  push(QUEUE_ERASE, s->getFleetIndex(), static_cast<int32_t>(position), 0);
+}
+
+void TurnJournal::upgrade(const Ship *s, Ship *replaced) {
+  push(UPGRADE, s->getFleetIndex(), static_cast<int32_t>(upgraded.size()), 0);
+  upgraded.push_back(replaced);
+}
+
+bool TurnJournal::undoTurn(std::vector<Ship *> &ships, Battlefield &bf,
+                           std::vector<Ship *> &queue, TurnMark &mark) {
+  if (turns.empty())
+    return false;
+  mark = turns.back();
+  turns.pop_back();
+
+  // Newest first. Ships are looked up when the entry is undone, so an entry
+  // made after an upgrade finds the new ship and one made before it the old.
+  for (size_t k = entries.size(); k-- > mark.begin;) {
+    const Entry &e = entries[k];
+    switch (e.op) {
+    case CELL:
+      bf.restoreOccupant(e.a, e.b, e.ship ? ships[e.ship - 1] : nullptr);
+      break;
+    case POSITION:
+      ships[e.ship]->setPosition(e.a, e.b);
+      break;
+    case LIVES:
+      ships[e.ship]->lives = e.a;
+      break;
+    case KILLS:
+      ships[e.ship]->killCount = e.a;
+      break;
+    case RESPAWN:
+      ships[e.ship]->respawnCount = e.a;
+      ships[e.ship]->awaitingRespawn = e.b != 0;
+      break;
+    case PENDING:
+      ships[e.ship]->pendingUpgrade = static_cast<ShipType>(e.a);
+      break;
+    case STATE: {
+      int words = 0;
+      int32_t *state = ships[e.ship]->behaviourState(words);
+      if (e.a < words)
+        state[e.a] = e.b;
+      break;
+    }
+    case QUEUE_PUSH:
+      queue.pop_back();
+      break;
+    case QUEUE_ERASE:
+      queue.insert(queue.begin() + e.a, ships[e.ship]);
+      break;
+    case UPGRADE: {
+      Ship *now = ships[e.ship];
+      Ship *old = upgraded[e.a];
+      upgraded[e.a] = nullptr;
+      ships[e.ship] = old;
+      // Pointer boards may still hold the new ship where the old one stood
+      Position p = old->getPosition();
+      if (bf.inBounds(p.x, p.y) && bf.getOccupant(p.x, p.y) == now) {
+        bf.restoreOccupant(p.x, p.y, old);
+      }
+      delete now;
+      break;
+    }
+    }
+  }
+  entries.resize(mark.begin);
+  upgraded.resize(mark.upgradeBegin);
+  return true;
+}
+
+namespace {
+
+void printStatus(const GameManager &game, std::ostream &out) {
+  const TurnJournal *journal = game.getJournal();
+  out << "turn " << game.getTurnsPlayed() << ", hash " << std::hex
+      << std::setw(16) << std::setfill('0') << game.stateHash() << std::dec
+      << std::setfill(' ') << ", journal " << journal->turnsKept() << "/"
+      << journal->getKeep() << " turns (" << journal->entryCount()
+      << " entries, " << journal->memoryUsage() / 1024 << " KiB)";
+  if (!game.getWinningTeam().empty()) {
+    out << ", team " << game.getWinningTeam() << " won";
+  } else if (game.isStalemate()) {
+    out << ", stalemate";
+  }
+  out << "\n";
+}
+
+} // namespace
+
+int runStepper(const GameConfig &config, size_t keep, std::istream &in,
+               std::ostream &out) {
+  GameManager game;
+  {
+    ScopedLog quiet(nullLog());
+    game.loadConfig(config);
+    game.prepareRun(config.iterations);
+    game.setJournal(keep);
+  }
+  out << "Commands: next [N], back [N], show, quit\n";
+  printStatus(game, out);
+
+  bool over = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream words(line);
+    std::string command;
+    if (!(words >> command))
+      continue;
+    int count = 1;
+    words >> count;
+
+    if (command == "next" || command == "n") {
+      ScopedLog log(out);
+      for (int k = 0; k < count && !over; k++) {
+        int turn = game.getTurnsPlayed() + 1;
+        if (turn > game.getTotalIterations()) {
+          over = true;
+          break;
+        }
+        over = game.playTurn(turn);
+      }
+      if (over) {
+        out << "(end of the battle; back to step back)\n";
+      }
+    } else if (command == "back" || command == "b") {
+      int undone = game.rewind(count);
+      if (undone < count) {
+        out << "(stepped back " << undone << ", no older turns kept)\n";
+      }
+      if (undone > 0) {
+        over = false;
+      }
+    } else if (command == "show" || command == "s") {
+      game.getBattlefield().display(out);
+    } else if (command == "quit" || command == "q") {
+      break;
+    } else {
+      out << "Unknown command: " << command << "\n";
+      continue;
+    }
+    printStatus(game, out);
+  }
+  return 0;
+}
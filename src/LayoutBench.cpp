@@ -0,0 +1,189 @@
+#include "LayoutBench.h"
+#include "GameManager.h"
+#include "Log.h"
+#include "ShipTypes.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Hardware cache-miss counter for this thread; reads -1 when the kernel
+// does not let us use perf events (containers, CI, non-Linux)
+class CacheMissCounter {
+private:
+  int fd;
+
+public:
+  CacheMissCounter() : fd(-1) {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (fd >= 0)
+      close(fd);
+#endif
+  }
+
+  void start() {
+#ifdef __linux__
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  long long stop() {
+#ifdef __linux__
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      long long count = 0;
+      if (read(fd, &count, sizeof(count)) == sizeof(count))
+        return count;
+    }
+#endif
+    return -1;
+  }
+};
+
+struct BenchResult {
+  double nsPerProbe;
+  double missesPerProbe; // < 0 if unavailable
+  uint64_t checksum;
+};
+
+// Enemy ships inside the city-block diamond of each ship, the shape of the
+// Battleship / Destroyer / Amphibious weapon reach
+uint64_t diamondScan(const Battlefield &bf, const std::vector<Ship *> &ships,
+                     long long &probes) {
+  uint64_t found = 0;
+  for (const Ship *s : ships) {
+    Position p = s->getPosition();
+    for (int dx = -MAX_WEAPON_REACH; dx <= MAX_WEAPON_REACH; dx++) {
+      int reach = MAX_WEAPON_REACH - (dx < 0 ? -dx : dx);
+      for (int dy = -reach; dy <= reach; dy++) {
+        Ship *occ = bf.getOccupant(p.x + dx, p.y + dy);
+        found += (occ && occ != s) ? 1 : 0;
+        probes++;
+      }
+    }
+  }
+  return found;
+}
+
+uint64_t neighbourScan(const Battlefield &bf, const std::vector<Ship *> &ships,
+                       long long &probes) {
+  uint64_t found = 0;
+  BoardKernels::NeighbourScan scan;
+  for (const Ship *s : ships) {
+    Position p = s->getPosition();
+    if (bf.scanNeighbours(p.x, p.y, s, scan)) {
+      found += static_cast<uint64_t>(scan.enemyX * 31 + scan.enemyY);
+    }
+    found += static_cast<uint64_t>(scan.freeX + scan.freeY);
+    probes += BoardKernels::NEIGHBOUR_COUNT;
+  }
+  return found;
+}
+
+BenchResult measure(Battlefield::Layout layout, int size, int reps) {
+  ScopedLog quiet(nullLog());
+
+  GameManager manager;
+  manager.setSeed(1); // same ships in the same cells for every layout
+  manager.setBattlefieldTerrain(size, size, std::vector<Position>(), layout);
+
+  // ~0.25% of the cells hold a ship, two teams
+  long long shipCount = static_cast<long long>(size) * size / 400;
+  if (shipCount < 2)
+    shipCount = 2;
+  for (long long i = 0; i < shipCount; i++) {
+    manager.addShip(createShip("Battleship", "*", (i % 2) ? "A" : "B",
+                               &manager));
+  }
+
+  const Battlefield &bf = manager.getBattlefield();
+  const std::vector<Ship *> &ships = manager.getShips();
+
+  CacheMissCounter counter;
+  long long probes = 0;
+  uint64_t checksum = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  counter.start();
+  for (int r = 0; r < reps; r++) {
+    checksum += diamondScan(bf, ships, probes);
+    checksum += neighbourScan(bf, ships, probes);
+  }
+  long long misses = counter.stop();
+  auto t1 = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+  BenchResult res;
+  res.nsPerProbe = ns / static_cast<double>(probes);
+  res.missesPerProbe =
+      misses < 0 ? -1.0 : static_cast<double>(misses) / probes;
+  res.checksum = checksum;
+  return res;
+}
+
+} // namespace
+
+int runLayoutBench(int size, int reps) {
+  const Battlefield::Layout layouts[] = {Battlefield::DENSE,
+                                         Battlefield::TILED,
+                                         Battlefield::MORTON,
+                                         Battlefield::CHUNKED};
+
+  std::cout << "Layout benchmark: " << size << "x" << size << " board, "
+            << reps << " reps\n";
+  std::cout << "layout    ns/probe  misses/probe  checksum\n";
+
+  uint64_t reference = 0;
+  bool consistent = true;
+  for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+    BenchResult r = measure(layouts[i], size, reps);
+    if (i == 0)
+      reference = r.checksum;
+    consistent = consistent && (r.checksum == reference);
+
+    char line[128];
+    if (r.missesPerProbe < 0) {
+      std::snprintf(line, sizeof(line), "%-8s  %8.3f  %12s  %llu\n",
+                    Battlefield::layoutName(layouts[i]), r.nsPerProbe, "n/a",
+                    static_cast<unsigned long long>(r.checksum));
+    } else {
+      std::snprintf(line, sizeof(line), "%-8s  %8.3f  %12.4f  %llu\n",
+                    Battlefield::layoutName(layouts[i]), r.nsPerProbe,
+                    r.missesPerProbe,
+                    static_cast<unsigned long long>(r.checksum));
+    }
+    std::cout << line;
+  }
+
+  if (!consistent) {
+    std::cerr << "Layouts disagree on the scan results!\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,461 @@
+#include "Lockstep.h"
+#include "Ship.h"
+#include "WeaponPatterns.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Kill count at which a type asks for an upgrade, and what it becomes
+// (the recordKill() overrides in ShipTypes.cpp)
+struct UpgradeRule {
+  int kills;
+  ShipType into;
+};
+
+UpgradeRule upgradeRule(int type) {
+  switch (type) {
+  case BATTLESHIP:
+    return {4, DESTROYER};
+  case CRUISER:
+    return {3, DESTROYER};
+  case DESTROYER:
+    return {3, SUPERSHIP};
+  case FRIGATE:
+    return {3, CORVETTE};
+  case AMPHIBIOUS:
+    return {4, SUPERSHIP};
+  default:
+    return {0, SHIP_NONE};
+  }
+}
+
+// move() directions: up, down, left, right, then the diagonals (SuperShip)
+const int STEP_X[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+const int STEP_Y[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+
+} // namespace
+
+bool LockstepEngine::supports(const GameConfig &config, std::string &reason) {
+  int ships = 0;
+  for (const GameConfig::ShipInfo &info : config.allShips) {
+    ShipType t;
+    if (!parseShipType(info.type, t)) {
+      reason = "unknown ship type " + info.type;
+      return false;
+    }
+    ships += info.count;
+  }
+  if (config.combat != CombatBuffer::IMMEDIATE) {
+    reason = "batched combat";
+  } else if (!config.rates.empty() || config.sleeping) {
+    reason = config.sleeping ? "activity sleep" : "action rates";
+  } else if (config.stalemateWindow > 0) {
+    reason = "stalemate detection";
+  } else if (!config.shipTypes.empty()) {
+    reason = "scripted ship types";
+  } else if (config.width * config.height > MAX_CELLS) {
+    reason = "board larger than " + std::to_string(MAX_CELLS) + " cells";
+  } else if (ships > MAX_SHIPS) {
+    reason = "more than " + std::to_string(MAX_SHIPS) + " ships";
+  } else if (SweepRunner::teamsOf(config).size() > 255) {
+    reason = "too many teams";
+  } else {
+    return true;
+  }
+  return false;
+}
+
+LockstepEngine::LockstepEngine(const GameConfig &config)
+    : width(config.width), height(config.height),
+      iterations(config.iterations), perTurn(config.respawnsPerTurn),
+      perShip(config.shipRespawns), shipCount(0) {
+  std::string reason;
+  if (!supports(config, reason)) {
+    throw std::runtime_error("Lockstep engine: " + reason);
+  }
+
+  teamNames = SweepRunner::teamsOf(config);
+  for (const std::string &t : teamNames) {
+    teamKeys.push_back(Zobrist::teamKey(t));
+  }
+  for (const GameConfig::ShipInfo &info : config.allShips) {
+    ShipType t = SHIP_NONE;
+    parseShipType(info.type, t);
+    uint8_t team = 0;
+    while (teamNames[team] != info.team)
+      team++;
+    for (int i = 0; i < info.count; i++) {
+      shipType.push_back(static_cast<uint8_t>(t));
+      shipTeam.push_back(team);
+    }
+  }
+  shipCount = static_cast<int>(shipType.size());
+
+  cells = width * height;
+  islands.assign((cells + 63) / 64, 0);
+  for (const Position &p : config.islands) {
+    if (inBounds(p.x, p.y)) {
+      int c = p.x * width + p.y;
+      islands[c >> 6] |= uint64_t(1) << (c & 63);
+    }
+  }
+
+  occupant.assign(static_cast<size_t>(cells) * LANES, 0);
+  size_t n = static_cast<size_t>(shipCount) * LANES;
+  posX.assign(n, -1);
+  posY.assign(n, -1);
+  lives.assign(n, 0);
+  kills.assign(n, 0);
+  respawns.assign(n, 0);
+  type.assign(n, SHIP_NONE);
+  pending.assign(n, SHIP_NONE);
+  awaiting.assign(n, 0);
+  firing.assign(n, 0);
+  queue.assign(n, 0);
+}
+
+void LockstepEngine::setOccupant(int x, int y, int lane, int ship) {
+  if (inBounds(x, y)) {
+    occupant[cellAt(x * width + y, lane)] = static_cast<uint8_t>(ship + 1);
+  }
+  posX[shipAt(ship, lane)] = static_cast<int16_t>(x);
+  posY[shipAt(ship, lane)] = static_cast<int16_t>(y);
+}
+
+void LockstepEngine::clearOccupant(int x, int y, int lane) {
+  if (inBounds(x, y)) {
+    occupant[cellAt(x * width + y, lane)] = 0;
+  }
+}
+
+bool LockstepEngine::placeRandomly(int ship, int lane) {
+  // Battlefield::placeShipRandomly()
+  for (int i = 0; i < 100; i++) {
+    int rx = rng[lane].nextInt(height);
+    int ry = rng[lane].nextInt(width);
+    if (!isIsland(rx, ry) && !occupantAt(rx, ry, lane)) {
+      setOccupant(rx, ry, lane, ship);
+      return true;
+    }
+  }
+  return false;
+}
+
+void LockstepEngine::takeDamage(int ship, int lane, int damage) {
+  int s = shipAt(ship, lane);
+  lives[s] = static_cast<int16_t>(lives[s] - damage);
+  if (lives[s] <= 0) {
+    lives[s] = 0;
+    int x = posX[s], y = posY[s];
+    if (occupantAt(x, y, lane) == ship + 1) {
+      clearOccupant(x, y, lane);
+    }
+  }
+}
+
+void LockstepEngine::recordKill(int ship, int lane) {
+  int s = shipAt(ship, lane);
+  kills[s]++;
+  UpgradeRule rule = upgradeRule(type[s]);
+  if (rule.into != SHIP_NONE && kills[s] >= rule.kills) {
+    pending[s] = static_cast<uint8_t>(rule.into);
+  }
+}
+
+void LockstepEngine::hit(int attacker, int lane, int x, int y) {
+  int target = occupantAt(x, y, lane) - 1;
+  if (target < 0 || !alive(target, lane) || target == attacker ||
+      shipTeam[target] == shipTeam[attacker])
+    return;
+  takeDamage(target, lane, 1);
+  if (!alive(target, lane)) {
+    recordKill(attacker, lane);
+  }
+}
+
+void LockstepEngine::ram(int attacker, int lane, int x, int y) {
+  // Ship::isWithinBoundary() is true on the board, which ends every ram
+  int s = shipAt(attacker, lane);
+  if (inBounds(posX[s], posY[s]))
+    return;
+  int target = occupantAt(x, y, lane) - 1;
+  if (target < 0 || !alive(target, lane) || target == attacker ||
+      shipTeam[target] == shipTeam[attacker])
+    return;
+  takeDamage(target, lane, lives[shipAt(target, lane)]);
+  recordKill(attacker, lane);
+  clearOccupant(posX[s], posY[s], lane);
+  setOccupant(x, y, lane, attacker);
+}
+
+bool LockstepEngine::scan(int ship, int lane, int &ex, int &ey, int &fx,
+                          int &fy) const {
+  // BoardKernels::scanNeighbours()
+  int x = posX[shipAt(ship, lane)], y = posY[shipAt(ship, lane)];
+  fx = fy = -1;
+  for (int i = 0; i < WeaponPatterns::RING_1.size; i++) {
+    int nx = x + WeaponPatterns::RING_1[i].dx;
+    int ny = y + WeaponPatterns::RING_1[i].dy;
+    int occ = occupantAt(nx, ny, lane) - 1;
+    if (occ >= 0 && alive(occ, lane) && occ != ship &&
+        shipTeam[occ] != shipTeam[ship]) {
+      ex = nx;
+      ey = ny;
+      return true;
+    } else if (occ < 0 && fx < 0 && inBounds(nx, ny)) {
+      fx = nx;
+      fy = ny;
+    }
+  }
+  return false;
+}
+
+void LockstepEngine::step4(int ship, int lane) {
+  int s = shipAt(ship, lane);
+  int dir = rng[lane].nextInt(4);
+  int nx = posX[s] + STEP_X[dir], ny = posY[s] + STEP_Y[dir];
+  if (isFree(nx, ny, lane)) {
+    clearOccupant(posX[s], posY[s], lane);
+    setOccupant(nx, ny, lane, ship);
+  }
+}
+
+void LockstepEngine::shootDiamond(int ship, int lane) {
+  // Battleship / Destroyer / Amphibious: two shots at city-block distance
+  // 1..5. Like the object engine, a ship on the board never fires.
+  int s = shipAt(ship, lane);
+  int x = posX[s], y = posY[s];
+  for (int i = 0; i < 2; i++) {
+    const WeaponPatterns::Offset &o =
+        WeaponPatterns::sample(WeaponPatterns::DIAMOND_5, rng[lane]);
+    if (!inBounds(x, y)) {
+      hit(ship, lane, x + o.dx, y + o.dy);
+    }
+  }
+}
+
+void LockstepEngine::startLane(int lane, uint64_t seed) {
+  rng[lane].seed(seed);
+  for (int c = 0; c < width * height; c++) {
+    occupant[cellAt(c, lane)] = 0;
+  }
+  for (int i = 0; i < shipCount; i++) {
+    int s = shipAt(i, lane);
+    posX[s] = posY[s] = -1;
+    lives[s] = DEFAULT_LIVES;
+    kills[s] = respawns[s] = 0;
+    type[s] = shipType[i];
+    pending[s] = SHIP_NONE;
+    awaiting[s] = 0;
+    firing[s] = 0;
+  }
+  // GameManager::addShip(), in fleet order
+  for (int i = 0; i < shipCount; i++) {
+    placeRandomly(i, lane);
+  }
+  queueLength[lane] = 0;
+  active[lane] = true;
+  turns[lane] = 0;
+  winner[lane] = -1;
+}
+
+void LockstepEngine::processRespawns(int lane) {
+  int placedThisTurn = 0;
+  int slot = 0;
+  while (slot < queueLength[lane] && placedThisTurn < perTurn) {
+    int ship = queue[shipAt(slot, lane)];
+    if (placeRandomly(ship, lane)) {
+      respawns[shipAt(ship, lane)]++;
+      awaiting[shipAt(ship, lane)] = 0;
+      for (int k = slot + 1; k < queueLength[lane]; k++) {
+        queue[shipAt(k - 1, lane)] = queue[shipAt(k, lane)];
+      }
+      queueLength[lane]--;
+      placedThisTurn++;
+    } else {
+      slot++;
+    }
+  }
+}
+
+void LockstepEngine::stepShip(int ship, int lane) {
+  int s = shipAt(ship, lane);
+  int ex, ey, fx, fy;
+  switch (type[s]) {
+  case BATTLESHIP:
+    step4(ship, lane);
+    shootDiamond(ship, lane);
+    break;
+  case CRUISER:
+    if (scan(ship, lane, ex, ey, fx, fy)) {
+      ram(ship, lane, ex, ey);
+    } else if (fx >= 0) {
+      clearOccupant(posX[s], posY[s], lane);
+      setOccupant(fx, fy, lane, ship);
+    }
+    break;
+  case DESTROYER:
+    if (scan(ship, lane, ex, ey, fx, fy)) {
+      ram(ship, lane, ex, ey);
+    } else {
+      step4(ship, lane);
+    }
+    shootDiamond(ship, lane);
+    break;
+  case FRIGATE: {
+    const WeaponPatterns::Offset &o = WeaponPatterns::FRIGATE_SWEEP[firing[s]];
+    firing[s] = static_cast<uint8_t>((firing[s] + 1) %
+                                     WeaponPatterns::FRIGATE_SWEEP.size);
+    hit(ship, lane, posX[s] + o.dx, posY[s] + o.dy);
+    break;
+  }
+  case CORVETTE: {
+    const WeaponPatterns::Pattern<8> &ring =
+        WeaponPatterns::clippedRing1(posX[s], posY[s], height, width);
+    if (ring.size == 0)
+      break;
+    const WeaponPatterns::Offset &o = WeaponPatterns::sample(ring, rng[lane]);
+    hit(ship, lane, posX[s] + o.dx, posY[s] + o.dy);
+    break;
+  }
+  case AMPHIBIOUS:
+    step4(ship, lane);
+    shootDiamond(ship, lane);
+    break;
+  case SUPERSHIP: {
+    if (scan(ship, lane, ex, ey, fx, fy)) {
+      ram(ship, lane, ex, ey);
+    } else {
+      int dir = rng[lane].nextInt(8);
+      int nx = posX[s] + STEP_X[dir], ny = posY[s] + STEP_Y[dir];
+      if (isFree(nx, ny, lane)) {
+        clearOccupant(posX[s], posY[s], lane);
+        setOccupant(nx, ny, lane, ship);
+      }
+    }
+    bool onBoard = inBounds(posX[s], posY[s]);
+    for (int i = 0; i < 3; i++) {
+      WeaponPatterns::Offset cell =
+          WeaponPatterns::boardCell(rng[lane], height, width);
+      if (!onBoard) {
+        hit(ship, lane, cell.dx, cell.dy);
+      }
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void LockstepEngine::finishTurn(int lane) {
+  // GameManager::executeTurn() steps 2 and 3: queue the dead, then take
+  // them off the board
+  for (int i = 0; i < shipCount; i++) {
+    int s = shipAt(i, lane);
+    if (lives[s] > 0 || respawns[s] >= perShip || awaiting[s])
+      continue;
+    awaiting[s] = 1;
+    queue[shipAt(queueLength[lane]++, lane)] = static_cast<uint8_t>(i);
+  }
+  for (int i = 0; i < shipCount; i++) {
+    int s = shipAt(i, lane);
+    if (lives[s] == 0 && occupantAt(posX[s], posY[s], lane) == i + 1) {
+      clearOccupant(posX[s], posY[s], lane);
+    }
+  }
+
+  // handleUpgrades(): the new ship keeps lives, kills and position, but
+  // starts off the board with a fresh respawn count
+  for (int i = 0; i < shipCount; i++) {
+    int s = shipAt(i, lane);
+    if (lives[s] == 0 || pending[s] == SHIP_NONE)
+      continue;
+    type[s] = pending[s];
+    pending[s] = SHIP_NONE;
+    respawns[s] = 0;
+    awaiting[s] = 0;
+    firing[s] = 0;
+    clearOccupant(posX[s], posY[s], lane);
+  }
+
+  // checkVictory()
+  int team = -1;
+  for (int i = 0; i < shipCount; i++) {
+    if (lives[shipAt(i, lane)] == 0)
+      continue;
+    if (team < 0) {
+      team = shipTeam[i];
+    } else if (team != shipTeam[i]) {
+      return;
+    }
+  }
+  if (team >= 0) {
+    winner[lane] = team;
+    active[lane] = false;
+  }
+}
+
+void LockstepEngine::run(const uint64_t *seeds, int count,
+                         SweepResult *results) {
+  if (count > LANES) {
+    throw std::runtime_error("Lockstep engine: too many battles for a run");
+  }
+  // One battle after the other, each on its own block of state
+  for (int l = 0; l < count; l++) {
+    startLane(l, seeds[l]);
+    for (int turn = 1; turn <= iterations && active[l]; turn++) {
+      turns[l] = turn;
+      processRespawns(l);
+      for (int i = 0; i < shipCount; i++) {
+        int s = shipAt(i, l);
+        if (lives[s] <= 0)
+          continue;
+        // Every type but Frigate, Corvette and Amphibious starts with two
+        // look() draws, which only advance the counter
+        int t = type[s];
+        if (t != FRIGATE && t != CORVETTE && t != AMPHIBIOUS) {
+          rng[l].setCounter(rng[l].getCounter() + 2);
+        }
+        stepShip(i, l);
+      }
+      finishTurn(l);
+    }
+  }
+
+  for (int l = 0; l < count; l++) {
+    SweepResult &r = results[l];
+    r.winner = winner[l] >= 0 ? teamNames[winner[l]] : "-";
+    r.turns = turns[l];
+    r.alive.assign(teamNames.size(), 0);
+    r.kills = 0;
+    std::fill(r.typeKills, r.typeKills + SHIP_TYPE_COUNT, 0);
+    for (int i = 0; i < shipCount; i++) {
+      r.kills += kills[shipAt(i, l)];
+      r.typeKills[type[shipAt(i, l)]] += kills[shipAt(i, l)];
+      if (lives[shipAt(i, l)] > 0)
+        r.alive[shipTeam[i]]++;
+    }
+    r.stalemate = false;
+    r.stateHash = stateHash(l);
+  }
+}
+
+uint64_t LockstepEngine::stateHash(int lane) const {
+  // Same keys as Battlefield / GameManager, so both engines agree
+  uint64_t h = 0;
+  for (int c = 0; c < width * height; c++) {
+    int occ = occupant[cellAt(c, lane)];
+    if (occ) {
+      int s = occ - 1;
+      h ^= Zobrist::cellKey(c, type[shipAt(s, lane)], teamKeys[shipTeam[s]],
+                            lives[shipAt(s, lane)]);
+    }
+  }
+  for (int slot = 0; slot < queueLength[lane]; slot++) {
+    h ^= Zobrist::queueKey(queue[shipAt(slot, lane)]);
+  }
+  return h;
+}
@@ -0,0 +1,20 @@
+#include "Log.h"
+
+namespace {
+thread_local std::ostream *currentLog = &std::cout;
+}
+
+std::ostream &simLog() { return *currentLog; }
+
+std::ostream &nullLog() {
+  // An ostream without a buffer is permanently in a bad state, so every <<
+  // returns straight away
+  thread_local std::ostream sink(nullptr);
+  return sink;
+}
+
+ScopedLog::ScopedLog(std::ostream &out) : previous(currentLog) {
+  currentLog = &out;
+}
+
+ScopedLog::~ScopedLog() { currentLog = previous; }
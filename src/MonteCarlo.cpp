@@ -0,0 +1,234 @@
+#include "MonteCarlo.h"
+#include "Lockstep.h"
+#include "Scheduler.h"
+#include "Sketch.h"
+#include "Sweep.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+bool sameResult(const SweepResult &a, const SweepResult &b) {
+  return a.winner == b.winner && a.turns == b.turns && a.kills == b.kills &&
+         a.alive == b.alive && a.stateHash == b.stateHash &&
+         std::equal(a.typeKills, a.typeKills + SHIP_TYPE_COUNT, b.typeKills);
+}
+
+// Everything the report needs, in memory that does not grow with the number
+// of battles: exact counters plus one quantile sketch per metric. Each
+// worker fills its own, they are merged at the end.
+struct BatchStats {
+  std::vector<uint64_t> wins; // per team
+  uint64_t battles = 0, draws = 0, stalemates = 0;
+  double turnSum = 0, killSum = 0;
+
+  QuantileSketch turns, kills, survivors;
+  std::vector<QuantileSketch> alive;     // per team
+  std::vector<QuantileSketch> typeKills; // per ShipType
+  DistinctSketch endStates;
+
+  BatchStats(size_t teamCount, uint64_t seed)
+      : wins(teamCount, 0), turns(200, seed), kills(200, seed + 1),
+        survivors(200, seed + 2) {
+    for (size_t t = 0; t < teamCount; t++) {
+      alive.emplace_back(200, seed + 3 + t);
+    }
+    for (int t = 0; t < SHIP_TYPE_COUNT; t++) {
+      typeKills.emplace_back(200, seed + 3 + teamCount + t);
+    }
+  }
+
+  void add(const SweepResult &r, const std::vector<std::string> &teams) {
+    battles++;
+    turnSum += r.turns;
+    killSum += r.kills;
+    turns.add(r.turns);
+    kills.add(r.kills);
+    endStates.add(r.stateHash);
+
+    int total = 0;
+    for (size_t t = 0; t < teams.size(); t++) {
+      alive[t].add(r.alive[t]);
+      total += r.alive[t];
+    }
+    survivors.add(total);
+    for (int t = BATTLESHIP; t < SHIP_TYPE_COUNT; t++) {
+      typeKills[t].add(r.typeKills[t]);
+    }
+
+    if (r.stalemate) {
+      stalemates++;
+      return;
+    }
+    size_t t = 0;
+    while (t < teams.size() && teams[t] != r.winner)
+      t++;
+    if (t < teams.size()) {
+      wins[t]++;
+    } else {
+      draws++;
+    }
+  }
+
+  void merge(const BatchStats &o) {
+    for (size_t t = 0; t < wins.size(); t++) {
+      wins[t] += o.wins[t];
+      alive[t].merge(o.alive[t]);
+    }
+    battles += o.battles;
+    draws += o.draws;
+    stalemates += o.stalemates;
+    turnSum += o.turnSum;
+    killSum += o.killSum;
+    turns.merge(o.turns);
+    kills.merge(o.kills);
+    survivors.merge(o.survivors);
+    for (int t = 0; t < SHIP_TYPE_COUNT; t++) {
+      typeKills[t].merge(o.typeKills[t]);
+    }
+    endStates.merge(o.endStates);
+  }
+};
+
+void printRow(std::ostream &out, const std::string &name,
+              const QuantileSketch &q) {
+  char line[128];
+  std::snprintf(line, sizeof(line), "  %-20s %8.0f %8.0f %8.0f %8.0f %8.0f\n",
+                name.c_str(), q.min(), q.quantile(0.50), q.quantile(0.95),
+                q.quantile(0.99), q.max());
+  out << line;
+}
+
+} // namespace
+
+int runMonteCarlo(const GameConfig &config, const MonteCarloSpec &spec,
+                  Scheduler &scheduler, std::ostream &out) {
+  std::vector<std::string> teams = SweepRunner::teamsOf(config);
+  size_t battles = spec.battles > 0 ? static_cast<size_t>(spec.battles) : 0;
+
+  std::string reason;
+  bool lockstep = !spec.objectEngine && LockstepEngine::supports(config, reason);
+  if (!spec.objectEngine && !lockstep) {
+    std::cerr << "Monte Carlo: " << reason << ", using the object engine\n";
+  }
+
+  // One accumulator per worker: no locks, no per-battle results kept
+  std::vector<std::unique_ptr<BatchStats>> perWorker;
+  for (int w = 0; w < scheduler.workerCount(); w++) {
+    perWorker.emplace_back(new BatchStats(teams.size(), 1000 * (w + 1)));
+  }
+  std::atomic<size_t> mismatches(0);
+  auto objectResult = [&](uint64_t seed) {
+    GameConfig c = config;
+    c.hasSeed = true;
+    c.seed = seed;
+    return SweepRunner::playGame(c, teams);
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  scheduler.resetStats();
+  const size_t lanes = LockstepEngine::LANES;
+  if (lockstep) {
+    // One task per group of LANES battles
+    size_t groups = (battles + lanes - 1) / lanes;
+    scheduler.parallelFor(0, groups, 1, [&](size_t g) {
+      LockstepEngine engine(config);
+      uint64_t seeds[LockstepEngine::LANES];
+      SweepResult results[LockstepEngine::LANES];
+      size_t first = g * lanes;
+      int count = static_cast<int>(std::min(lanes, battles - first));
+      for (int l = 0; l < count; l++) {
+        seeds[l] = spec.firstSeed + first + l;
+      }
+      engine.run(seeds, count, results);
+
+      BatchStats &stats = *perWorker[scheduler.currentWorker()];
+      for (int l = 0; l < count; l++) {
+        // Replay on the object engine and compare
+        if (spec.verify && !sameResult(results[l], objectResult(seeds[l]))) {
+          if (mismatches++ == 0) {
+            std::cerr << "Monte Carlo: seed " << seeds[l]
+                      << " differs between the engines\n";
+          }
+        }
+        stats.add(results[l], teams);
+      }
+    });
+  } else {
+    scheduler.parallelFor(0, battles, 4, [&](size_t i) {
+      perWorker[scheduler.currentWorker()]->add(
+          objectResult(spec.firstSeed + i), teams);
+    });
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  BatchStats &total = *perWorker[0];
+  for (size_t w = 1; w < perWorker.size(); w++) {
+    total.merge(*perWorker[w]);
+  }
+
+  // Summary
+  char line[160];
+  out << "Monte Carlo: " << battles << " battles, seeds " << spec.firstSeed
+      << ".." << spec.firstSeed + battles - 1 << " ("
+      << (lockstep ? "lockstep" : "object") << " engine)\n";
+  double n = battles ? static_cast<double>(battles) : 1.0;
+  for (size_t t = 0; t < teams.size(); t++) {
+    std::snprintf(line, sizeof(line), "  team %-8s %8llu wins  %6.2f%%\n",
+                  teams[t].c_str(),
+                  static_cast<unsigned long long>(total.wins[t]),
+                  100.0 * total.wins[t] / n);
+    out << line;
+  }
+  std::snprintf(line, sizeof(line), "  no winner     %8llu       %6.2f%%\n",
+                static_cast<unsigned long long>(total.draws),
+                100.0 * total.draws / n);
+  out << line;
+  if (total.stalemates) {
+    std::snprintf(line, sizeof(line), "  stalemate     %8llu       %6.2f%%\n",
+                  static_cast<unsigned long long>(total.stalemates),
+                  100.0 * total.stalemates / n);
+    out << line;
+  }
+  std::snprintf(line, sizeof(line),
+                "  mean turns %.2f, mean kills %.2f, ~%.0f distinct end states\n",
+                total.turnSum / n, total.killSum / n,
+                total.endStates.estimate());
+  out << line;
+
+  // Distributions, from the sketches
+  std::snprintf(line, sizeof(line), "  %-20s %8s %8s %8s %8s %8s\n", "",
+                "min", "p50", "p95", "p99", "max");
+  out << line;
+  printRow(out, "turns", total.turns);
+  printRow(out, "kills", total.kills);
+  printRow(out, "survivors", total.survivors);
+  for (size_t t = 0; t < teams.size(); t++) {
+    printRow(out, "alive " + teams[t], total.alive[t]);
+  }
+  for (int t = BATTLESHIP; t < SHIP_TYPE_COUNT; t++) {
+    if (total.typeKills[t].max() > 0) {
+      printRow(out,
+               std::string("kills ") + shipTypeName(static_cast<ShipType>(t)),
+               total.typeKills[t]);
+    }
+  }
+
+  std::snprintf(line, sizeof(line), "  %.0f battles/s on %d workers\n",
+                seconds > 0 ? battles / seconds : 0.0,
+                scheduler.workerCount());
+  out << line;
+  if (spec.verify) {
+    out << "  verify: "
+        << (lockstep ? std::to_string(mismatches.load()) + " mismatches"
+                     : std::string("nothing to compare (object engine)"))
+        << "\n";
+  }
+  return mismatches.load() ? 1 : 0;
+}
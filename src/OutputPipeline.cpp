@@ -0,0 +1,98 @@
+#include "OutputPipeline.h"
+
+OutputPipeline::FrameBuf::int_type
+OutputPipeline::FrameBuf::overflow(int_type ch) {
+  if (ch != traits_type::eof()) {
+    target->push_back(traits_type::to_char_type(ch));
+  }
+  return ch;
+}
+
+std::streamsize OutputPipeline::FrameBuf::xsputn(const char *s,
+                                                 std::streamsize n) {
+  target->append(s, static_cast<size_t>(n));
+  return n;
+}
+
+OutputPipeline::OutputPipeline(std::ostream &destination, size_t bufferCount,
+                               Policy backpressure, size_t reserveBytes)
+    : dest(destination), policy(backpressure),
+      buffers(bufferCount < 2 ? 2 : bufferCount), ring(buffers.size()),
+      head(0), filled(0), current(0), frameStream(&frameBuf), stopping(false),
+      droppedFrames(0), writtenFrames(0) {
+  for (size_t i = 0; i < buffers.size(); i++) {
+    buffers[i].reserve(reserveBytes);
+    if (i != current) {
+      freeList.push_back(i);
+    }
+  }
+  frameBuf.target = &buffers[current];
+  writer = std::thread(&OutputPipeline::writerLoop, this);
+}
+
+OutputPipeline::~OutputPipeline() {
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  frameReady.notify_one();
+  writer.join();
+}
+
+void OutputPipeline::endFrame(bool force) {
+  if (buffers[current].empty())
+    return; // nothing was written this turn
+
+  std::unique_lock<std::mutex> lock(mtx);
+  if (freeList.empty()) {
+    if (policy == DROP && !force) {
+      // Writer is behind: lose this frame rather than stall the simulation
+      droppedFrames++;
+      buffers[current].clear();
+      return;
+    }
+    bufferFree.wait(lock, [this] { return !freeList.empty(); });
+  }
+
+  ring[(head + filled) % ring.size()] = current;
+  filled++;
+  current = freeList.back();
+  freeList.pop_back();
+  frameBuf.target = &buffers[current];
+  lock.unlock();
+  frameReady.notify_one();
+}
+
+void OutputPipeline::flush() {
+  endFrame(true);
+  std::unique_lock<std::mutex> lock(mtx);
+  // Everything except the producer's own buffer is back on the free list
+  bufferFree.wait(lock,
+                  [this] { return freeList.size() == buffers.size() - 1; });
+  dest.flush();
+}
+
+void OutputPipeline::writerLoop() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    frameReady.wait(lock, [this] { return filled > 0 || stopping; });
+    if (filled == 0 && stopping)
+      break;
+
+    size_t idx = ring[head];
+    head = (head + 1) % ring.size();
+    filled--;
+
+    // Do the slow part without holding the lock
+    lock.unlock();
+    dest.write(buffers[idx].data(),
+               static_cast<std::streamsize>(buffers[idx].size()));
+    buffers[idx].clear(); // keeps capacity, no reallocation next time
+    lock.lock();
+
+    freeList.push_back(idx);
+    writtenFrames++;
+    bufferFree.notify_all();
+  }
+}
@@ -0,0 +1,151 @@
+#include "Rollout.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+const char *shipActionName(ShipAction action) {
+  switch (action) {
+  case ACTION_HOLD:
+    return "hold";
+  case ACTION_UP:
+    return "up";
+  case ACTION_DOWN:
+    return "down";
+  case ACTION_LEFT:
+    return "left";
+  case ACTION_RIGHT:
+    return "right";
+  case ACTION_ATTACK:
+    return "attack";
+  case ACTION_UP_ATTACK:
+    return "up+attack";
+  case ACTION_DOWN_ATTACK:
+    return "down+attack";
+  case ACTION_LEFT_ATTACK:
+    return "left+attack";
+  case ACTION_RIGHT_ATTACK:
+    return "right+attack";
+  default:
+    return "auto";
+  }
+}
+
+RolloutRunner::RolloutRunner() : rollouts(0), turns(0), copiedTiles(0) {}
+
+double RolloutRunner::score(const std::string &team) const {
+  double total = 0;
+  for (const Ship *s : scratch.getShips()) {
+    if (!s->isAlive())
+      continue;
+    total += (s->getTeam() == team) ? s->getLives() : -s->getLives();
+  }
+  return total;
+}
+
+double RolloutRunner::evaluate(const GameManager &world, int ship,
+                               ShipAction action, const RolloutSpec &spec) {
+  const std::vector<Ship *> &fleet = world.getShips();
+  if (ship < 0 || static_cast<size_t>(ship) >= fleet.size()) {
+    throw std::runtime_error("Rollout: no ship " + std::to_string(ship));
+  }
+  const std::string &team = fleet[ship]->getTeam();
+  int first = world.getTurnsPlayed() + 1;
+  int last = std::min(first + spec.depth - 1, world.getTotalIterations());
+
+  ScopedLog quiet(nullLog());
+  double total = 0;
+  int samples = spec.samples > 0 ? spec.samples : 1;
+  for (int k = 0; k < samples; k++) {
+    scratch.forkFrom(world);
+    if (k > 0) {
+      Random mix(spec.seed);
+      mix.setCounter(static_cast<uint64_t>(k));
+      scratch.setSeed(mix.next());
+    }
+    actions.assign(fleet.size(), ACTION_AUTO);
+    actions[ship] = static_cast<int8_t>(action);
+    scratch.setShipActions(actions.data());
+
+    for (int turn = first; turn <= last; turn++) {
+      bool over = scratch.playTurn(turn);
+      actions[ship] = ACTION_AUTO; // forced for the first turn only
+      turns++;
+      if (over)
+        break;
+    }
+    scratch.setShipActions(nullptr);
+    total += score(team);
+    rollouts++;
+    copiedTiles += scratch.forkCopiedTiles();
+  }
+  return total / samples;
+}
+
+ShipAction RolloutRunner::choose(const GameManager &world, int ship,
+                                 const RolloutSpec &spec, double *scores) {
+  ShipAction best = ACTION_AUTO;
+  double bestScore = 0;
+  for (int a = ACTION_AUTO; a < ACTION_COUNT; a++) {
+    ShipAction action = static_cast<ShipAction>(a);
+    double value = evaluate(world, ship, action, spec);
+    if (scores) {
+      scores[a] = value;
+    }
+    if (a == ACTION_AUTO || value > bestScore) {
+      best = action;
+      bestScore = value;
+    }
+  }
+  return best;
+}
+
+int runRollouts(const GameConfig &config, const std::string &symbol,
+                int atTurn, const RolloutSpec &spec) {
+  GameManager world;
+  {
+    ScopedLog quiet(nullLog());
+    world.loadConfig(config);
+    world.prepareRun(config.iterations);
+    for (int turn = 1; turn <= atTurn && turn <= config.iterations; turn++) {
+      if (world.playTurn(turn))
+        break;
+    }
+  }
+
+  int ship = -1;
+  for (const Ship *s : world.getShips()) {
+    if (s->getSymbol() == symbol)
+      ship = s->getFleetIndex();
+  }
+  if (ship < 0) {
+    throw std::runtime_error("Rollout: no ship " + symbol);
+  }
+  const Ship *s = world.getShips()[ship];
+  std::cout << "Ship " << symbol << " (" << shipTypeName(s->getType())
+            << ", team " << s->getTeam() << ") after turn "
+            << world.getTurnsPlayed() << ": " << spec.samples
+            << " rollouts of " << spec.depth << " turns per action\n";
+
+  RolloutRunner runner;
+  double scores[ACTION_COUNT];
+  auto start = std::chrono::steady_clock::now();
+  ShipAction best = runner.choose(world, ship, spec, scores);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  for (int a = ACTION_AUTO; a < ACTION_COUNT; a++) {
+    std::cout << "  " << shipActionName(static_cast<ShipAction>(a)) << "\t"
+              << scores[a] << "\n";
+  }
+  std::cout << "Best: " << shipActionName(best) << "\n";
+  uint64_t n = runner.getRollouts();
+  std::cout << n << " rollouts, " << runner.getTurns() << " turns in "
+            << seconds << " s (" << (seconds > 0 ? n / seconds : 0.0)
+            << " rollouts/s), "
+            << (n ? static_cast<double>(runner.getCopiedTiles()) / n : 0.0)
+            << " tiles copied per rollout\n";
+  return 0;
+}
@@ -0,0 +1,237 @@
+#include "ScenarioImage.h"
+#include "Ship.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char IMAGE_MAGIC[8] = {'W', 'S', 'I', 'M', 'A', 'G', 'E', '\0'};
+
+size_t alignUp(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+// Append a POD array at the next 8-byte boundary, return its offset
+template <typename T>
+uint64_t appendSection(std::vector<unsigned char> &out, const T *items,
+                       size_t count) {
+  out.resize(alignUp(out.size()), 0);
+  uint64_t offset = out.size();
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(items);
+  out.insert(out.end(), bytes, bytes + count * sizeof(T));
+  return offset;
+}
+
+bool sectionFits(uint64_t offset, uint64_t count, size_t itemSize,
+                 size_t fileSize) {
+  if (offset % 8 != 0 || offset > fileSize)
+    return false;
+  return count <= (fileSize - offset) / itemSize;
+}
+
+} // namespace
+
+ScenarioImage::ScenarioImage() : data(nullptr), size(0) {}
+
+ScenarioImage::~ScenarioImage() {
+  if (data) {
+    ::munmap(const_cast<unsigned char *>(data), size);
+  }
+}
+
+void ScenarioImage::compile(const GameConfig &config,
+                            const std::string &path) {
+  // Images store built-in type IDs only
+  if (!config.shipTypes.empty()) {
+    throw std::runtime_error("Scenarios with shiptype blocks cannot be "
+                             "compiled to an image");
+  }
+
+  // Terrain: sort the island cells and merge each row into strips
+  std::vector<Position> cells = config.islands;
+  std::sort(cells.begin(), cells.end(), [](const Position &a, const Position &b) {
+    return a.x != b.x ? a.x < b.x : a.y < b.y;
+  });
+  std::vector<IslandRun> runs;
+  for (const Position &p : cells) {
+    if (!runs.empty()) {
+      IslandRun &last = runs.back();
+      if (last.row == p.x && p.y < last.col + last.length)
+        continue; // duplicate cell
+      if (last.row == p.x && p.y == last.col + last.length) {
+        last.length++;
+        continue;
+      }
+    }
+    runs.push_back(IslandRun{p.x, p.y, 1});
+  }
+
+  // Teams in order of appearance, then the fleet expanded exactly like
+  // GameManager::loadConfig() does (symbol + running number per line)
+  std::string strings;
+  std::vector<TeamRecord> teams;
+  std::vector<std::string> teamNames;
+  std::vector<ShipRecord> ships;
+  for (const GameConfig::ShipInfo &info : config.allShips) {
+    ShipType type;
+    if (!parseShipType(info.type, type)) {
+      throw std::runtime_error("Unknown ship type: " + info.type);
+    }
+
+    uint32_t team = 0;
+    while (team < teamNames.size() && teamNames[team] != info.team)
+      team++;
+    if (team == teamNames.size()) {
+      teamNames.push_back(info.team);
+      TeamRecord t;
+      t.nameOffset = static_cast<uint32_t>(strings.size());
+      t.nameLength = static_cast<uint32_t>(info.team.size());
+      teams.push_back(t);
+      strings += info.team;
+    }
+
+    for (int i = 0; i < info.count; i++) {
+      std::string symbol = info.symbol + std::to_string(i + 1);
+      ShipRecord r;
+      r.symbolOffset = static_cast<uint32_t>(strings.size());
+      r.symbolLength = static_cast<uint16_t>(symbol.size());
+      r.type = static_cast<uint8_t>(type);
+      r.reserved = 0;
+      r.team = team;
+      ships.push_back(r);
+      strings += symbol;
+    }
+  }
+  if (strings.size() > UINT32_MAX) {
+    throw std::runtime_error("Scenario too large for an image");
+  }
+
+  ImageHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, IMAGE_MAGIC, sizeof(h.magic));
+  h.version = IMAGE_VERSION;
+  h.byteOrder = IMAGE_BYTE_ORDER;
+  h.iterations = config.iterations;
+  h.width = config.width;
+  h.height = config.height;
+  h.respawnsPerTurn = config.respawnsPerTurn;
+  h.shipRespawns = config.shipRespawns;
+  h.hasSeed = config.hasSeed ? 1 : 0;
+  h.layout = static_cast<uint8_t>(config.layout);
+  h.combat = static_cast<uint8_t>(config.combat);
+  h.seed = config.seed;
+  h.sleeping = config.sleeping ? 1 : 0;
+  h.stalemateWindow = config.stalemateWindow;
+  for (const GameConfig::RateInfo &r : config.rates) {
+    ShipType type;
+    if (!parseShipType(r.type, type) || r.period < 1 || r.period > UINT16_MAX) {
+      throw std::runtime_error("Bad rate for " + r.type);
+    }
+    h.hasRates = 1;
+    h.ratePeriod[type] = static_cast<uint16_t>(r.period);
+    h.rateInitiative[type] = static_cast<int16_t>(r.initiative);
+  }
+
+  std::vector<unsigned char> out(sizeof(ImageHeader), 0);
+  h.runOffset = appendSection(out, runs.data(), runs.size());
+  h.runCount = runs.size();
+  h.teamOffset = appendSection(out, teams.data(), teams.size());
+  h.teamCount = teams.size();
+  h.shipOffset = appendSection(out, ships.data(), ships.size());
+  h.shipCount = ships.size();
+  h.stringOffset = appendSection(out, strings.data(), strings.size());
+  h.stringBytes = strings.size();
+  out.resize(alignUp(out.size()), 0);
+  h.fileSize = out.size();
+  std::memcpy(out.data(), &h, sizeof(h));
+
+  FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f) {
+    throw std::runtime_error("Cannot write image: " + path);
+  }
+  bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok) {
+    throw std::runtime_error("Cannot write image: " + path);
+  }
+}
+
+bool ScenarioImage::isImage(const std::string &path) {
+  char magic[sizeof(IMAGE_MAGIC)];
+  FILE *f = std::fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  bool match = std::fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+               std::memcmp(magic, IMAGE_MAGIC, sizeof(magic)) == 0;
+  std::fclose(f);
+  return match;
+}
+
+void ScenarioImage::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open image: " + path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(ImageHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Not a scenario image: " + path);
+  }
+  void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping stays valid
+  if (p == MAP_FAILED) {
+    throw std::runtime_error("Cannot map image: " + path);
+  }
+
+  if (data) {
+    ::munmap(const_cast<unsigned char *>(data), size);
+  }
+  data = static_cast<const unsigned char *>(p);
+  size = static_cast<size_t>(st.st_size);
+  validate();
+}
+
+void ScenarioImage::validate() const {
+  const ImageHeader &h = header();
+  if (std::memcmp(h.magic, IMAGE_MAGIC, sizeof(h.magic)) != 0) {
+    throw std::runtime_error("Not a scenario image");
+  }
+  if (h.byteOrder != IMAGE_BYTE_ORDER) {
+    throw std::runtime_error("Scenario image has a different byte order");
+  }
+  if (h.version != IMAGE_VERSION) {
+    throw std::runtime_error("Scenario image version " +
+                             std::to_string(h.version) + ", expected " +
+                             std::to_string(IMAGE_VERSION) +
+                             " (recompile it)");
+  }
+  if (h.fileSize != size ||
+      !sectionFits(h.runOffset, h.runCount, sizeof(IslandRun), size) ||
+      !sectionFits(h.teamOffset, h.teamCount, sizeof(TeamRecord), size) ||
+      !sectionFits(h.shipOffset, h.shipCount, sizeof(ShipRecord), size) ||
+      !sectionFits(h.stringOffset, h.stringBytes, 1, size) ||
+      h.layout > Battlefield::CHUNKED || h.combat > CombatBuffer::BATCHED) {
+    throw std::runtime_error("Scenario image is truncated or corrupt");
+  }
+
+  for (uint64_t t = 0; t < h.teamCount; t++) {
+    const TeamRecord &r = teams()[t];
+    if (static_cast<uint64_t>(r.nameOffset) + r.nameLength > h.stringBytes) {
+      throw std::runtime_error("Scenario image has a bad team record");
+    }
+  }
+  for (uint64_t i = 0; i < h.shipCount; i++) {
+    const ShipRecord &r = ships()[i];
+    if (static_cast<uint64_t>(r.symbolOffset) + r.symbolLength >
+            h.stringBytes ||
+        r.team >= h.teamCount || r.type < BATTLESHIP || r.type > SUPERSHIP) {
+      throw std::runtime_error("Scenario image has a bad ship record");
+    }
+  }
+}
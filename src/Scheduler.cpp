@@ -0,0 +1,234 @@
+#include "Scheduler.h"
+#include <cstdio>
+#include <stdexcept>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Which scheduler / worker the current thread belongs to
+struct WorkerSlot {
+  const Scheduler *scheduler = nullptr;
+  int index = -1;
+};
+thread_local WorkerSlot currentSlot;
+
+// Yielding rounds before an idle worker goes to sleep
+const int IDLE_SPINS = 64;
+
+void pinToCore(std::thread::native_handle_type handle, int core) {
+#ifdef __linux__
+  unsigned cores = std::thread::hardware_concurrency();
+  if (cores == 0)
+    return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core % cores, &set);
+  pthread_setaffinity_np(handle, sizeof(set), &set);
+#else
+  (void)handle;
+  (void)core;
+#endif
+}
+
+uint64_t nanosSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+Scheduler::Scheduler(int threadCount, bool pinCores)
+    : pinned(pinCores), stopping(false), epoch(0), sleepers(0),
+      statsStart(std::chrono::steady_clock::now()) {
+  if (threadCount <= 0) {
+    threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    if (threadCount <= 0)
+      threadCount = 1;
+  }
+  for (int i = 0; i < threadCount; i++) {
+    workers.emplace_back(new Worker());
+    workers.back()->victimSeed = 0x9E3779B97F4A7C15ULL * (i + 1);
+  }
+
+  // The creating thread is worker 0
+  currentSlot.scheduler = this;
+  currentSlot.index = 0;
+#ifdef __linux__
+  if (pinned) {
+    pinToCore(pthread_self(), 0);
+  }
+#endif
+  for (int i = 1; i < threadCount; i++) {
+    threads.emplace_back(&Scheduler::workerMain, this, i);
+    if (pinned) {
+      pinToCore(threads.back().native_handle(), i);
+    }
+  }
+}
+
+Scheduler::~Scheduler() {
+  stopping = true;
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    wake.notify_all();
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  if (currentSlot.scheduler == this) {
+    currentSlot = WorkerSlot();
+  }
+}
+
+int Scheduler::currentWorker() const {
+  if (currentSlot.scheduler != this) {
+    throw std::runtime_error(
+        "Scheduler used from a thread that is not one of its workers");
+  }
+  return currentSlot.index;
+}
+
+void Scheduler::spawn(TaskGroup &group, Task *task) {
+  int self = currentWorker();
+  task->group = &group;
+  group.pending.fetch_add(1, std::memory_order_relaxed);
+  workers[self]->deque.push(task);
+
+  epoch.fetch_add(1, std::memory_order_release);
+  if (sleepers.load(std::memory_order_acquire) > 0) {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    wake.notify_one();
+  }
+}
+
+Scheduler::Task *Scheduler::findTask(int self) {
+  Worker &me = *workers[self];
+  Task *task = me.deque.pop();
+  if (task)
+    return task;
+
+  // Random victims (xorshift), a couple of rounds over the pool
+  int n = workerCount();
+  for (int attempt = 0; attempt < 2 * n; attempt++) {
+    uint64_t &x = me.victimSeed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    int victim = static_cast<int>(x % static_cast<uint64_t>(n));
+    if (victim == self)
+      continue;
+    task = workers[victim]->deque.steal();
+    if (task) {
+      me.steals.fetch_add(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void Scheduler::execute(int self, Task *task) {
+  TaskGroup *group = task->group;
+  auto start = std::chrono::steady_clock::now();
+  try {
+    task->run(*this);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(group->errorMutex);
+    if (!group->error)
+      group->error = std::current_exception();
+  }
+  delete task;
+
+  Worker &me = *workers[self];
+  me.busyNanos.fetch_add(nanosSince(start), std::memory_order_relaxed);
+  me.tasks.fetch_add(1, std::memory_order_relaxed);
+  // Last touch of the group: the waiter may return as soon as this lands
+  group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void Scheduler::wait(TaskGroup &group) {
+  int self = currentWorker();
+  while (group.pending.load(std::memory_order_acquire) > 0) {
+    Task *task = findTask(self);
+    if (task) {
+      execute(self, task);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  if (group.error) {
+    std::exception_ptr error = group.error;
+    group.error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void Scheduler::workerMain(int index) {
+  currentSlot.scheduler = this;
+  currentSlot.index = index;
+
+  int idle = 0;
+  while (!stopping.load(std::memory_order_acquire)) {
+    uint64_t seen = epoch.load(std::memory_order_acquire);
+    Task *task = findTask(index);
+    if (task) {
+      execute(index, task);
+      idle = 0;
+      continue;
+    }
+    if (++idle < IDLE_SPINS) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Nothing spawned since we looked: sleep until the next spawn. The
+    // timeout covers a spawn that raced with the sleepers count.
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepers++;
+    wake.wait_for(lock, std::chrono::milliseconds(1), [&]() {
+      return stopping.load() || epoch.load() != seen;
+    });
+    sleepers--;
+    idle = 0;
+  }
+}
+
+std::vector<Scheduler::WorkerStats> Scheduler::stats() const {
+  double elapsed = static_cast<double>(nanosSince(statsStart));
+  std::vector<WorkerStats> out;
+  for (const auto &w : workers) {
+    WorkerStats s;
+    s.tasks = w->tasks.load();
+    s.steals = w->steals.load();
+    s.utilisation = elapsed > 0 ? w->busyNanos.load() / elapsed : 0.0;
+    out.push_back(s);
+  }
+  return out;
+}
+
+void Scheduler::resetStats() {
+  for (auto &w : workers) {
+    w->tasks = 0;
+    w->steals = 0;
+    w->busyNanos = 0;
+  }
+  statsStart = std::chrono::steady_clock::now();
+}
+
+void Scheduler::report(std::ostream &out) const {
+  std::vector<WorkerStats> all = stats();
+  out << "Scheduler: " << all.size() << " workers"
+      << (pinned ? " (pinned)" : "") << "\n";
+  for (size_t i = 0; i < all.size(); i++) {
+    char line[96];
+    std::snprintf(line, sizeof(line),
+                  "  worker %2zu: %8llu tasks %6llu steals %5.1f%% busy\n", i,
+                  static_cast<unsigned long long>(all[i].tasks),
+                  static_cast<unsigned long long>(all[i].steals),
+                  100.0 * all[i].utilisation);
+    out << line;
+  }
+}
@@ -1,5 +1,6 @@
 #include "SeeingRobot.h"
 #include "Battlefield.h"
+#include "Log.h"
 
 void SeeingRobot::look(int offsetX, int offsetY) {
   Battlefield *bf = getBattlefield();
@@ -15,18 +16,18 @@ void SeeingRobot::look(int offsetX, int offsetY) {
 
       // Boundary check
       if (isWithinBoundary()) {
-        std::cout << getSymbol() << " sees out of bounds at (" << checkX << ","
+        simLog() << getSymbol() << " sees out of bounds at (" << checkX << ","
                   << checkY << ")\n";
       } else {
         Ship *occ = bf->getOccupant(checkX, checkY);
         if (!occ) {
-          std::cout << getSymbol() << " sees empty cell (" << checkX << ","
+          simLog() << getSymbol() << " sees empty cell (" << checkX << ","
                     << checkY << ")\n";
         } else if (occ == this) {
-          std::cout << getSymbol() << " sees itself at (" << checkX << ","
+          simLog() << getSymbol() << " sees itself at (" << checkX << ","
                     << checkY << ")\n";
         } else {
-          std::cout << getSymbol() << " sees " << occ->getSymbol() << " (Team "
+          simLog() << getSymbol() << " sees " << occ->getSymbol() << " (Team "
                     << occ->getTeam() << ") at (" << checkX << "," << checkY
                     << ")\n";
         }
@@ -1,28 +1,100 @@
 // Ship.cpp
 #include "Ship.h"
 #include "Battlefield.h" // Full declaration needed for getOccupant/setOccupant
+#include "Journal.h"
+#include "Log.h"
+#include "ShipPool.h"
+#include "Zobrist.h"
 #include <iostream>
+#include <utility>
+
+const char *shipTypeName(ShipType type) {
+  switch (type) {
+  case BATTLESHIP:
+    return "Battleship";
+  case CRUISER:
+    return "Cruiser";
+  case DESTROYER:
+    return "Destroyer";
+  case FRIGATE:
+    return "Frigate";
+  case CORVETTE:
+    return "Corvette";
+  case AMPHIBIOUS:
+    return "Amphibious";
+  case SUPERSHIP:
+    return "SuperShip";
+  default:
+    return "None";
+  }
+}
+
+bool parseShipType(const std::string &name, ShipType &type) {
+  for (int t = BATTLESHIP; t <= SUPERSHIP; t++) {
+    if (name == shipTypeName(static_cast<ShipType>(t))) {
+      type = static_cast<ShipType>(t);
+      return true;
+    }
+  }
+  return false;
+}
 
 Ship::Ship(const std::string &sym, const std::string &teamName)
     : pos(-1, -1), lives(DEFAULT_LIVES), killCount(0), respawnCount(0),
-      symbol(sym), team(teamName), battlefieldPtr(nullptr), pendingUpgrade("") {
-  std::cout << "Constructing Ship " << symbol << " (Team " << team << ") at "
+      awaitingRespawn(false), anchored(false), fleetIndex(-1), symbol(sym),
+      team(teamName),
+      teamKey(Zobrist::teamKey(teamName)), battlefieldPtr(nullptr),
+      pendingUpgrade(SHIP_NONE) {
+  simLog() << "Constructing Ship " << symbol << " (Team " << team << ") at "
             << getPosition().x << "," << getPosition().y << " [" << this
             << "]\n";
 }
 
+Ship::Ship(Ship *predecessor)
+    : pos(-1, -1), lives(DEFAULT_LIVES), killCount(0), respawnCount(0),
+      awaitingRespawn(false), anchored(false),
+      fleetIndex(predecessor->fleetIndex),
+      symbol(std::move(predecessor->symbol)),
+      team(std::move(predecessor->team)), teamKey(predecessor->teamKey),
+      battlefieldPtr(nullptr),
+      pendingUpgrade(SHIP_NONE) {
+  simLog() << "Constructing Ship " << symbol << " (Team " << team << ") at "
+            << getPosition().x << "," << getPosition().y << " [" << this
+            << "]\n";
+}
+
+void *Ship::operator new(std::size_t size) { return ShipPool::acquire(size); }
+
+void Ship::operator delete(void *p, std::size_t size) {
+  ShipPool::release(p, size);
+}
+
+TurnJournal *Ship::journal() const {
+  return battlefieldPtr ? battlefieldPtr->getJournal() : nullptr;
+}
+
 void Ship::takeDamage(int dmg) {
-  std::cout << "Ship " << symbol << " (Team " << team << ") takes " << dmg
+  if (TurnJournal *j = journal()) {
+    j->lives(this);
+  }
+  simLog() << "Ship " << symbol << " (Team " << team << ") takes " << dmg
             << " damage. Lives before: " << lives << "\n";
+  int before = lives;
   lives -= dmg;
   if (lives <= 0) {
     lives = 0;
-    std::cout << symbol << " (Team " << team << ") has been destroyed.\n";
+  }
+  // Keep the board's state hash in step (if this ship is on the board)
+  if (battlefieldPtr) {
+    battlefieldPtr->livesChanged(this, before);
+  }
+  if (lives <= 0) {
+    simLog() << symbol << " (Team " << team << ") has been destroyed.\n";
 
     // Immediately clear this ship from the battlefield occupant array
     if (battlefieldPtr) {
       Position p = getPosition();
-      if (p.x >= 0 && p.x < HEIGHT && p.y >= 0 && p.y < WIDTH) {
+      if (battlefieldPtr->inBounds(p.x, p.y)) {
         Ship *occ = battlefieldPtr->getOccupant(p.x, p.y);
         if (occ == this) {
           battlefieldPtr->setOccupant(p.x, p.y, nullptr);
@@ -30,7 +102,49 @@ void Ship::takeDamage(int dmg) {
       }
     }
   }
-  std::cout << "Ship " << symbol << " now has " << lives << " lives.\n";
+  simLog() << "Ship " << symbol << " now has " << lives << " lives.\n";
+}
+
+void Ship::incrementKills() {
+  if (TurnJournal *j = journal()) {
+    j->kills(this);
+  }
+  killCount++;
+}
+
+void Ship::incrementRespawnCount() {
+  if (TurnJournal *j = journal()) {
+    j->respawn(this);
+  }
+  respawnCount++;
+}
+
+void Ship::setAwaitingRespawn(bool waiting) {
+  if (TurnJournal *j = journal()) {
+    j->respawn(this);
+  }
+  awaitingRespawn = waiting;
+}
+
+void Ship::requestUpgrade(ShipType newType) {
+  if (TurnJournal *j = journal()) {
+    j->pending(this);
+  }
+  pendingUpgrade = newType;
+}
+
+void Ship::clearPendingUpgrade() {
+  if (TurnJournal *j = journal()) {
+    j->pending(this);
+  }
+  pendingUpgrade = SHIP_NONE;
+}
+
+bool Ship::isWithinBoundary() {
+  if (!battlefieldPtr)
+    return (pos.x >= TOP_BOUNDARY && pos.x < HEIGHT && pos.y >= LEFT_BOUNDARY &&
+            pos.y < WIDTH);
+  return battlefieldPtr->inBounds(pos.x, pos.y);
 }
 
 bool Ship::canRespawn(int maxAllowed) const {
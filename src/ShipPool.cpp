@@ -0,0 +1,88 @@
+#include "ShipPool.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+union Slot {
+  Slot *next; // while on the free list
+  alignas(std::max_align_t) unsigned char bytes[ShipPool::SLOT_SIZE];
+};
+
+// Slots are carved out of blocks that live until the program exits
+const std::size_t BLOCK_SLOTS = 64;
+
+struct Pool {
+  std::mutex mtx;
+  std::vector<std::unique_ptr<Slot[]>> blocks;
+  Slot *freeList = nullptr;
+  std::size_t freeCount = 0;
+
+  // Caller holds mtx
+  void grow(std::size_t slots) {
+    std::unique_ptr<Slot[]> block(new Slot[slots]);
+    for (std::size_t i = 0; i < slots; i++) {
+      block[i].next = freeList;
+      freeList = &block[i];
+    }
+    freeCount += slots;
+    blocks.push_back(std::move(block));
+  }
+};
+
+Pool &pool() {
+  static Pool instance;
+  return instance;
+}
+
+} // namespace
+
+namespace ShipPool {
+
+void *acquire(std::size_t size) {
+  if (size > SLOT_SIZE)
+    return ::operator new(size);
+
+  Pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mtx);
+  if (!p.freeList)
+    p.grow(BLOCK_SLOTS);
+  Slot *slot = p.freeList;
+  p.freeList = slot->next;
+  p.freeCount--;
+  return slot;
+}
+
+void release(void *ptr, std::size_t size) {
+  if (!ptr)
+    return;
+  if (size > SLOT_SIZE) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  Pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mtx);
+  Slot *slot = static_cast<Slot *>(ptr);
+  slot->next = p.freeList;
+  p.freeList = slot;
+  p.freeCount++;
+}
+
+void reserve(std::size_t count) {
+  Pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mtx);
+  if (p.freeCount < count)
+    p.grow(std::max(count - p.freeCount, BLOCK_SLOTS));
+}
+
+std::size_t freeSlots() {
+  Pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mtx);
+  return p.freeCount;
+}
+
+} // namespace ShipPool
@@ -0,0 +1,665 @@
+#include "ShipScript.h"
+#include "Battlefield.h"
+#include "GameManager.h"
+#include "Log.h"
+#include "ShipPool.h"
+#include "WeaponPatterns.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Opcodes; keep in step with the dispatch table in performTurn()
+enum Op : uint8_t {
+  OP_STOP,
+  OP_SET,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_MOD,
+  OP_RAND,
+  OP_POS,
+  OP_OFFSET,
+  OP_DIR4,
+  OP_DIR8,
+  OP_LOOK,
+  OP_MOVE,
+  OP_FREE,
+  OP_SCAN,
+  OP_RAM,
+  OP_SHOOT,
+  OP_DIAMOND,
+  OP_RING,
+  OP_BOARD,
+  OP_SWEEP,
+  OP_JMP,
+  OP_JT,
+  OP_JF,
+  OP_JZ,
+  OP_JNZ,
+  OP_DJNZ,
+  OP_LT,
+  OP_EQ,
+  OP_COUNT
+};
+
+// Operands: 'w' register written (r or s), 'r' any slot (or a literal),
+// 'l' label, '?' the rest are optional (literal 0 if left out)
+struct Mnemonic {
+  const char *name;
+  Op op;
+  const char *operands;
+};
+
+const Mnemonic MNEMONICS[] = {
+    {"stop", OP_STOP, ""},        {"set", OP_SET, "wr"},
+    {"add", OP_ADD, "wrr"},       {"sub", OP_SUB, "wrr"},
+    {"mul", OP_MUL, "wrr"},       {"mod", OP_MOD, "wrr"},
+    {"rand", OP_RAND, "wr?r"},    {"pos", OP_POS, "ww"},
+    {"offset", OP_OFFSET, "ww"},  {"dir4", OP_DIR4, "wwr"},
+    {"dir8", OP_DIR8, "wwr"},     {"look", OP_LOOK, "rr"},
+    {"move", OP_MOVE, "rr"},      {"free", OP_FREE, "rr"},
+    {"scan", OP_SCAN, "wwww"},    {"ram", OP_RAM, "rr"},
+    {"shoot", OP_SHOOT, "rr"},    {"sweep", OP_SWEEP, "wwr"},
+    {"jmp", OP_JMP, "l"},         {"jt", OP_JT, "l"},
+    {"jf", OP_JF, "l"},           {"jz", OP_JZ, "rl"},
+    {"jnz", OP_JNZ, "rl"},        {"djnz", OP_DJNZ, "wl"},
+    {"lt", OP_LT, "rr"},          {"eq", OP_EQ, "rr"},
+};
+
+// Same direction orders as the built-in moves
+const int DIR4_X[4] = {-1, 1, 0, 0};
+const int DIR4_Y[4] = {0, 0, -1, 1};
+const int DIR8_X[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+const int DIR8_Y[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+
+std::vector<std::string> tokens(const std::string &line) {
+  std::istringstream in(line.substr(0, line.find('#')));
+  std::vector<std::string> out;
+  std::string t;
+  while (in >> t) {
+    out.push_back(t);
+  }
+  return out;
+}
+
+bool parseInt(const std::string &s, int &value) {
+  if (s.empty())
+    return false;
+  char *end = nullptr;
+  long v = std::strtol(s.c_str(), &end, 10);
+  if (*end != '\0' || v < INT32_MIN || v > INT32_MAX)
+    return false;
+  value = static_cast<int>(v);
+  return true;
+}
+
+// Compiles one "shiptype" block
+class BlockCompiler {
+private:
+  ShipProgram &program;
+  std::string line; // current line, for errors
+  std::map<std::string, size_t> labels;
+  std::vector<std::pair<size_t, std::string>> jumps; // instr, label
+  std::map<int32_t, uint8_t> constants;
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error("shiptype " + program.name + ": " + what +
+                             " in '" + line + "'");
+  }
+
+  uint8_t operand(const std::string &s, bool writable) {
+    int n = 0;
+    if ((s[0] == 'r' || s[0] == 's') && parseInt(s.substr(1), n)) {
+      int limit = s[0] == 'r' ? ShipProgram::SCRATCH_REGS
+                              : ShipProgram::STATE_REGS;
+      if (n < 0 || n >= limit)
+        fail("no register " + s);
+      return static_cast<uint8_t>(s[0] == 'r' ? n
+                                              : ShipProgram::FIRST_STATE + n);
+    }
+    if (!parseInt(s, n))
+      fail("bad operand '" + s + "'");
+    if (writable)
+      fail("cannot write to a literal");
+    auto it = constants.find(n);
+    if (it != constants.end())
+      return it->second;
+    if (program.frame.size() >= ShipProgram::MAX_REGS)
+      fail("too many literals");
+    uint8_t slot = static_cast<uint8_t>(program.frame.size());
+    program.frame.push_back(n);
+    constants[n] = slot;
+    return slot;
+  }
+
+  void directive(const std::vector<std::string> &t) {
+    int n = 0;
+    if (t[0] == "weapon") {
+      // weapon city N | king N | any  [offboard] [damage N]
+      size_t i = 1;
+      if (t.size() < 2)
+        fail("weapon needs a range");
+      if (t[1] == "any") {
+        program.weaponMetric = ShipProgram::ANYWHERE;
+        i = 2;
+      } else if ((t[1] == "city" || t[1] == "king") && t.size() > 2 &&
+                 parseInt(t[2], n) && n >= 0) {
+        program.weaponMetric = t[1] == "city" ? ShipProgram::CITY_BLOCK
+                                              : ShipProgram::CHEBYSHEV;
+        program.weaponRange = n;
+        i = 3;
+      } else {
+        fail("weapon range must be 'city N', 'king N' or 'any'");
+      }
+      for (; i < t.size(); i++) {
+        if (t[i] == "offboard") {
+          program.weaponOffboard = true;
+        } else if (t[i] == "damage" && i + 1 < t.size() &&
+                   parseInt(t[i + 1], n) && n > 0) {
+          program.weaponDamage = n;
+          i++;
+        } else {
+          fail("unknown weapon option '" + t[i] + "'");
+        }
+      }
+      program.hasWeapon = true;
+    } else if (t[0] == "ramming") {
+      if (t.size() != 2 || (t[1] != "offboard" && t[1] != "always"))
+        fail("ramming must be 'offboard' or 'always'");
+      program.ramOffboard = (t[1] == "offboard");
+    } else if (t[0] == "upgrade") {
+      if (t.size() != 3 || !parseInt(t[1], n) || n < 1)
+        fail("upgrade needs a kill count and a type");
+      program.upgradeKills = n;
+      program.upgradeName = t[2];
+    }
+  }
+
+  void instruction(const std::vector<std::string> &t) {
+    const Mnemonic *m = nullptr;
+    for (const Mnemonic &candidate : MNEMONICS) {
+      if (t[0] == candidate.name)
+        m = &candidate;
+    }
+    if (t[0] == "sample") {
+      // sample dx dy diamond5 | ring1 | board
+      if (t.size() != 4)
+        fail("sample needs two registers and a pattern");
+      ShipInstr in = {OP_DIAMOND, operand(t[1], true), operand(t[2], true), 0,
+                      0};
+      if (t[3] == "ring1") {
+        in.op = OP_RING;
+      } else if (t[3] == "board") {
+        in.op = OP_BOARD;
+      } else if (t[3] != "diamond5") {
+        fail("unknown pattern '" + t[3] + "'");
+      }
+      program.code.push_back(in);
+      return;
+    }
+    if (!m)
+      fail("unknown instruction '" + t[0] + "'");
+    if (m->op == OP_SHOOT && !program.hasWeapon)
+      fail("shoot needs a weapon line first");
+
+    ShipInstr in = {static_cast<uint8_t>(m->op), 0, 0, 0, 0};
+    uint8_t *slots[4] = {&in.a, &in.b, &in.c, nullptr};
+    size_t given = t.size() - 1, used = 0, reg = 0;
+    bool optional = false;
+    for (const char *spec = m->operands; *spec; spec++) {
+      if (*spec == '?') {
+        optional = true;
+        continue;
+      }
+      if (used >= given) {
+        if (!optional)
+          fail(std::string(m->name) + " needs more operands");
+        *slots[reg++] = operand("0", false);
+        continue;
+      }
+      const std::string &arg = t[1 + used++];
+      if (*spec == 'l') {
+        jumps.emplace_back(program.code.size(), arg);
+      } else if (reg < 3) {
+        *slots[reg++] = operand(arg, *spec == 'w');
+      } else {
+        in.d = operand(arg, *spec == 'w');
+      }
+    }
+    if (used < given)
+      fail(std::string(m->name) + " has too many operands");
+    program.code.push_back(in);
+  }
+
+public:
+  explicit BlockCompiler(ShipProgram &p) : program(p) {
+    program.frame.assign(ShipProgram::FIRST_CONST, 0);
+  }
+
+  void add(const std::string &text) {
+    line = text;
+    std::vector<std::string> t = tokens(text);
+    if (t.empty())
+      return;
+    if (t.size() == 1 && t[0].size() > 1 && t[0].back() == ':') {
+      std::string name = t[0].substr(0, t[0].size() - 1);
+      if (!labels.emplace(name, program.code.size()).second)
+        fail("duplicate label " + name);
+    } else if (t[0] == "weapon" || t[0] == "ramming" || t[0] == "upgrade") {
+      directive(t);
+    } else {
+      instruction(t);
+    }
+  }
+
+  void finish() {
+    program.code.push_back(ShipInstr{OP_STOP, 0, 0, 0, 0});
+    for (const auto &jump : jumps) {
+      auto it = labels.find(jump.second);
+      if (it == labels.end()) {
+        line = jump.second;
+        fail("unknown label");
+      }
+      program.code[jump.first].d = static_cast<int32_t>(it->second);
+    }
+
+    // Steps a turn can take: one per move / ram, unless one sits in a loop
+    int steps = 0;
+    bool rams = false, unbounded = false;
+    for (size_t i = 0; i < program.code.size(); i++) {
+      const ShipInstr &in = program.code[i];
+      if (in.op == OP_MOVE || in.op == OP_RAM) {
+        steps++;
+        rams = rams || in.op == OP_RAM;
+      }
+      bool jump = in.op >= OP_JMP && in.op <= OP_DJNZ;
+      if (jump && static_cast<size_t>(in.d) <= i) {
+        for (size_t k = in.d; k <= i; k++) {
+          if (program.code[k].op == OP_MOVE || program.code[k].op == OP_RAM)
+            unbounded = true;
+        }
+      }
+    }
+    int weapon = 0;
+    if (program.hasWeapon) {
+      weapon = program.weaponMetric == ShipProgram::ANYWHERE
+                   ? -1
+                   : program.weaponRange;
+    }
+    program.stationary = (steps == 0);
+    program.reach = (unbounded || weapon < 0)
+                        ? -1
+                        : steps + std::max(weapon, rams ? 1 : 0);
+  }
+};
+
+} // namespace
+
+/* ==================== ShipCatalog ==================== */
+
+ShipCatalog::ShipCatalog() { clear(); }
+
+void ShipCatalog::clear() {
+  programs.clear();
+  for (int t = 0; t < SHIP_TYPE_COUNT; t++) {
+    overrides[t] = nullptr;
+  }
+}
+
+const ShipProgram *ShipCatalog::find(const std::string &name) const {
+  for (const std::shared_ptr<ShipProgram> &p : programs) {
+    if (p->name == name)
+      return p.get();
+  }
+  return nullptr;
+}
+
+void ShipCatalog::compile(const std::string &text) {
+  clear();
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::vector<std::string> t = tokens(line);
+    if (t.empty())
+      continue;
+    // shiptype NAME [like BASE]
+    if (t[0] != "shiptype" || (t.size() != 2 && t.size() != 4) ||
+        (t.size() == 4 && t[2] != "like"))
+      throw std::runtime_error("Expected 'shiptype NAME [like TYPE]': " + line);
+
+    std::unique_ptr<ShipProgram> p(new ShipProgram());
+    p->name = t[1];
+    if (find(p->name))
+      throw std::runtime_error("shiptype " + p->name + " defined twice");
+    ShipType builtin = SHIP_NONE;
+    bool isBuiltin = parseShipType(p->name, builtin);
+    if (t.size() == 4) {
+      if (!parseShipType(t[3], p->base))
+        throw std::runtime_error("Unknown ship type in: " + line);
+      if (isBuiltin && p->base != builtin)
+        throw std::runtime_error("shiptype " + p->name + " must be like " +
+                                 p->name);
+    } else if (isBuiltin) {
+      p->base = builtin;
+    } else {
+      throw std::runtime_error("shiptype " + p->name +
+                               " needs 'like <built-in type>'");
+    }
+    p->hasWeapon = false;
+    p->weaponMetric = ShipProgram::ANYWHERE;
+    p->weaponRange = 0;
+    p->weaponDamage = 1;
+    p->weaponOffboard = false;
+    p->ramOffboard = false;
+    p->upgradeKills = 0;
+    p->upgradeBase = SHIP_NONE;
+    p->upgradeProgram = nullptr;
+
+    BlockCompiler block(*p);
+    bool closed = false;
+    while (std::getline(in, line)) {
+      std::vector<std::string> body = tokens(line);
+      if (body.size() == 1 && body[0] == "end") {
+        closed = true;
+        break;
+      }
+      block.add(line);
+    }
+    if (!closed)
+      throw std::runtime_error("shiptype " + p->name + " has no 'end'");
+    block.finish();
+
+    if (isBuiltin) {
+      overrides[builtin] = p.get();
+    }
+    programs.push_back(std::move(p));
+  }
+
+  // Upgrade targets: another script, or a built-in type that has an
+  // upgrade constructor (and may itself be replaced by a script)
+  for (std::shared_ptr<ShipProgram> &p : programs) {
+    if (p->upgradeKills == 0)
+      continue;
+    const ShipProgram *target = find(p->upgradeName);
+    if (target) {
+      p->upgradeBase = target->base;
+      p->upgradeProgram = target;
+    } else if (parseShipType(p->upgradeName, p->upgradeBase) &&
+               (p->upgradeBase == DESTROYER || p->upgradeBase == CORVETTE ||
+                p->upgradeBase == SUPERSHIP)) {
+      p->upgradeProgram = nullptr;
+    } else {
+      throw std::runtime_error("shiptype " + p->name +
+                               ": cannot upgrade to " + p->upgradeName);
+    }
+  }
+}
+
+/* ==================== ScriptedShip ==================== */
+
+static_assert(sizeof(ScriptedShip) <= ShipPool::SLOT_SIZE,
+              "ScriptedShip too big");
+static_assert(ShipProgram::STATE_REGS <= Ship::MAX_STATE_WORDS,
+              "script state does not fit the journal's snapshot");
+
+ScriptedShip::ScriptedShip(const ShipProgram *p, const std::string &symbol,
+                           const std::string &team, GameManager *mgr)
+    : Ship(symbol, team), manager(mgr), program(p), upgradeTo(nullptr) {
+  std::memset(state, 0, sizeof(state));
+}
+
+ScriptedShip::ScriptedShip(Ship &oldShip, const ShipProgram *p,
+                           GameManager *mgr)
+    : Ship(&oldShip), manager(mgr), program(p), upgradeTo(nullptr) {
+  std::memset(state, 0, sizeof(state));
+  int lostLives = DEFAULT_LIVES - oldShip.getLives();
+  if (lostLives > 0) {
+    takeDamage(lostLives);
+  }
+  for (int i = 0; i < oldShip.getKillCount(); i++) {
+    incrementKills();
+  }
+  setBattlefieldPtr(oldShip.getBattlefield());
+  setPosition(oldShip.getPosition().x, oldShip.getPosition().y);
+
+  simLog() << "Upgrading to " << program->name << " from " << getSymbol()
+           << " (team " << getTeam() << ")\n";
+}
+
+Ship *ScriptedShip::clone(GameManager *mgr) const {
+  ScriptedShip *copy = new ScriptedShip(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
+void ScriptedShip::recordKill() {
+  incrementKills();
+  if (program->upgradeKills > 0 && getKillCount() >= program->upgradeKills) {
+    requestUpgrade(program->upgradeBase);
+    upgradeTo = program->upgradeProgram;
+  }
+}
+
+bool ScriptedShip::fire(int tx, int ty) {
+  Battlefield *bf = getBattlefield();
+  if (program->weaponOffboard && isWithinBoundary())
+    return false;
+  // Scripts compute any coordinates; the board only answers for its cells
+  if (!bf->inBounds(tx, ty))
+    return false;
+
+  Position p = getPosition();
+  int dx = std::abs(p.x - tx), dy = std::abs(p.y - ty);
+  if (program->weaponMetric == ShipProgram::CITY_BLOCK &&
+      dx + dy > program->weaponRange)
+    return false;
+  if (program->weaponMetric == ShipProgram::CHEBYSHEV &&
+      (dx > program->weaponRange || dy > program->weaponRange))
+    return false;
+
+  Ship *target = bf->getOccupant(tx, ty);
+  if (!target || !target->isAlive() || target == this)
+    return false;
+  if (target->getTeam() == getTeam())
+    return false;
+  manager->applyHit(this, target, tx, ty, program->weaponDamage);
+  return true;
+}
+
+bool ScriptedShip::ramAt(int tx, int ty) {
+  Battlefield *bf = getBattlefield();
+  if (program->ramOffboard && isWithinBoundary())
+    return false;
+  if (!bf->inBounds(tx, ty))
+    return false;
+
+  // Neighbours only, like every built-in rammer
+  Position p = getPosition();
+  if (std::abs(p.x - tx) > 1 || std::abs(p.y - ty) > 1)
+    return false;
+
+  Ship *occupant = bf->getOccupant(tx, ty);
+  if (!occupant || !occupant->isAlive() || occupant == this)
+    return false;
+  if (occupant->getTeam() == getTeam())
+    return false;
+  manager->applyRam(this, occupant, tx, ty);
+  return true;
+}
+
+void ScriptedShip::performTurn() {
+  Battlefield *bf = getBattlefield();
+  if (!bf)
+    return;
+
+  // Direct threaded dispatch: every handler jumps straight to the next one
+  // (GCC / Clang computed goto), no central switch
+  static const void *const dispatch[OP_COUNT] = {
+      &&op_stop,  &&op_set,  &&op_add,   &&op_sub,    &&op_mul,  &&op_mod,
+      &&op_rand,  &&op_pos,  &&op_offset, &&op_dir4,  &&op_dir8, &&op_look,
+      &&op_move,  &&op_free, &&op_scan,  &&op_ram,    &&op_shoot,
+      &&op_diamond, &&op_ring, &&op_board, &&op_sweep, &&op_jmp,  &&op_jt,
+      &&op_jf,    &&op_jz,   &&op_jnz,   &&op_djnz,   &&op_lt,   &&op_eq};
+
+  int32_t R[ShipProgram::MAX_REGS];
+  std::memcpy(R, program->frame.data(),
+              program->frame.size() * sizeof(int32_t));
+  std::memcpy(R + ShipProgram::FIRST_STATE, state, sizeof(state));
+  Random &rng = manager->getRandom();
+  const ShipInstr *code = program->code.data();
+  const ShipInstr *ip = code;
+  bool flag = false;
+  int loopsLeft = ShipProgram::MAX_LOOPS;
+
+#define VM_NEXT()                                                              \
+  do {                                                                         \
+    ++ip;                                                                      \
+    goto *dispatch[ip->op];                                                    \
+  } while (0)
+#define VM_JUMP(cond)                                                          \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      ++ip;                                                                    \
+    } else if (ip->d > ip - code || --loopsLeft > 0) {                         \
+      ip = code + ip->d;                                                       \
+    } else {                                                                   \
+      goto op_stop; /* runaway loop: end the turn */                           \
+    }                                                                          \
+    goto *dispatch[ip->op];                                                    \
+  } while (0)
+
+  goto *dispatch[ip->op];
+
+op_set:
+  R[ip->a] = R[ip->b];
+  VM_NEXT();
+op_add:
+  R[ip->a] = R[ip->b] + R[ip->c];
+  VM_NEXT();
+op_sub:
+  R[ip->a] = R[ip->b] - R[ip->c];
+  VM_NEXT();
+op_mul:
+  R[ip->a] = R[ip->b] * R[ip->c];
+  VM_NEXT();
+op_mod:
+  R[ip->a] = R[ip->c] != 0 ? R[ip->b] % R[ip->c] : 0;
+  VM_NEXT();
+op_rand:
+  R[ip->a] = (R[ip->b] > 0 ? rng.nextInt(R[ip->b]) : 0) + R[ip->c];
+  VM_NEXT();
+op_pos:
+  R[ip->a] = pos.x;
+  R[ip->b] = pos.y;
+  VM_NEXT();
+op_offset:
+  R[ip->a] += pos.x;
+  R[ip->b] += pos.y;
+  VM_NEXT();
+op_dir4: {
+  int d = R[ip->c] & 3;
+  R[ip->a] = DIR4_X[d];
+  R[ip->b] = DIR4_Y[d];
+  VM_NEXT();
+}
+op_dir8: {
+  int d = R[ip->c] & 7;
+  R[ip->a] = DIR8_X[d];
+  R[ip->b] = DIR8_Y[d];
+  VM_NEXT();
+}
+op_look:
+  simLog() << symbol << " (" << program->name << ") looks at offset("
+           << R[ip->a] << "," << R[ip->b] << ")\n";
+  VM_NEXT();
+op_move: {
+  // One step to a neighbouring cell, as finish() counts it for the reach
+  int x = R[ip->a], y = R[ip->b];
+  flag = !anchored && std::abs(x - pos.x) <= 1 &&
+         std::abs(y - pos.y) <= 1 && bf->inBounds(x, y) && bf->isFree(x, y);
+  if (flag) {
+    bf->setOccupant(pos.x, pos.y, nullptr);
+    bf->setOccupant(x, y, this);
+  }
+  VM_NEXT();
+}
+op_free:
+  flag = bf->inBounds(R[ip->a], R[ip->b]) && bf->isFree(R[ip->a], R[ip->b]);
+  VM_NEXT();
+op_scan: {
+  BoardKernels::NeighbourScan scan;
+  flag = bf->scanNeighbours(pos.x, pos.y, this, scan);
+  R[ip->a] = scan.enemyX;
+  R[ip->b] = scan.enemyY;
+  R[ip->c] = scan.freeX;
+  R[ip->d] = scan.freeY;
+  VM_NEXT();
+}
+op_ram:
+  flag = ramAt(R[ip->a], R[ip->b]);
+  VM_NEXT();
+op_shoot:
+  flag = fire(R[ip->a], R[ip->b]);
+  VM_NEXT();
+op_diamond: {
+  const WeaponPatterns::Offset &o =
+      WeaponPatterns::sample(WeaponPatterns::DIAMOND_5, rng);
+  R[ip->a] = o.dx;
+  R[ip->b] = o.dy;
+  VM_NEXT();
+}
+op_ring: {
+  // A neighbour on the board; flag false (and no draw) if there is none
+  const WeaponPatterns::Pattern<8> &ring = WeaponPatterns::clippedRing1(
+      pos.x, pos.y, bf->getHeight(), bf->getWidth());
+  flag = ring.size > 0;
+  if (flag) {
+    const WeaponPatterns::Offset &o = WeaponPatterns::sample(ring, rng);
+    R[ip->a] = o.dx;
+    R[ip->b] = o.dy;
+  }
+  VM_NEXT();
+}
+op_board: {
+  WeaponPatterns::Offset cell =
+      WeaponPatterns::boardCell(rng, bf->getHeight(), bf->getWidth());
+  R[ip->a] = cell.dx;
+  R[ip->b] = cell.dy;
+  VM_NEXT();
+}
+op_sweep: {
+  int size = WeaponPatterns::FRIGATE_SWEEP.size;
+  int i = ((R[ip->c] % size) + size) % size;
+  R[ip->a] = WeaponPatterns::FRIGATE_SWEEP[i].dx;
+  R[ip->b] = WeaponPatterns::FRIGATE_SWEEP[i].dy;
+  VM_NEXT();
+}
+op_jmp:
+  VM_JUMP(true);
+op_jt:
+  VM_JUMP(flag);
+op_jf:
+  VM_JUMP(!flag);
+op_jz:
+  VM_JUMP(R[ip->a] == 0);
+op_jnz:
+  VM_JUMP(R[ip->a] != 0);
+op_djnz:
+  VM_JUMP(--R[ip->a] != 0);
+op_lt:
+  flag = R[ip->a] < R[ip->b];
+  VM_NEXT();
+op_eq:
+  flag = R[ip->a] == R[ip->b];
+  VM_NEXT();
+op_stop:
+  std::memcpy(state, R + ShipProgram::FIRST_STATE, sizeof(state));
+
+#undef VM_NEXT
+#undef VM_JUMP
+}
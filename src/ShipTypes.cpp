@@ -1,5 +1,8 @@
 #include "ShipTypes.h"
 #include "Battlefield.h"
+#include "Log.h"
+#include "ShipPool.h"
+#include "WeaponPatterns.h"
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -15,8 +18,14 @@ Battleship::Battleship(const std::string &symbol, const std::string &team,
                        GameManager *mgr)
     : Ship(symbol, team), manager(mgr) {}
 
+Ship *Battleship::clone(GameManager *mgr) const {
+  Battleship *copy = new Battleship(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 void Battleship::look(int offsetX, int offsetY) {
-  std::cout << getSymbol() << " is looking at offset(" << offsetX << ","
+  simLog() << getSymbol() << " is looking at offset(" << offsetX << ","
             << offsetY << ")\n";
 }
 
@@ -48,21 +57,21 @@ void Battleship::shoot(int targetX, int targetY) {
 
   // different team => damage
   if (target->getTeam() != getTeam()) {
-    target->takeDamage(1);
-    if (!target->isAlive()) {
-      incrementKills();
-      // if kills >=4 => upgrade
-      if (getKillCount() >= 4) {
-        requestUpgrade("Destroyer");
-        return;
-      }
-    }
+    manager->applyHit(this, target, targetX, targetY, 1);
+  }
+}
+
+void Battleship::recordKill() {
+  incrementKills();
+  // if kills >=4 => upgrade
+  if (getKillCount() >= 4) {
+    requestUpgrade(DESTROYER);
   }
 }
 
 void Battleship::performTurn() {
-  int offsetX = (rand() % 3) - 1;
-  int offsetY = (rand() % 3) - 1;
+  int offsetX = manager->randomInt(3) - 1;
+  int offsetY = manager->randomInt(3) - 1;
 
   look(offsetX, offsetY);
   move();
@@ -75,7 +84,7 @@ void Battleship::decideAndMove() {
     return;
 
   Position p = getPosition();
-  int dir = rand() % 4; // 0=up,1=down,2=left,3=right
+  int dir = manager->randomInt(4); // 0=up,1=down,2=left,3=right
   int nx = p.x, ny = p.y;
   switch (dir) {
   case 0:
@@ -91,10 +100,7 @@ void Battleship::decideAndMove() {
     ny++;
     break;
   }
-  if (nx < 0 || nx >= HEIGHT || ny < 0 || ny >= WIDTH) {
-    return;
-  }
-  if (!bf->getOccupant(nx, ny)) {
+  if (!anchored && bf->isFree(nx, ny)) {
     bf->setOccupant(p.x, p.y, nullptr);
     bf->setOccupant(nx, ny, this);
   }
@@ -107,12 +113,9 @@ void Battleship::shootTwiceRandomPositions() {
 
   Position p = getPosition();
   for (int i = 0; i < 2; i++) {
-    int dx, dy;
-    do {
-      dx = (rand() % 11) - 5; // -5..5
-      dy = (rand() % 11) - 5;
-    } while (std::abs(dx) + std::abs(dy) > 5 || (dx == 0 && dy == 0));
-    shoot(p.x + dx, p.y + dy);
+    const WeaponPatterns::Offset &o =
+        WeaponPatterns::sample(WeaponPatterns::DIAMOND_5, manager->getRandom());
+    shoot(p.x + o.dx, p.y + o.dy);
   }
 }
 
@@ -126,8 +129,14 @@ Cruiser::Cruiser(const std::string &symbol, const std::string &team,
                  GameManager *mgr)
     : Ship(symbol, team), manager(mgr) {}
 
+Ship *Cruiser::clone(GameManager *mgr) const {
+  Cruiser *copy = new Cruiser(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 void Cruiser::look(int offsetX, int offsetY) {
-  std::cout << getSymbol() << " (Cruiser) looks at offset(" << offsetX << ","
+  simLog() << getSymbol() << " (Cruiser) looks at offset(" << offsetX << ","
             << offsetY << ")\n";
 }
 
@@ -151,24 +160,23 @@ void Cruiser::ram(int targetX, int targetY) {
   if (occupant == this)
     return;
 
+  // sink it and move in (upgrade check in recordKill)
   if (occupant->getTeam() != getTeam()) {
-    occupant->takeDamage(occupant->getLives());
-    incrementKills();
-    // move in
-    Position p = getPosition();
-    bf->setOccupant(p.x, p.y, nullptr);
-    bf->setOccupant(targetX, targetY, this);
-    // upgrade if kills >=3
-    if (getKillCount() >= 3) {
-      requestUpgrade("Destroyer");
-      return;
-    }
+    manager->applyRam(this, occupant, targetX, targetY);
+  }
+}
+
+void Cruiser::recordKill() {
+  incrementKills();
+  // upgrade if kills >=3
+  if (getKillCount() >= 3) {
+    requestUpgrade(DESTROYER);
   }
 }
 
 void Cruiser::performTurn() {
-  int offsetX = (rand() % 3) - 1;
-  int offsetY = (rand() % 3) - 1;
+  int offsetX = manager->randomInt(3) - 1;
+  int offsetY = manager->randomInt(3) - 1;
 
   look(offsetX, offsetY);
   move();
@@ -180,28 +188,15 @@ void Cruiser::moveToPreferredNeighbor() {
     return;
 
   Position p = getPosition();
-  int bestX = -1, bestY = -1;
-  for (int dx = -1; dx <= 1; dx++) {
-    for (int dy = -1; dy <= 1; dy++) {
-      if (dx == 0 && dy == 0)
-        continue;
-      int nx = p.x + dx, ny = p.y + dy;
-      if (nx < 0 || nx >= HEIGHT || ny < 0 || ny >= WIDTH)
-        continue;
-
-      Ship *occ = bf->getOccupant(nx, ny);
-      if (occ && occ->isAlive() && occ != this && occ->getTeam() != getTeam()) {
-        ram(nx, ny);
-        return;
-      } else if (!occ && bestX < 0) {
-        bestX = nx;
-        bestY = ny;
-      }
-    }
+  // Ram the first enemy around us, otherwise take the first free cell
+  BoardKernels::NeighbourScan scan;
+  if (bf->scanNeighbours(p.x, p.y, this, scan)) {
+    ram(scan.enemyX, scan.enemyY);
+    return;
   }
-  if (bestX >= 0 && bestY >= 0) {
+  if (!anchored && scan.freeX >= 0 && scan.freeY >= 0) {
     bf->setOccupant(p.x, p.y, nullptr);
-    bf->setOccupant(bestX, bestY, this);
+    bf->setOccupant(scan.freeX, scan.freeY, this);
   }
 }
 
@@ -213,13 +208,19 @@ Destroyer::Destroyer(const std::string &symbol, const std::string &team,
     : Ship(symbol, team), manager(mgr) {
   // no upgrade logic. this is a brand-new ship
   // position = (-1,-1) until placed
-  std::cout << "Constructed fresh Destroyer " << symbol << " for team " << team
+  simLog() << "Constructed fresh Destroyer " << symbol << " for team " << team
             << "\n";
 }
 
+Ship *Destroyer::clone(GameManager *mgr) const {
+  Destroyer *copy = new Destroyer(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 // (B) upgrade from old ship
-Destroyer::Destroyer(const Ship &oldShip, GameManager *mgr)
-    : Ship(oldShip.getSymbol(), oldShip.getTeam()), manager(mgr) {
+Destroyer::Destroyer(Ship &oldShip, GameManager *mgr)
+    : Ship(&oldShip), manager(mgr) {
   int lostLives = DEFAULT_LIVES - oldShip.getLives();
   if (lostLives > 0) {
     takeDamage(lostLives);
@@ -230,12 +231,12 @@ Destroyer::Destroyer(const Ship &oldShip, GameManager *mgr)
   setBattlefieldPtr(oldShip.getBattlefield());
   setPosition(oldShip.getPosition().x, oldShip.getPosition().y);
 
-  std::cout << "Upgrading to Destroyer from " << oldShip.getSymbol()
-            << " (team " << oldShip.getTeam() << ")\n";
+  simLog() << "Upgrading to Destroyer from " << getSymbol() << " (team "
+            << getTeam() << ")\n";
 }
 
 void Destroyer::look(int offX, int offY) {
-  std::cout << getSymbol() << " (Destroyer) looks at offset(" << offX << ","
+  simLog() << getSymbol() << " (Destroyer) looks at offset(" << offX << ","
             << offY << ")\n";
 }
 
@@ -245,7 +246,7 @@ void Destroyer::move() {
     return;
 
   Position p = getPosition();
-  int dir = rand() % 4;
+  int dir = manager->randomInt(4);
   int nx = p.x, ny = p.y;
   switch (dir) {
   case 0:
@@ -261,8 +262,7 @@ void Destroyer::move() {
     ny++;
     break;
   }
-  if (nx >= 0 && nx < HEIGHT && ny >= 0 && ny < WIDTH &&
-      !bf->getOccupant(nx, ny)) {
+  if (!anchored && bf->isFree(nx, ny)) {
     bf->setOccupant(p.x, p.y, nullptr);
     bf->setOccupant(nx, ny, this);
   }
@@ -290,14 +290,7 @@ void Destroyer::shoot(int targetX, int targetY) {
     return;
 
   if (occ->getTeam() != getTeam()) {
-    occ->takeDamage();
-    if (!occ->isAlive()) {
-      incrementKills();
-      if (getKillCount() >= 3) {
-        requestUpgrade("SuperShip");
-        return;
-      }
-    }
+    manager->applyHit(this, occ, targetX, targetY, 1);
   }
 }
 
@@ -320,21 +313,20 @@ void Destroyer::ram(int targetX, int targetY) {
     return;
 
   if (occ->getTeam() != getTeam()) {
-    occ->takeDamage(occ->getLives());
-    incrementKills();
-    Position p = getPosition();
-    bf->setOccupant(p.x, p.y, nullptr);
-    bf->setOccupant(targetX, targetY, this);
-    if (getKillCount() >= 3) {
-      requestUpgrade("SuperShip");
-      return;
-    }
+    manager->applyRam(this, occ, targetX, targetY);
+  }
+}
+
+void Destroyer::recordKill() {
+  incrementKills();
+  if (getKillCount() >= 3) {
+    requestUpgrade(SUPERSHIP);
   }
 }
 
 void Destroyer::performTurn() {
-  int offsetX = (rand() % 3) - 1;
-  int offsetY = (rand() % 3) - 1;
+  int offsetX = manager->randomInt(3) - 1;
+  int offsetY = manager->randomInt(3) - 1;
 
   look(offsetX, offsetY);
   bool didRam = tryRamNeighbor();
@@ -343,12 +335,9 @@ void Destroyer::performTurn() {
   }
   Position p = getPosition();
   for (int i = 0; i < 2; i++) {
-    int dx, dy;
-    do {
-      dx = (rand() % 11) - 5;
-      dy = (rand() % 11) - 5;
-    } while (std::abs(dx) + std::abs(dy) > 5 || (dx == 0 && dy == 0));
-    shoot(p.x + dx, p.y + dy);
+    const WeaponPatterns::Offset &o =
+        WeaponPatterns::sample(WeaponPatterns::DIAMOND_5, manager->getRandom());
+    shoot(p.x + o.dx, p.y + o.dy);
   }
 }
 
@@ -358,41 +347,33 @@ bool Destroyer::tryRamNeighbor() {
     return false;
 
   Position p = getPosition();
-  for (int dx = -1; dx <= 1; dx++) {
-    for (int dy = -1; dy <= 1; dy++) {
-      if (dx == 0 && dy == 0)
-        continue;
-      int nx = p.x + dx, ny = p.y + dy;
-      if (nx < 0 || nx >= HEIGHT || ny < 0 || ny >= WIDTH)
-        continue;
-      Ship *occ = bf->getOccupant(nx, ny);
-      if (occ && occ->isAlive() && occ != this && occ->getTeam() != getTeam()) {
-        ram(nx, ny);
-        return true;
-      }
-    }
+  BoardKernels::NeighbourScan scan;
+  if (bf->scanNeighbours(p.x, p.y, this, scan)) {
+    ram(scan.enemyX, scan.enemyY);
+    return true;
   }
   return false;
 }
 
 /* ==================== FRIGATE ==================== */
 
-const int Frigate::directions[Frigate::SEQ_LEN][2] = {
-    {-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}};
-
 Frigate::Frigate(const std::string &symbol, const std::string &team,
                  GameManager *mgr)
     : ShootingShip(), Ship(symbol, team), manager(mgr), firingIndex(0) {}
 
+Ship *Frigate::clone(GameManager *mgr) const {
+  Frigate *copy = new Frigate(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 void Frigate::shoot(int tx, int ty) {
   Battlefield *bf = getBattlefield();
   if (!bf)
     return;
 
-  // bounds check
-  if (tx < 0 || tx >= HEIGHT || ty < 0 || ty >= WIDTH)
-    return;
-
+  // No bounds check: off-board targets land in the sentinel ring and read
+  // as empty
   Position p = getPosition();
   if (std::abs(p.x - tx) <= 1 && std::abs(p.y - ty) <= 1) {
     Ship *occ = bf->getOccupant(tx, ty);
@@ -404,24 +385,23 @@ void Frigate::shoot(int tx, int ty) {
       return;
 
     if (occ->getTeam() != getTeam()) {
-      occ->takeDamage();
-      if (!occ->isAlive()) {
-        incrementKills();
-        if (getKillCount() >= 3) {
-          requestUpgrade("Corvette");
-          return;
-        }
-      }
+      manager->applyHit(this, occ, tx, ty, 1);
     }
   }
 }
 
+void Frigate::recordKill() {
+  incrementKills();
+  if (getKillCount() >= 3) {
+    requestUpgrade(CORVETTE);
+  }
+}
+
 void Frigate::performTurn() {
   Position p = getPosition();
-  int dx = directions[firingIndex][0];
-  int dy = directions[firingIndex][1];
-  firingIndex = (firingIndex + 1) % SEQ_LEN;
-  shoot(p.x + dx, p.y + dy);
+  const WeaponPatterns::Offset &o = WeaponPatterns::FRIGATE_SWEEP[firingIndex];
+  firingIndex = (firingIndex + 1) % WeaponPatterns::FRIGATE_SWEEP.size;
+  shoot(p.x + o.dx, p.y + o.dy);
 }
 
 /* ==================== CORVETTE ==================== */
@@ -430,13 +410,19 @@ void Frigate::performTurn() {
 Corvette::Corvette(const std::string &symbol, const std::string &team,
                    GameManager *mgr)
     : Ship(symbol, team), manager(mgr) {
-  std::cout << "Constructed fresh Corvette " << symbol << " for team " << team
+  simLog() << "Constructed fresh Corvette " << symbol << " for team " << team
             << "\n";
 }
 
+Ship *Corvette::clone(GameManager *mgr) const {
+  Corvette *copy = new Corvette(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 // (B) upgrade
-Corvette::Corvette(const Ship &oldShip, GameManager *mgr)
-    : Ship(oldShip.getSymbol(), oldShip.getTeam()), manager(mgr) {
+Corvette::Corvette(Ship &oldShip, GameManager *mgr)
+    : Ship(&oldShip), manager(mgr) {
   setBattlefieldPtr(oldShip.getBattlefield());
   setPosition(oldShip.getPosition().x, oldShip.getPosition().y);
   int lostLives = DEFAULT_LIVES - oldShip.getLives();
@@ -446,8 +432,8 @@ Corvette::Corvette(const Ship &oldShip, GameManager *mgr)
   for (int i = 0; i < oldShip.getKillCount(); i++) {
     incrementKills();
   }
-  std::cout << "Upgrading to Corvette from " << oldShip.getSymbol() << " (team "
-            << oldShip.getTeam() << ")\n";
+  simLog() << "Upgrading to Corvette from " << getSymbol() << " (team "
+            << getTeam() << ")\n";
 }
 
 void Corvette::shoot(int tx, int ty) {
@@ -455,10 +441,8 @@ void Corvette::shoot(int tx, int ty) {
   if (!bf)
     return;
 
-  // bounds
-  if (tx < 0 || tx >= HEIGHT || ty < 0 || ty >= WIDTH)
-    return;
-
+  // No bounds check: off-board targets land in the sentinel ring and read
+  // as empty
   Position p = getPosition();
   if (std::abs(p.x - tx) <= 1 && std::abs(p.y - ty) <= 1) {
     Ship *occ = bf->getOccupant(tx, ty);
@@ -470,22 +454,25 @@ void Corvette::shoot(int tx, int ty) {
       return;
 
     if (occ->getTeam() != getTeam()) {
-      occ->takeDamage();
-      if (!occ->isAlive()) {
-        incrementKills();
-      }
+      manager->applyHit(this, occ, tx, ty, 1);
     }
   }
 }
 
 void Corvette::performTurn() {
+  Battlefield *bf = getBattlefield();
+  if (!bf)
+    return;
+
+  // A random neighbour that is on the board
   Position p = getPosition();
-  int dx = (rand() % 3) - 1;
-  int dy = (rand() % 3) - 1;
-  if (dx == 0 && dy == 0) {
-    dx = 1;
-  }
-  shoot(p.x + dx, p.y + dy);
+  const WeaponPatterns::Pattern<8> &ring = WeaponPatterns::clippedRing1(
+      p.x, p.y, bf->getHeight(), bf->getWidth());
+  if (ring.size == 0)
+    return;
+  const WeaponPatterns::Offset &o =
+      WeaponPatterns::sample(ring, manager->getRandom());
+  shoot(p.x + o.dx, p.y + o.dy);
 }
 
 /* ==================== AMPHIBIOUS ==================== */
@@ -494,8 +481,14 @@ Amphibious::Amphibious(const std::string &symbol, const std::string &team,
                        GameManager *mgr)
     : Ship(symbol, team), manager(mgr) {}
 
+Ship *Amphibious::clone(GameManager *mgr) const {
+  Amphibious *copy = new Amphibious(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 void Amphibious::look(int offsetX, int offsetY) {
-  std::cout << getSymbol() << " (Amphibious) looks at offset (" << offsetX
+  simLog() << getSymbol() << " (Amphibious) looks at offset (" << offsetX
             << "," << offsetY << ")\n";
 }
 
@@ -505,7 +498,7 @@ void Amphibious::move() {
     return;
 
   Position p = getPosition();
-  int dir = rand() % 4;
+  int dir = manager->randomInt(4);
   int nx = p.x, ny = p.y;
   switch (dir) {
   case 0:
@@ -521,12 +514,9 @@ void Amphibious::move() {
     ny++;
     break;
   }
-  if (nx >= 0 && nx < HEIGHT && ny >= 0 && ny < WIDTH) {
-    Ship *occ = bf->getOccupant(nx, ny);
-    if (!occ) {
-      bf->setOccupant(p.x, p.y, nullptr);
-      bf->setOccupant(nx, ny, this);
-    }
+  if (!anchored && bf->isFree(nx, ny)) {
+    bf->setOccupant(p.x, p.y, nullptr);
+    bf->setOccupant(nx, ny, this);
   }
 }
 
@@ -550,29 +540,26 @@ void Amphibious::shoot(int targetX, int targetY) {
       return;
 
     if (target->getTeam() != getTeam()) {
-      target->takeDamage();
-      if (!target->isAlive()) {
-        incrementKills();
-        if (getKillCount() >= 4) {
-          requestUpgrade("SuperShip");
-          return;
-        }
-      }
+      manager->applyHit(this, target, targetX, targetY, 1);
     }
   }
 }
 
+void Amphibious::recordKill() {
+  incrementKills();
+  if (getKillCount() >= 4) {
+    requestUpgrade(SUPERSHIP);
+  }
+}
+
 void Amphibious::performTurn() {
   look(0, 0);
   move();
   Position p = getPosition();
   for (int i = 0; i < 2; i++) {
-    int dx, dy;
-    do {
-      dx = (rand() % 11) - 5;
-      dy = (rand() % 11) - 5;
-    } while (std::abs(dx) + std::abs(dy) > 5 || (dx == 0 && dy == 0));
-    shoot(p.x + dx, p.y + dy);
+    const WeaponPatterns::Offset &o =
+        WeaponPatterns::sample(WeaponPatterns::DIAMOND_5, manager->getRandom());
+    shoot(p.x + o.dx, p.y + o.dy);
   }
 }
 
@@ -582,13 +569,19 @@ void Amphibious::performTurn() {
 SuperShip::SuperShip(const std::string &symbol, const std::string &team,
                      GameManager *mgr)
     : Ship(symbol, team), manager(mgr) {
-  std::cout << "Constructed fresh SuperShip " << symbol << " for team " << team
+  simLog() << "Constructed fresh SuperShip " << symbol << " for team " << team
             << "\n";
 }
 
+Ship *SuperShip::clone(GameManager *mgr) const {
+  SuperShip *copy = new SuperShip(*this);
+  copy->manager = mgr;
+  return copy;
+}
+
 // (B) upgrade
-SuperShip::SuperShip(const Ship &oldShip, GameManager *mgr)
-    : Ship(oldShip.getSymbol(), oldShip.getTeam()), manager(mgr) {
+SuperShip::SuperShip(Ship &oldShip, GameManager *mgr)
+    : Ship(&oldShip), manager(mgr) {
   setBattlefieldPtr(oldShip.getBattlefield());
   setPosition(oldShip.getPosition().x, oldShip.getPosition().y);
   int lostLives = DEFAULT_LIVES - oldShip.getLives();
@@ -598,12 +591,12 @@ SuperShip::SuperShip(const Ship &oldShip, GameManager *mgr)
   for (int i = 0; i < oldShip.getKillCount(); i++) {
     incrementKills();
   }
-  std::cout << "Upgrading to SuperShip from " << oldShip.getSymbol()
-            << ", team=" << oldShip.getTeam() << "\n";
+  simLog() << "Upgrading to SuperShip from " << getSymbol()
+            << ", team=" << getTeam() << "\n";
 }
 
 void SuperShip::look(int offsetX, int offsetY) {
-  std::cout << getSymbol() << " (SuperShip) scanning offset (" << offsetX << ","
+  simLog() << getSymbol() << " (SuperShip) scanning offset (" << offsetX << ","
             << offsetY << ")\n";
 }
 
@@ -627,10 +620,7 @@ void SuperShip::shoot(int targetX, int targetY) {
     return;
 
   if (occ->getTeam() != getTeam()) {
-    occ->takeDamage();
-    if (!occ->isAlive()) {
-      incrementKills();
-    }
+    manager->applyHit(this, occ, targetX, targetY, 1);
   }
 }
 
@@ -652,17 +642,13 @@ void SuperShip::ram(int targetX, int targetY) {
     return;
 
   if (occ->getTeam() != getTeam()) {
-    occ->takeDamage(occ->getLives());
-    incrementKills();
-    Position p = getPosition();
-    bf->setOccupant(p.x, p.y, nullptr);
-    bf->setOccupant(targetX, targetY, this);
+    manager->applyRam(this, occ, targetX, targetY);
   }
 }
 
 void SuperShip::performTurn() {
-  int offsetX = (rand() % 3) - 1;
-  int offsetY = (rand() % 3) - 1;
+  int offsetX = manager->randomInt(3) - 1;
+  int offsetY = manager->randomInt(3) - 1;
 
   look(offsetX, offsetY);
   move();
@@ -675,21 +661,12 @@ void SuperShip::moveLikeCruiser() {
     return;
   Position p = getPosition();
 
-  for (int dx = -1; dx <= 1; dx++) {
-    for (int dy = -1; dy <= 1; dy++) {
-      if (dx == 0 && dy == 0)
-        continue;
-      int nx = p.x + dx, ny = p.y + dy;
-      if (nx < 0 || nx >= HEIGHT || ny < 0 || ny >= WIDTH)
-        continue;
-      Ship *occ = bf->getOccupant(nx, ny);
-      if (occ && occ->isAlive() && occ != this && occ->getTeam() != getTeam()) {
-        ram(nx, ny);
-        return;
-      }
-    }
+  BoardKernels::NeighbourScan scan;
+  if (bf->scanNeighbours(p.x, p.y, this, scan)) {
+    ram(scan.enemyX, scan.enemyY);
+    return;
   }
-  int dir = rand() % 8;
+  int dir = manager->randomInt(8);
   int nx = p.x, ny = p.y;
   switch (dir) {
   case 0:
@@ -721,8 +698,7 @@ void SuperShip::moveLikeCruiser() {
     ny++;
     break;
   }
-  if (nx >= 0 && nx < HEIGHT && ny >= 0 && ny < WIDTH &&
-      !bf->getOccupant(nx, ny)) {
+  if (!anchored && bf->isFree(nx, ny)) {
     bf->setOccupant(p.x, p.y, nullptr);
     bf->setOccupant(nx, ny, this);
   }
@@ -733,8 +709,49 @@ void SuperShip::shoot3RandomLocations() {
   if (!bf)
     return;
   for (int i = 0; i < 3; i++) {
-    int rx = rand() % HEIGHT;
-    int ry = rand() % WIDTH;
-    shoot(rx, ry);
-  }
+    WeaponPatterns::Offset cell = WeaponPatterns::boardCell(
+        manager->getRandom(), bf->getHeight(), bf->getWidth());
+    shoot(cell.dx, cell.dy);
+  }
+}
+
+/* ==================== FACTORY ==================== */
+
+// Every ship type must fit in one ShipPool slot
+static_assert(sizeof(Battleship) <= ShipPool::SLOT_SIZE, "Battleship too big");
+static_assert(sizeof(Cruiser) <= ShipPool::SLOT_SIZE, "Cruiser too big");
+static_assert(sizeof(Destroyer) <= ShipPool::SLOT_SIZE, "Destroyer too big");
+static_assert(sizeof(Frigate) <= ShipPool::SLOT_SIZE, "Frigate too big");
+static_assert(sizeof(Corvette) <= ShipPool::SLOT_SIZE, "Corvette too big");
+static_assert(sizeof(Amphibious) <= ShipPool::SLOT_SIZE, "Amphibious too big");
+static_assert(sizeof(SuperShip) <= ShipPool::SLOT_SIZE, "SuperShip too big");
+
+Ship *createShip(ShipType type, const std::string &symbol,
+                 const std::string &team, GameManager *mgr) {
+  switch (type) {
+  case BATTLESHIP:
+    return new Battleship(symbol, team, mgr);
+  case CRUISER:
+    return new Cruiser(symbol, team, mgr);
+  case DESTROYER:
+    return new Destroyer(symbol, team, mgr);
+  case FRIGATE:
+    return new Frigate(symbol, team, mgr);
+  case CORVETTE:
+    return new Corvette(symbol, team, mgr);
+  case AMPHIBIOUS:
+    return new Amphibious(symbol, team, mgr);
+  case SUPERSHIP:
+    return new SuperShip(symbol, team, mgr);
+  default:
+    return nullptr;
+  }
+}
+
+Ship *createShip(const std::string &type, const std::string &symbol,
+                 const std::string &team, GameManager *mgr) {
+  ShipType id;
+  if (!parseShipType(type, id))
+    return nullptr;
+  return createShip(id, symbol, team, mgr);
 }
@@ -0,0 +1,153 @@
+#include "Sketch.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/* ==================== QuantileSketch ==================== */
+
+QuantileSketch::QuantileSketch(int kParam, uint64_t seed)
+    : k(kParam < 8 ? 8 : kParam), n(0), minValue(0), maxValue(0),
+      levels(1), coin(seed) {}
+
+size_t QuantileSketch::capacity(size_t level) const {
+  // k at the top level, shrinking by 2/3 per level below it
+  size_t depth = levels.size() - 1 - level;
+  double cap = k * std::pow(2.0 / 3.0, static_cast<double>(depth));
+  return std::max<size_t>(2, static_cast<size_t>(std::ceil(cap)));
+}
+
+size_t QuantileSketch::retained() const {
+  size_t total = 0;
+  for (const std::vector<double> &l : levels) {
+    total += l.size();
+  }
+  return total;
+}
+
+void QuantileSketch::compress() {
+  for (;;) {
+    size_t total = 0, room = 0;
+    for (size_t h = 0; h < levels.size(); h++) {
+      total += levels[h].size();
+      room += capacity(h);
+    }
+    if (total <= room)
+      return;
+
+    // Over capacity, so some level is full: compact the lowest one
+    size_t h = 0;
+    while (levels[h].size() < capacity(h))
+      h++;
+    if (h + 1 == levels.size()) {
+      levels.emplace_back();
+    }
+    std::vector<double> &level = levels[h];
+    std::vector<double> &above = levels[h + 1];
+    std::sort(level.begin(), level.end());
+    size_t keep = level.size() % 2; // an odd value out stays here
+    for (size_t i = keep + coin.nextInt(2); i < level.size(); i += 2) {
+      above.push_back(level[i]);
+    }
+    level.resize(keep);
+  }
+}
+
+void QuantileSketch::add(double value) {
+  if (n == 0 || value < minValue)
+    minValue = value;
+  if (n == 0 || value > maxValue)
+    maxValue = value;
+  n++;
+  levels[0].push_back(value);
+  if (levels[0].size() >= capacity(0)) {
+    compress();
+  }
+}
+
+void QuantileSketch::merge(const QuantileSketch &other) {
+  if (other.n == 0)
+    return;
+  if (n == 0 || other.minValue < minValue)
+    minValue = other.minValue;
+  if (n == 0 || other.maxValue > maxValue)
+    maxValue = other.maxValue;
+  n += other.n;
+  if (levels.size() < other.levels.size()) {
+    levels.resize(other.levels.size());
+  }
+  for (size_t h = 0; h < other.levels.size(); h++) {
+    levels[h].insert(levels[h].end(), other.levels[h].begin(),
+                     other.levels[h].end());
+  }
+  compress();
+}
+
+double QuantileSketch::quantile(double q) const {
+  if (n == 0)
+    return 0;
+  if (q <= 0)
+    return minValue;
+  if (q >= 1)
+    return maxValue;
+
+  std::vector<std::pair<double, uint64_t>> weighted;
+  weighted.reserve(retained());
+  for (size_t h = 0; h < levels.size(); h++) {
+    for (double v : levels[h]) {
+      weighted.emplace_back(v, uint64_t(1) << h);
+    }
+  }
+  std::sort(weighted.begin(), weighted.end());
+
+  // Total weight can differ a little from n after compactions
+  uint64_t total = 0;
+  for (const auto &w : weighted) {
+    total += w.second;
+  }
+  double target = q * static_cast<double>(total);
+  uint64_t seen = 0;
+  for (const auto &w : weighted) {
+    seen += w.second;
+    if (static_cast<double>(seen) >= target)
+      return w.first;
+  }
+  return maxValue;
+}
+
+/* ==================== DistinctSketch ==================== */
+
+DistinctSketch::DistinctSketch() : rank(REGISTERS, 0) {}
+
+void DistinctSketch::add(uint64_t value) {
+  uint64_t h = Zobrist::mix(value);
+  size_t index = static_cast<size_t>(h >> (64 - INDEX_BITS));
+  // Leading zeros of the remaining bits, plus one; a sentinel bit caps it
+  uint64_t rest = (h << INDEX_BITS) | (uint64_t(1) << (INDEX_BITS - 1));
+  uint8_t r = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+  if (r > rank[index]) {
+    rank[index] = r;
+  }
+}
+
+void DistinctSketch::merge(const DistinctSketch &other) {
+  for (int i = 0; i < REGISTERS; i++) {
+    rank[i] = std::max(rank[i], other.rank[i]);
+  }
+}
+
+double DistinctSketch::estimate() const {
+  const double m = REGISTERS;
+  double sum = 0;
+  int zeros = 0;
+  for (uint8_t r : rank) {
+    sum += std::ldexp(1.0, -r);
+    if (r == 0)
+      zeros++;
+  }
+  double e = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+  if (e <= 2.5 * m && zeros > 0) {
+    e = m * std::log(m / zeros); // linear counting for small sets
+  }
+  return e;
+}
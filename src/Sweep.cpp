@@ -0,0 +1,404 @@
+#include "Sweep.h"
+#include "GameManager.h"
+#include "Log.h"
+#include "Scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Read every remaining value on a line into the given vector
+template <typename T> void readValues(std::istringstream &iss, std::vector<T> &out) {
+  T value;
+  while (iss >> value) {
+    out.push_back(value);
+  }
+}
+
+// Cartesian product helper: every current variant times every value
+template <typename Apply>
+void multiply(std::vector<GameConfig> &variants, const std::vector<int> &values,
+              Apply apply) {
+  if (values.empty())
+    return;
+  std::vector<GameConfig> next;
+  next.reserve(variants.size() * values.size());
+  for (const GameConfig &v : variants) {
+    for (int value : values) {
+      GameConfig copy = v;
+      apply(copy, value);
+      next.push_back(copy);
+    }
+  }
+  variants.swap(next);
+}
+
+void setShipCount(GameConfig &config, const std::string &team,
+                  const std::string &type, int count) {
+  size_t lastOfTeam = config.allShips.size();
+  for (size_t i = 0; i < config.allShips.size(); i++) {
+    GameConfig::ShipInfo &info = config.allShips[i];
+    if (info.team != team)
+      continue;
+    if (info.type == type) {
+      info.count = count;
+      return;
+    }
+    lastOfTeam = i;
+  }
+  // Not in the base fleet yet: add it to the end of the team's block
+  GameConfig::ShipInfo info;
+  info.type = type;
+  info.symbol = type.substr(0, 1);
+  info.count = count;
+  info.team = team;
+  size_t insertAt =
+      lastOfTeam == config.allShips.size() ? lastOfTeam : lastOfTeam + 1;
+  config.allShips.insert(config.allShips.begin() + insertAt, info);
+}
+
+int shipCount(const GameConfig &config, const std::string &team,
+              const std::string &type) {
+  for (const GameConfig::ShipInfo &info : config.allShips) {
+    if (info.team == team && info.type == type)
+      return info.count;
+  }
+  return 0;
+}
+
+std::string cachePath(const std::string &dir, uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.txt",
+                static_cast<unsigned long long>(key));
+  return dir + "/" + name;
+}
+
+} // namespace
+
+SweepSpec SweepRunner::parseSpec(const std::string &filename) {
+  std::ifstream fin(filename);
+  if (!fin.is_open()) {
+    throw std::runtime_error("Cannot open sweep file: " + filename);
+  }
+
+  SweepSpec spec;
+  spec.threads = 0;
+  spec.pin = false;
+  spec.cacheDir = ".sweep_cache";
+
+  std::string line;
+  while (std::getline(fin, line)) {
+    std::istringstream iss(line);
+    std::string token;
+    if (!(iss >> token) || token[0] == '#')
+      continue;
+
+    if (token == "scenario") {
+      iss >> spec.scenarioFile;
+    } else if (token == "seeds") {
+      readValues(iss, spec.seeds);
+    } else if (token == "iterations") {
+      readValues(iss, spec.iterations);
+    } else if (token == "width") {
+      readValues(iss, spec.widths);
+    } else if (token == "height") {
+      readValues(iss, spec.heights);
+    } else if (token == "respawnsPerTurn") {
+      readValues(iss, spec.respawnsPerTurn);
+    } else if (token == "shipRespawns") {
+      readValues(iss, spec.shipRespawns);
+    } else if (token == "count") {
+      // Example: "count A Battleship 1 2 3"
+      SweepSpec::CountAxis axis;
+      iss >> axis.team >> axis.type;
+      readValues(iss, axis.values);
+      spec.counts.push_back(axis);
+    } else if (token == "shiptypes") {
+      // Example: "shiptypes ships/builtin.txt ships/long_guns.txt"
+      readValues(iss, spec.shipTypeFiles);
+    } else if (token == "threads") {
+      iss >> spec.threads;
+    } else if (token == "pin") {
+      iss >> spec.pin;
+    } else if (token == "cache") {
+      iss >> spec.cacheDir;
+    } else if (token == "output") {
+      iss >> spec.output;
+    } else {
+      throw std::runtime_error("Unknown sweep keyword: " + token);
+    }
+  }
+
+  if (spec.scenarioFile.empty()) {
+    throw std::runtime_error("Sweep file needs a 'scenario' line");
+  }
+  if (spec.seeds.empty()) {
+    spec.seeds.push_back(1);
+  }
+  return spec;
+}
+
+std::vector<GameConfig>
+SweepRunner::expandVariants(const SweepSpec &spec,
+                            const GameConfig &base) const {
+  std::vector<GameConfig> variants(1, base);
+  multiply(variants, spec.iterations,
+           [](GameConfig &c, int v) { c.iterations = v; });
+  multiply(variants, spec.widths, [](GameConfig &c, int v) { c.width = v; });
+  multiply(variants, spec.heights, [](GameConfig &c, int v) { c.height = v; });
+  multiply(variants, spec.respawnsPerTurn,
+           [](GameConfig &c, int v) { c.respawnsPerTurn = v; });
+  multiply(variants, spec.shipRespawns,
+           [](GameConfig &c, int v) { c.shipRespawns = v; });
+  for (const SweepSpec::CountAxis &axis : spec.counts) {
+    multiply(variants, axis.values, [&axis](GameConfig &c, int v) {
+      setShipCount(c, axis.team, axis.type, v);
+    });
+  }
+  if (!spec.shipTypeFiles.empty()) {
+    GameParser parser;
+    std::vector<std::string> texts;
+    std::vector<int> indices;
+    for (const std::string &file : spec.shipTypeFiles) {
+      indices.push_back(static_cast<int>(texts.size()));
+      texts.push_back(parser.loadShipTypes(file));
+    }
+    multiply(variants, indices,
+             [&texts](GameConfig &c, int v) { c.shipTypes = texts[v]; });
+  }
+
+  // Islands outside a shrunk board would be ignored by the Battlefield
+  // anyway; dropping them keeps the cache key canonical
+  for (GameConfig &v : variants) {
+    std::vector<Position> kept;
+    for (const Position &p : v.islands) {
+      if (p.x < v.height && p.y < v.width)
+        kept.push_back(p);
+    }
+    v.islands.swap(kept);
+  }
+  return variants;
+}
+
+uint64_t SweepRunner::scenarioHash(const std::string &configText,
+                                   uint64_t seed) {
+  std::ostringstream key;
+  key << configText << "\nseed " << seed << "\nengine " << ENGINE_VERSION;
+  std::string text = key.str();
+
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (unsigned char c : text) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+std::vector<std::string> SweepRunner::teamsOf(const GameConfig &config) {
+  std::vector<std::string> teams;
+  for (const GameConfig::ShipInfo &info : config.allShips) {
+    bool seen = false;
+    for (const std::string &t : teams) {
+      if (t == info.team)
+        seen = true;
+    }
+    if (!seen)
+      teams.push_back(info.team);
+  }
+  return teams;
+}
+
+SweepResult SweepRunner::playGame(const GameConfig &config,
+                                  const std::vector<std::string> &teams) {
+  ScopedLog quiet(nullLog());
+
+  GameManager manager;
+  manager.loadConfig(config);
+  manager.runSimulation(config.iterations);
+  return summarise(manager, teams);
+}
+
+SweepResult SweepRunner::summarise(const GameManager &manager,
+                                   const std::vector<std::string> &teams) {
+  SweepResult result;
+  result.stalemate = manager.isStalemate();
+  result.stateHash = manager.stateHash();
+  result.winner =
+      manager.getWinningTeam().empty() ? "-" : manager.getWinningTeam();
+  if (result.stalemate) {
+    result.winner = "stalemate";
+  }
+  result.turns = manager.getTurnsPlayed();
+  result.alive.assign(teams.size(), 0);
+  result.kills = 0;
+  std::fill(result.typeKills, result.typeKills + SHIP_TYPE_COUNT, 0);
+  for (Ship *s : manager.getShips()) {
+    result.kills += s->getKillCount();
+    result.typeKills[s->getType()] += s->getKillCount();
+    if (!s->isAlive())
+      continue;
+    for (size_t t = 0; t < teams.size(); t++) {
+      if (teams[t] == s->getTeam())
+        result.alive[t]++;
+    }
+  }
+  return result;
+}
+
+bool SweepRunner::loadCached(const std::string &dir, uint64_t key,
+                             size_t teamCount, SweepResult &result) const {
+  if (dir.empty())
+    return false;
+  std::ifstream in(cachePath(dir, key));
+  if (!in.is_open())
+    return false;
+
+  SweepResult r;
+  r.alive.assign(teamCount, 0);
+  if (!(in >> r.winner >> r.turns))
+    return false;
+  r.stalemate = (r.winner == "stalemate");
+  r.stateHash = 0;
+  std::fill(r.typeKills, r.typeKills + SHIP_TYPE_COUNT, 0);
+  for (size_t t = 0; t < teamCount; t++) {
+    if (!(in >> r.alive[t]))
+      return false;
+  }
+  if (!(in >> r.kills))
+    return false;
+  result = r;
+  return true;
+}
+
+void SweepRunner::storeCached(const std::string &dir, uint64_t key,
+                              const SweepResult &result) const {
+  if (dir.empty())
+    return;
+  // Write then rename, so a concurrent sweep never reads half a record
+  std::string path = cachePath(dir, key);
+  std::ostringstream tmpName;
+  tmpName << path << ".tmp" << std::this_thread::get_id();
+  {
+    std::ofstream out(tmpName.str());
+    if (!out.is_open())
+      return;
+    out << result.winner << " " << result.turns;
+    for (int a : result.alive) {
+      out << " " << a;
+    }
+    out << " " << result.kills << "\n";
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmpName.str(), path, ec);
+}
+
+int SweepRunner::run(const SweepSpec &spec, Scheduler &scheduler) {
+  GameParser parser;
+  GameConfig base = parser.parseFile(spec.scenarioFile);
+  base.hasSeed = false; // the sweep's own seeds are used instead
+  std::vector<std::string> teams = teamsOf(base);
+  std::vector<GameConfig> variants = expandVariants(spec, base);
+
+  if (!spec.cacheDir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(spec.cacheDir, ec);
+  }
+
+  // One job per (variant, seed)
+  struct Job {
+    size_t variant;
+    GameConfig config;
+    uint64_t key;
+    SweepResult result;
+    bool cached;
+  };
+  std::vector<Job> jobs;
+  for (size_t v = 0; v < variants.size(); v++) {
+    std::string text = parser.serialize(variants[v]);
+    for (uint64_t seed : spec.seeds) {
+      Job job;
+      job.variant = v;
+      job.config = variants[v];
+      job.config.hasSeed = true;
+      job.config.seed = seed;
+      job.key = scenarioHash(text, seed);
+      job.cached = false;
+      jobs.push_back(job);
+    }
+  }
+
+  // One game per index; neighbouring jobs share a variant, so keep them
+  // together in small chunks
+  std::atomic<size_t> hits(0);
+  scheduler.resetStats();
+  scheduler.parallelFor(0, jobs.size(), 4, [&](size_t i) {
+    Job &job = jobs[i];
+    if (loadCached(spec.cacheDir, job.key, teams.size(), job.result)) {
+      job.cached = true;
+      hits++;
+      return;
+    }
+    job.result = playGame(job.config, teams);
+    storeCached(spec.cacheDir, job.key, job.result);
+  });
+
+  std::cerr << "Sweep: " << variants.size() << " variants, " << jobs.size()
+            << " runs (" << hits.load() << " from cache)\n";
+  scheduler.report(std::cerr);
+
+  // Results table, one row per run
+  std::ofstream file;
+  if (!spec.output.empty()) {
+    file.open(spec.output);
+    if (!file.is_open()) {
+      throw std::runtime_error("Cannot write sweep output: " + spec.output);
+    }
+  }
+  std::ostream &out = spec.output.empty() ? std::cout : file;
+
+  out << "variant,seed,iterations,width,height,respawnsPerTurn,shipRespawns";
+  for (const SweepSpec::CountAxis &axis : spec.counts) {
+    out << "," << axis.team << "." << axis.type;
+  }
+  std::vector<std::string> shipTypeTexts;
+  if (!spec.shipTypeFiles.empty()) {
+    out << ",shiptypes";
+    for (const std::string &file : spec.shipTypeFiles) {
+      shipTypeTexts.push_back(parser.loadShipTypes(file));
+    }
+  }
+  out << ",winner,turns";
+  for (const std::string &t : teams) {
+    out << ",alive_" << t;
+  }
+  out << ",kills,cached\n";
+
+  for (const Job &job : jobs) {
+    const GameConfig &c = job.config;
+    out << job.variant << "," << c.seed << "," << c.iterations << ","
+        << c.width << "," << c.height << "," << c.respawnsPerTurn << ","
+        << c.shipRespawns;
+    for (const SweepSpec::CountAxis &axis : spec.counts) {
+      out << "," << shipCount(c, axis.team, axis.type);
+    }
+    for (size_t f = 0; f < shipTypeTexts.size(); f++) {
+      if (shipTypeTexts[f] == c.shipTypes) {
+        out << "," << spec.shipTypeFiles[f];
+        break;
+      }
+    }
+    out << "," << job.result.winner << "," << job.result.turns;
+    for (int a : job.result.alive) {
+      out << "," << a;
+    }
+    out << "," << job.result.kills << "," << (job.cached ? 1 : 0) << "\n";
+  }
+  return 0;
+}
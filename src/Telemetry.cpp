@@ -0,0 +1,320 @@
+#include "Telemetry.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[8] = {'W', 'S', 'T', 'E', 'L', 'E', 'M', '\0'};
+
+// Columns below this one are deltas to the previous row of the chunk; the
+// others are deltas to the same ship's previous row (0 before its first),
+// which may be in an earlier chunk
+const int FIRST_PER_SHIP = TelemetryWriter::X;
+const int PER_SHIP = TelemetryWriter::COLUMNS - FIRST_PER_SHIP;
+
+uint64_t zigzag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+int bitWidth(uint64_t v) { return v == 0 ? 0 : 64 - __builtin_clzll(v); }
+
+// Bit-pack `count` values as one block: width byte, then the bits
+void packBlock(const uint64_t *values, size_t count,
+               std::vector<uint8_t> &out) {
+  uint64_t all = 0;
+  for (size_t i = 0; i < count; i++) {
+    all |= values[i];
+  }
+  int width = bitWidth(all);
+  out.push_back(static_cast<uint8_t>(width));
+  if (width == 0)
+    return;
+
+  // Widths are at most 33 bits and fewer than 8 bits stay pending
+  uint64_t acc = 0;
+  int bits = 0;
+  for (size_t i = 0; i < count; i++) {
+    acc |= values[i] << bits;
+    bits += width;
+    while (bits >= 8) {
+      out.push_back(static_cast<uint8_t>(acc));
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+  if (bits > 0) {
+    out.push_back(static_cast<uint8_t>(acc));
+  }
+}
+
+// Inverse of packBlock(); returns the position after the block
+size_t unpackBlock(const std::vector<uint8_t> &in, size_t pos, size_t count,
+                   uint64_t *values) {
+  if (pos >= in.size())
+    throw std::runtime_error("Telemetry: truncated column");
+  int width = in[pos++];
+  if (width > 33)
+    throw std::runtime_error("Telemetry: bad bit width");
+  if (width == 0) {
+    for (size_t i = 0; i < count; i++) {
+      values[i] = 0;
+    }
+    return pos;
+  }
+  size_t bytes = (count * width + 7) / 8;
+  if (pos + bytes > in.size())
+    throw std::runtime_error("Telemetry: truncated column");
+
+  uint64_t mask = (uint64_t(1) << width) - 1;
+  uint64_t acc = 0;
+  int bits = 0;
+  for (size_t i = 0; i < count; i++) {
+    while (bits < width) {
+      acc |= static_cast<uint64_t>(in[pos++]) << bits;
+      bits += 8;
+    }
+    values[i] = acc & mask;
+    acc >>= width;
+    bits -= width;
+  }
+  return pos;
+}
+
+template <typename T> void writeRaw(std::ostream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool readRaw(std::istream &in, T &value) {
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+void writeString(std::ostream &out, const std::string &s) {
+  writeRaw(out, static_cast<uint16_t>(s.size()));
+  out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+std::string readString(std::istream &in) {
+  uint16_t length = 0;
+  if (!readRaw(in, length))
+    throw std::runtime_error("Telemetry: truncated header");
+  std::string s(length, '\0');
+  if (length > 0 && !in.read(&s[0], length))
+    throw std::runtime_error("Telemetry: truncated header");
+  return s;
+}
+
+} // namespace
+
+const char *TelemetryWriter::columnName(int column) {
+  static const char *const names[COLUMNS] = {
+      "turn", "ship", "x", "y", "lives", "kills", "type", "events"};
+  return (column >= 0 && column < COLUMNS) ? names[column] : "?";
+}
+
+TelemetryWriter::TelemetryWriter(const std::string &path)
+    : file(path, std::ios::binary | std::ios::trunc), headerWritten(false),
+      rowsWritten(0), bytesWritten(0) {
+  if (!file)
+    throw std::runtime_error("Cannot open telemetry file: " + path);
+  for (std::vector<int32_t> &c : columns) {
+    c.reserve(CHUNK_ROWS);
+  }
+}
+
+TelemetryWriter::~TelemetryWriter() {
+  try {
+    finish();
+  } catch (...) {
+    // Nothing sensible to do this late
+  }
+}
+
+void TelemetryWriter::writeHeader(const GameManager &manager) {
+  const std::vector<Ship *> &ships = manager.getShips();
+  file.write(MAGIC, sizeof(MAGIC));
+  writeRaw(file, VERSION);
+  writeRaw(file, static_cast<uint32_t>(ships.size()));
+  for (const Ship *s : ships) {
+    writeString(file, s->getSymbol());
+    writeString(file, s->getTeam());
+  }
+  bytesWritten = static_cast<uint64_t>(file.tellp());
+
+  lastType.assign(ships.size(), SHIP_NONE);
+  lastLives.assign(ships.size(), -1);
+  lastRespawns.assign(ships.size(), 0);
+  shipPrev.assign(ships.size() * PER_SHIP, 0);
+  headerWritten = true;
+}
+
+void TelemetryWriter::turnEnded(const GameManager &manager, int turn) {
+  if (!headerWritten) {
+    writeHeader(manager);
+  }
+
+  const Battlefield &bf = manager.getBattlefield();
+  const std::vector<Ship *> &ships = manager.getShips();
+  for (size_t i = 0; i < ships.size(); i++) {
+    const Ship *s = ships[i];
+    Position p = s->getPosition();
+    bool onBoard = bf.inBounds(p.x, p.y) && bf.getOccupant(p.x, p.y) == s;
+    int32_t type = s->getType();
+    int32_t lives = s->getLives();
+    int32_t respawns = s->getRespawnCount();
+
+    int32_t events = 0;
+    if (lastLives[i] >= 0) { // not the ship's first row
+      if (type != lastType[i])
+        events |= EVENT_UPGRADED;
+      if (lives == 0 && lastLives[i] > 0)
+        events |= EVENT_SUNK;
+      if (respawns > lastRespawns[i])
+        events |= EVENT_RESPAWNED;
+    }
+    lastType[i] = type;
+    lastLives[i] = lives;
+    lastRespawns[i] = respawns;
+
+    columns[TURN].push_back(turn);
+    columns[SHIP].push_back(static_cast<int32_t>(i));
+    columns[X].push_back(onBoard ? p.x : -1);
+    columns[Y].push_back(onBoard ? p.y : -1);
+    columns[LIVES].push_back(lives);
+    columns[KILLS].push_back(s->getKillCount());
+    columns[TYPE].push_back(type);
+    columns[EVENTS].push_back(events);
+    if (columns[TURN].size() == CHUNK_ROWS) {
+      flushChunk();
+    }
+  }
+}
+
+void TelemetryWriter::flushChunk() {
+  size_t rows = columns[TURN].size();
+  if (rows == 0)
+    return;
+
+  writeRaw(file, static_cast<uint32_t>(rows));
+  uint64_t deltas[BLOCK_ROWS];
+  for (int c = 0; c < COLUMNS; c++) {
+    const std::vector<int32_t> &column = columns[c];
+    packed.clear();
+    int64_t prev = 0;
+    for (size_t start = 0; start < rows; start += BLOCK_ROWS) {
+      size_t count = std::min(BLOCK_ROWS, rows - start);
+      for (size_t j = 0; j < count; j++) {
+        size_t r = start + j;
+        int64_t v = column[r];
+        if (c < FIRST_PER_SHIP) {
+          deltas[j] = zigzag(v - prev);
+          prev = v;
+        } else {
+          int32_t &last =
+              shipPrev[columns[SHIP][r] * PER_SHIP + (c - FIRST_PER_SHIP)];
+          deltas[j] = zigzag(v - last);
+          last = static_cast<int32_t>(v);
+        }
+      }
+      packBlock(deltas, count, packed);
+    }
+    writeRaw(file, static_cast<uint32_t>(packed.size()));
+    file.write(reinterpret_cast<const char *>(packed.data()),
+               static_cast<std::streamsize>(packed.size()));
+    bytesWritten += 4 + packed.size();
+  }
+  bytesWritten += 4;
+  rowsWritten += rows;
+  if (!file)
+    throw std::runtime_error("Telemetry: write failed");
+
+  for (std::vector<int32_t> &column : columns) {
+    column.clear();
+  }
+}
+
+void TelemetryWriter::finish() {
+  if (!file.is_open())
+    return;
+  flushChunk();
+  file.close();
+}
+
+void TelemetryWriter::dump(const std::string &path, std::ostream &out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Cannot open telemetry file: " + path);
+
+  char magic[sizeof(MAGIC)];
+  uint32_t version = 0, shipCount = 0;
+  if (!in.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), MAGIC))
+    throw std::runtime_error("Not a telemetry file: " + path);
+  if (!readRaw(in, version) || version != VERSION)
+    throw std::runtime_error("Unsupported telemetry version in " + path);
+  if (!readRaw(in, shipCount))
+    throw std::runtime_error("Telemetry: truncated header");
+  std::vector<std::string> symbols(shipCount), teams(shipCount);
+  for (uint32_t i = 0; i < shipCount; i++) {
+    symbols[i] = readString(in);
+    teams[i] = readString(in);
+  }
+
+  out << "turn,ship,symbol,team,x,y,lives,kills,type,events\n";
+  std::vector<int32_t> decoded[COLUMNS];
+  std::vector<uint8_t> bytes;
+  std::vector<int32_t> shipPrev(static_cast<size_t>(shipCount) * PER_SHIP);
+  uint64_t values[BLOCK_ROWS];
+  uint32_t rows = 0;
+  while (readRaw(in, rows)) {
+    for (int c = 0; c < COLUMNS; c++) {
+      uint32_t length = 0;
+      if (!readRaw(in, length))
+        throw std::runtime_error("Telemetry: truncated chunk");
+      bytes.resize(length);
+      if (length > 0 &&
+          !in.read(reinterpret_cast<char *>(bytes.data()), length))
+        throw std::runtime_error("Telemetry: truncated chunk");
+
+      std::vector<int32_t> &column = decoded[c];
+      column.resize(rows);
+      if (c == FIRST_PER_SHIP) {
+        for (uint32_t r = 0; r < rows; r++) {
+          if (static_cast<uint32_t>(decoded[SHIP][r]) >= shipCount)
+            throw std::runtime_error("Telemetry: bad ship id");
+        }
+      }
+      size_t pos = 0;
+      int64_t prev = 0;
+      for (size_t start = 0; start < rows; start += BLOCK_ROWS) {
+        size_t count = std::min<size_t>(BLOCK_ROWS, rows - start);
+        pos = unpackBlock(bytes, pos, count, values);
+        for (size_t j = 0; j < count; j++) {
+          size_t r = start + j;
+          if (c < FIRST_PER_SHIP) {
+            prev += unzigzag(values[j]);
+            column[r] = static_cast<int32_t>(prev);
+          } else {
+            int32_t &last =
+                shipPrev[decoded[SHIP][r] * PER_SHIP + (c - FIRST_PER_SHIP)];
+            last = static_cast<int32_t>(last + unzigzag(values[j]));
+            column[r] = last;
+          }
+        }
+      }
+    }
+
+    for (uint32_t r = 0; r < rows; r++) {
+      int32_t ship = decoded[SHIP][r];
+      out << decoded[TURN][r] << ',' << ship << ',' << symbols[ship] << ','
+          << teams[ship] << ',' << decoded[X][r] << ',' << decoded[Y][r]
+          << ',' << decoded[LIVES][r] << ',' << decoded[KILLS][r] << ','
+          << shipTypeName(static_cast<ShipType>(decoded[TYPE][r])) << ','
+          << decoded[EVENTS][r] << '\n';
+    }
+  }
+}
@@ -0,0 +1,70 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel() : now(0), count(0) { reset(0); }
+
+void TimingWheel::reset(size_t items, uint64_t start) {
+  now = start;
+  count = 0;
+  next.assign(items, -1);
+  due.assign(items, 0);
+  for (int l = 0; l < LEVELS; l++) {
+    for (int s = 0; s < SLOTS; s++) {
+      head[l][s] = tail[l][s] = -1;
+    }
+  }
+}
+
+void TimingWheel::place(int32_t item) {
+  uint64_t diff = due[item] ^ now;
+  int level = 0;
+  while (level < LEVELS - 1 && (diff >> (SLOT_BITS * (level + 1))) != 0) {
+    level++;
+  }
+  int slot = static_cast<int>((due[item] >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+  next[item] = -1;
+  if (tail[level][slot] < 0) {
+    head[level][slot] = item;
+  } else {
+    next[tail[level][slot]] = item;
+  }
+  tail[level][slot] = item;
+}
+
+void TimingWheel::schedule(int32_t item, uint64_t tick) {
+  due[item] = tick > now ? tick : now + 1;
+  place(item);
+  count++;
+}
+
+void TimingWheel::cascade(int level) {
+  int slot = static_cast<int>((now >> (SLOT_BITS * level)) & (SLOTS - 1));
+  // Detach first: an item still out of range lands in this slot again
+  int32_t item = head[level][slot];
+  head[level][slot] = tail[level][slot] = -1;
+  while (item >= 0) {
+    int32_t following = next[item];
+    place(item);
+    item = following;
+  }
+}
+
+void TimingWheel::advance(std::pmr::vector<int32_t> &out) {
+  now++;
+  // Top wheel first, so what it hands down is cascaded again this tick
+  for (int level = LEVELS - 1; level > 0; level--) {
+    uint64_t below = (uint64_t(1) << (SLOT_BITS * level)) - 1;
+    if ((now & below) == 0) {
+      cascade(level);
+    }
+  }
+
+  int slot = static_cast<int>(now & (SLOTS - 1));
+  int32_t item = head[0][slot];
+  head[0][slot] = tail[0][slot] = -1;
+  while (item >= 0) {
+    out.push_back(item);
+    count--;
+    item = next[item];
+  }
+}
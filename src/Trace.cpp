@@ -0,0 +1,274 @@
+#include "Trace.h"
+#include "Log.h"
+#include "Random.h"
+#include "ScenarioImage.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+uint64_t fnv1a(uint64_t h, const std::string &text) {
+  for (unsigned char c : text) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+std::string hex64(uint64_t v) {
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+  return buf;
+}
+
+std::string cellName(int x, int y) {
+  if (x < 0)
+    return "off board";
+  return "cell (" + std::to_string(x) + "," + std::to_string(y) + ")";
+}
+
+// Ships on the board sort by cell, the rest stay in fleet order after them
+bool cellBefore(const TraceRecorder::Entry &a, const TraceRecorder::Entry &b) {
+  if (a.x < 0 || b.x < 0)
+    return b.x < 0 && a.x >= 0;
+  return a.x != b.x ? a.x < b.x : a.y < b.y;
+}
+
+} // namespace
+
+void TraceRecorder::turnEnded(const GameManager &manager, int turn) {
+  const Battlefield &bf = manager.getBattlefield();
+
+  Turn t;
+  t.turn = turn;
+  t.rngCounter = manager.getRandom().getCounter();
+  t.entries.reserve(manager.getShips().size());
+  for (const Ship *s : manager.getShips()) {
+    Position p = s->getPosition();
+    bool onBoard = bf.inBounds(p.x, p.y) && bf.getOccupant(p.x, p.y) == s;
+
+    std::ostringstream line;
+    if (onBoard) {
+      line << p.x << ' ' << p.y;
+    } else {
+      line << "- -";
+    }
+    line << ' ' << s->getSymbol() << ' ' << s->getTeam() << ' '
+         << shipTypeName(s->getType()) << ' ' << s->getLives() << ' '
+         << s->getKillCount() << ' ' << s->getRespawnCount();
+
+    Entry e;
+    e.x = onBoard ? p.x : -1;
+    e.y = onBoard ? p.y : -1;
+    e.text = line.str();
+    t.entries.push_back(e);
+  }
+  std::stable_sort(t.entries.begin(), t.entries.end(), cellBefore);
+
+  uint64_t h = fnv1a(0xcbf29ce484222325ULL, std::to_string(t.rngCounter));
+  for (const Entry &e : t.entries) {
+    h = fnv1a(h, e.text + '\n');
+  }
+  t.hash = h;
+  turns.push_back(t);
+}
+
+void TraceRecorder::write(std::ostream &out, uint64_t seed) const {
+  out << "trace " << ENGINE_VERSION << ' ' << seed << '\n';
+  for (const Turn &t : turns) {
+    out << "turn " << t.turn << ' ' << hex64(t.hash) << ' ' << t.rngCounter
+        << '\n';
+    for (const Entry &e : t.entries) {
+      out << e.text << '\n';
+    }
+  }
+}
+
+std::vector<TraceRecorder::Turn> TraceRecorder::read(std::istream &in,
+                                                     int &engine) {
+  std::vector<Turn> turns;
+  std::string line, word;
+  uint64_t seed = 0;
+  if (!std::getline(in, line)) {
+    throw std::runtime_error("Not a trace file");
+  }
+  std::istringstream header(line);
+  if (!(header >> word >> engine >> seed) || word != "trace") {
+    throw std::runtime_error("Not a trace file");
+  }
+
+  while (std::getline(in, line)) {
+    if (line.empty())
+      continue;
+    std::istringstream iss(line);
+    if (line.compare(0, 5, "turn ") == 0) {
+      std::string hash;
+      Turn t;
+      if (!(iss >> word >> t.turn >> hash >> t.rngCounter)) {
+        throw std::runtime_error("Bad trace line: " + line);
+      }
+      t.hash = std::stoull(hash, nullptr, 16);
+      turns.push_back(t);
+      continue;
+    }
+
+    std::string x, y;
+    if (turns.empty() || !(iss >> x >> y)) {
+      throw std::runtime_error("Bad trace line: " + line);
+    }
+    Entry e;
+    e.x = (x == "-") ? -1 : std::stoi(x);
+    e.y = (y == "-") ? -1 : std::stoi(y);
+    e.text = line;
+    turns.back().entries.push_back(e);
+  }
+  return turns;
+}
+
+std::string TraceRecorder::compare(const std::vector<Turn> &golden,
+                                   const std::vector<Turn> &actual) {
+  size_t n = std::min(golden.size(), actual.size());
+  for (size_t i = 0; i < n; i++) {
+    const Turn &g = golden[i];
+    const Turn &a = actual[i];
+    if (g.hash == a.hash)
+      continue;
+
+    std::string where = "turn " + std::to_string(g.turn) + ", ";
+    size_t j = 0, k = 0;
+    while (j < g.entries.size() || k < a.entries.size()) {
+      const Entry *ge = j < g.entries.size() ? &g.entries[j] : nullptr;
+      const Entry *ae = k < a.entries.size() ? &a.entries[k] : nullptr;
+      if (ge && ae && !cellBefore(*ge, *ae) && !cellBefore(*ae, *ge)) {
+        if (ge->text != ae->text) {
+          return where + cellName(ge->x, ge->y) + ": expected \"" +
+                 ge->text + "\", got \"" + ae->text + "\"";
+        }
+        j++;
+        k++;
+      } else if (ge && (!ae || cellBefore(*ge, *ae))) {
+        return where + cellName(ge->x, ge->y) + ": expected \"" + ge->text +
+               "\", got nothing";
+      } else {
+        return where + cellName(ae->x, ae->y) + ": expected nothing, got \"" +
+               ae->text + "\"";
+      }
+    }
+    if (g.rngCounter != a.rngCounter) {
+      return where + "random draws: expected " +
+             std::to_string(g.rngCounter) + ", got " +
+             std::to_string(a.rngCounter);
+    }
+    return where + "world hash differs";
+  }
+
+  if (golden.size() != actual.size()) {
+    return "battle ended after " + std::to_string(actual.size()) +
+           " turns, expected " + std::to_string(golden.size());
+  }
+  return "";
+}
+
+GameConfig generateScenario(uint64_t k) {
+  static const char *const TYPES[] = {"Battleship", "Cruiser",    "Destroyer",
+                                      "Frigate",    "Corvette",   "Amphibious",
+                                      "SuperShip"};
+  Random rng(k);
+
+  GameConfig c;
+  c.iterations = 30 + rng.nextInt(41);
+  c.width = 8 + rng.nextInt(25);
+  c.height = 8 + rng.nextInt(25);
+  c.respawnsPerTurn = 1 + rng.nextInt(3);
+  c.shipRespawns = rng.nextInt(4);
+  c.hasSeed = true;
+  c.seed = k;
+  c.layout = static_cast<Battlefield::Layout>(rng.nextInt(4));
+  c.combat = rng.nextInt(2) ? CombatBuffer::BATCHED : CombatBuffer::IMMEDIATE;
+  c.sleeping = false;
+  c.stalemateWindow = 0;
+
+  // About one cell in twenty is island
+  int islands = c.width * c.height / 20;
+  for (int i = 0; i < islands; i++) {
+    c.islands.push_back(Position(rng.nextInt(c.height), rng.nextInt(c.width)));
+  }
+
+  // 2..3 teams of 2..4 ship lines, at most 36 ships on a board of 64+ cells
+  int teams = 2 + rng.nextInt(2);
+  char symbol = 'a';
+  for (int t = 0; t < teams; t++) {
+    int lines = 2 + rng.nextInt(3);
+    for (int l = 0; l < lines; l++) {
+      GameConfig::ShipInfo info;
+      info.type = TYPES[rng.nextInt(7)];
+      info.symbol = std::string(1, symbol++);
+      info.count = 1 + rng.nextInt(3);
+      info.team = std::string(1, static_cast<char>('A' + t));
+      c.allShips.push_back(info);
+    }
+  }
+  return c;
+}
+
+int runTrace(const std::string &scenario, uint64_t seed, bool hasSeed,
+             const std::string &goldenFile) {
+  ScopedLog quiet(nullLog());
+
+  GameManager manager;
+  TraceRecorder recorder;
+  manager.setTurnObserver(&recorder);
+
+  // Traces must be reproducible: unseeded scenarios run with seed 1
+  int iterations;
+  ScenarioImage image;
+  if (ScenarioImage::isImage(scenario)) {
+    image.open(scenario);
+    if (!hasSeed) {
+      seed = image.header().hasSeed ? image.header().seed : 1;
+    }
+    manager.loadImage(image, &seed);
+    iterations = image.header().iterations;
+  } else {
+    GameConfig config;
+    if (scenario.compare(0, 4, "gen:") == 0) {
+      config = generateScenario(std::stoull(scenario.substr(4)));
+    } else {
+      GameParser parser;
+      config = parser.parseFile(scenario);
+    }
+    if (hasSeed || !config.hasSeed) {
+      config.seed = hasSeed ? seed : 1;
+      config.hasSeed = true;
+    }
+    seed = config.seed;
+    manager.loadConfig(config);
+    iterations = config.iterations;
+  }
+  manager.runSimulation(iterations);
+
+  if (goldenFile.empty()) {
+    recorder.write(std::cout, seed);
+    return 0;
+  }
+
+  std::ifstream in(goldenFile);
+  if (!in.is_open()) {
+    throw std::runtime_error("Cannot open golden trace: " + goldenFile);
+  }
+  int engine = 0;
+  std::vector<TraceRecorder::Turn> golden = TraceRecorder::read(in, engine);
+  std::string diff = TraceRecorder::compare(golden, recorder.getTurns());
+  if (diff.empty()) {
+    return 0;
+  }
+  std::cout << scenario << " seed " << seed << ": " << diff << '\n';
+  if (engine != ENGINE_VERSION) {
+    std::cout << "  (golden recorded with engine " << engine << ", this is "
+              << ENGINE_VERSION << ")\n";
+  }
+  return 1;
+}
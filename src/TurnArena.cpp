@@ -0,0 +1,105 @@
+#include "TurnArena.h"
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace {
+
+// Blocks of destroyed arenas, for the next arena on the same thread
+const size_t MAX_SPARE = 8;
+
+struct SpareBlocks {
+  std::vector<std::pair<char *, size_t>> list;
+  ~SpareBlocks() {
+    for (const std::pair<char *, size_t> &b : list) {
+      ::operator delete(b.first);
+    }
+  }
+};
+
+thread_local SpareBlocks spare;
+
+size_t alignUp(size_t n, size_t alignment) {
+  return (n + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+TurnArena::TurnArena() : current(0), offset(0), used(0), peak(0) {}
+
+TurnArena::~TurnArena() {
+  for (const Block &b : blocks) {
+    if (spare.list.size() < MAX_SPARE) {
+      spare.list.emplace_back(b.data, b.size);
+    } else {
+      ::operator delete(b.data);
+    }
+  }
+}
+
+void TurnArena::reset() {
+  current = 0;
+  offset = 0;
+  used = 0;
+}
+
+size_t TurnArena::capacity() const {
+  size_t total = 0;
+  for (const Block &b : blocks) {
+    total += b.size;
+  }
+  return total;
+}
+
+void TurnArena::nextBlock(size_t bytes, size_t alignment) {
+  size_t need = bytes + alignment;
+
+  // A later block kept from an earlier turn, if it is big enough
+  while (current + 1 < blocks.size()) {
+    current++;
+    offset = 0;
+    if (blocks[current].size >= need)
+      return;
+  }
+
+  // Otherwise a spare block, or a new one at least twice the last
+  size_t size = blocks.empty() ? MIN_BLOCK : blocks.back().size * 2;
+  while (size < need)
+    size *= 2;
+  Block b = {nullptr, 0};
+  for (size_t i = 0; i < spare.list.size(); i++) {
+    if (spare.list[i].second >= need) {
+      b.data = spare.list[i].first;
+      b.size = spare.list[i].second;
+      spare.list.erase(spare.list.begin() + static_cast<long>(i));
+      break;
+    }
+  }
+  if (!b.data) {
+    b.data = static_cast<char *>(::operator new(size));
+    b.size = size;
+  }
+  blocks.push_back(b);
+  current = blocks.size() - 1;
+  offset = 0;
+}
+
+void *TurnArena::do_allocate(size_t bytes, size_t alignment) {
+  if (bytes == 0)
+    bytes = 1;
+  for (;;) {
+    if (!blocks.empty()) {
+      const Block &b = blocks[current];
+      uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+      size_t start = alignUp(base + offset, alignment) - base;
+      if (start + bytes <= b.size) {
+        offset = start + bytes;
+        used += bytes;
+        if (used > peak)
+          peak = used;
+        return b.data + start;
+      }
+    }
+    nextBlock(bytes, alignment); // big enough for any alignment
+  }
+}
@@ -0,0 +1,162 @@
+#include "VecEnv.h"
+#include "Log.h"
+#include "Sweep.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+VecEnv::VecEnv(const GameConfig &cfg, int envs)
+    : config(cfg), ships(0), width(cfg.width), height(cfg.height) {
+  if (envs <= 0) {
+    throw std::runtime_error("VecEnv needs at least one environment");
+  }
+  teams = SweepRunner::teamsOf(config);
+  for (const GameConfig::ShipInfo &info : config.allShips) {
+    int t = 0;
+    while (teams[t] != info.team)
+      t++;
+    for (int i = 0; i < info.count; i++) {
+      shipTeam.push_back(t);
+    }
+  }
+  ships = static_cast<int>(shipTeam.size());
+
+  terrainPlane.assign(static_cast<size_t>(width) * height, 0.0f);
+  for (const Position &p : config.islands) {
+    if (p.x >= 0 && p.x < height && p.y >= 0 && p.y < width) {
+      terrainPlane[static_cast<size_t>(p.x) * width + p.y] = 1.0f;
+    }
+  }
+
+  for (int e = 0; e < envs; e++) {
+    managers.emplace_back(new GameManager());
+  }
+  turn.assign(envs, 0);
+  finished.assign(envs, 1);
+  actionScratch.assign(ships, ACTION_AUTO);
+  aliveBefore.assign(ships, 0);
+}
+
+void VecEnv::reset(const uint64_t *seeds) {
+  for (int e = 0; e < envCount(); e++) {
+    resetEnv(e, seeds[e]);
+  }
+}
+
+void VecEnv::resetEnv(int env, uint64_t seed) {
+  ScopedLog quiet(nullLog());
+  GameManager &m = *managers[env];
+  m.reset();
+  config.hasSeed = true;
+  config.seed = seed;
+  m.loadConfig(config);
+  if (static_cast<int>(m.getShips().size()) != ships) {
+    throw std::runtime_error("VecEnv: scenario has an unknown ship type");
+  }
+  m.prepareRun(config.iterations);
+  turn[env] = 0;
+  finished[env] = config.iterations <= 0;
+}
+
+void VecEnv::step(const int8_t *actions, ActionMode mode, float *rewards,
+                  uint8_t *dones) {
+  ScopedLog quiet(nullLog());
+  const int teamTotal = teamCount();
+  for (int e = 0; e < envCount(); e++) {
+    float *reward = rewards + static_cast<size_t>(e) * teamTotal;
+    for (int t = 0; t < teamTotal; t++) {
+      reward[t] = 0.0f;
+    }
+    if (finished[e]) {
+      dones[e] = 1;
+      continue;
+    }
+
+    GameManager &m = *managers[e];
+    const std::vector<Ship *> &fleet = m.getShips();
+    for (int i = 0; i < ships; i++) {
+      aliveBefore[i] = fleet[i]->isAlive();
+      actionScratch[i] =
+          mode == PER_SHIP ? actions[static_cast<size_t>(e) * ships + i]
+                           : actions[static_cast<size_t>(e) * teamTotal +
+                                     shipTeam[i]];
+    }
+
+    m.setShipActions(actionScratch.data());
+    bool victory = m.playTurn(++turn[e]);
+    m.setShipActions(nullptr);
+
+    for (int i = 0; i < ships; i++) {
+      if (!aliveBefore[i] || fleet[i]->isAlive())
+        continue;
+      for (int t = 0; t < teamTotal; t++) {
+        reward[t] += (t == shipTeam[i]) ? -1.0f : 1.0f;
+      }
+    }
+    finished[e] = victory || turn[e] >= config.iterations;
+    dones[e] = finished[e];
+  }
+}
+
+void VecEnv::observe(float *obs) const {
+  const size_t plane = static_cast<size_t>(width) * height;
+  const int livesChannel = 1 + teamCount();
+  for (int e = 0; e < envCount(); e++) {
+    float *out = obs + static_cast<size_t>(e) * observationSize();
+    std::memcpy(out, terrainPlane.data(), plane * sizeof(float));
+    std::memset(out + plane, 0, (observationSize() - plane) * sizeof(float));
+
+    // Walk the fleet rather than the board: only ships on the board count
+    const GameManager &m = *managers[e];
+    const Battlefield &bf = m.getBattlefield();
+    const std::vector<Ship *> &fleet = m.getShips();
+    for (int i = 0; i < ships; i++) {
+      const Ship *s = fleet[i];
+      Position p = s->getPosition();
+      if (!s->isAlive() || !bf.inBounds(p.x, p.y) ||
+          bf.getOccupant(p.x, p.y) != s)
+        continue;
+      size_t cell = static_cast<size_t>(p.x) * width + p.y;
+      out[(1 + shipTeam[i]) * plane + cell] = 1.0f;
+      out[livesChannel * plane + cell] =
+          static_cast<float>(s->getLives()) / DEFAULT_LIVES;
+    }
+  }
+}
+
+int runEnvBench(const GameConfig &config, int envs, int steps) {
+  VecEnv env(config, envs);
+  std::vector<uint64_t> seeds(envs);
+  for (int e = 0; e < envs; e++) {
+    seeds[e] = e + 1;
+  }
+  std::vector<int8_t> actions(static_cast<size_t>(envs) * env.shipCount(),
+                              ACTION_AUTO);
+  std::vector<float> obs(envs * env.observationSize());
+  std::vector<float> rewards(static_cast<size_t>(envs) * env.teamCount());
+  std::vector<uint8_t> dones(envs);
+
+  env.reset(seeds.data());
+  long long envSteps = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int s = 0; s < steps; s++) {
+    env.step(actions.data(), VecEnv::PER_SHIP, rewards.data(), dones.data());
+    env.observe(obs.data());
+    for (int e = 0; e < envs; e++) {
+      envSteps++;
+      if (dones[e]) {
+        seeds[e] += envs;
+        env.resetEnv(e, seeds[e]);
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::cout << envs << " envs x " << steps << " steps: " << envSteps
+            << " env steps in " << seconds << " s ("
+            << (seconds > 0 ? envSteps / seconds : 0.0) << " steps/s), "
+            << env.observationSize() << " floats per observation\n";
+  return 0;
+}
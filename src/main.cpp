@@ -1,64 +1,348 @@
+#include "AllocAudit.h"
+#include "Daemon.h"
+#include "Evolve.h"
 #include "GameManager.h"
+#include "Journal.h"
+#include "LayoutBench.h"
+#include "Log.h"
+#include "MonteCarlo.h"
+#include "OutputPipeline.h"
+#include "Rollout.h"
+#include "ScenarioImage.h"
+#include "Scheduler.h"
 #include "ShipTypes.h"
+#include "Sweep.h"
+#include "Telemetry.h"
+#include "Trace.h"
+#include "VecEnv.h"
 #include "parseFile.h"
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <string>
+
+static void printUsage(const char *prog) {
+  std::cerr << "Usage: " << prog
+            << " <game_file.txt> [--seed N] [--async-output]"
+               " [--output-buffers N] [--output-policy block|drop]"
+               " [--telemetry FILE] [--quiet]\n"
+            << "       " << prog << " sweep <sweep_file.txt>\n"
+            << "       " << prog << " evolve <evolve_file.txt>\n"
+            << "       " << prog << " compile <game_file.txt> <image.wsim>\n"
+            << "       " << prog << " bench-layout [size] [reps]\n"
+            << "       " << prog << " bench-env <game_file.txt> [envs] [steps]\n"
+            << "       " << prog
+            << " trace <game_file.txt|gen:K> [--seed N] [--golden FILE]\n"
+            << "       " << prog
+            << " rollout <game_file.txt> --ship SYMBOL [--at N] [--depth N]"
+               " [--samples N] [--seed N]\n"
+            << "       " << prog
+            << " step <game_file.txt> [--seed N] [--keep N]\n"
+            << "       " << prog << " serve [--socket PATH]\n"
+            << "       " << prog << " telemetry-dump <file.wst>\n"
+            << "       " << prog
+            << " montecarlo <game_file.txt|gen:K> [--battles N] [--seed N]"
+               " [--threads N] [--pin] [--engine lockstep|object] [--verify]\n";
+}
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <game_file.txt>\n";
+    printUsage(argv[0]);
     return 1;
   }
 
   try {
-    // 1) Parse the config
-    GameParser parser;
-    GameConfig config = parser.parseFile(argv[1]);
+    std::string command = argv[1];
 
-    // 2) Create a GameManager
-    GameManager manager;
-    //    Set the battlefield terrain
-    manager.setBattlefieldTerrain(config.terrainGrid);
-
-    // 3) Create and add ships
-    //    For each ShipInfo in config.allShips
-    for (auto &info : config.allShips) {
-      // For each ship in the count
-      for (int i = 0; i < info.count; i++) {
-        // Build a unique symbol, e.g. "*1", "*2", etc.
-        std::string uniqueSymbol = info.symbol;
-        uniqueSymbol += std::to_string(i + 1);
-
-        Ship *newShip = nullptr;
-
-        // Decide which ship type to instantiate
-        if (info.type == "Battleship") {
-          newShip = new Battleship(uniqueSymbol, info.team, &manager);
-        } else if (info.type == "Cruiser") {
-          newShip = new Cruiser(uniqueSymbol, info.team, &manager);
-        } else if (info.type == "Frigate") {
-          newShip = new Frigate(uniqueSymbol, info.team, &manager);
-        } else if (info.type == "Amphibious") {
-          newShip = new Amphibious(uniqueSymbol, info.team, &manager);
-        } else if (info.type == "Destroyer") {
-          newShip = new Destroyer(uniqueSymbol, info.team, &manager);
-        } else if (info.type == "Corvette") {
-          newShip = new Corvette(uniqueSymbol, info.team, &manager);
-        } else if (info.type == "SuperShip") {
-          newShip = new SuperShip(uniqueSymbol, info.team, &manager);
+    // Parameter sweep mode
+    if (command == "sweep") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      SweepRunner runner;
+      SweepSpec spec = runner.parseSpec(argv[2]);
+      Scheduler scheduler(spec.threads, spec.pin);
+      return runner.run(spec, scheduler);
+    }
+
+    // Search for the best fleet of one team under a point budget
+    if (command == "evolve") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      FleetEvolver evolver;
+      EvolveSpec spec = evolver.parseSpec(argv[2]);
+      Scheduler scheduler(spec.threads, spec.pin);
+      return evolver.run(spec, scheduler);
+    }
+
+    // Warm daemon: play scenarios sent over stdin or a Unix socket
+    if (command == "serve") {
+      SimDaemon daemon;
+      if (argc > 3 && std::string(argv[2]) == "--socket") {
+        return daemon.serveSocket(argv[3]);
+      }
+      return daemon.serveStream(std::cin, std::cout);
+    }
+
+    // Cell layout benchmark
+    if (command == "bench-layout") {
+      int size = argc > 2 ? std::atoi(argv[2]) : 4096;
+      int reps = argc > 3 ? std::atoi(argv[3]) : 3;
+      return runLayoutBench(size, reps);
+    }
+
+    // Per-turn world trace, or a check against a stored one
+    if (command == "trace") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      uint64_t seed = 0;
+      bool hasSeed = false;
+      std::string golden;
+      for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+          hasSeed = true;
+          seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--golden" && i + 1 < argc) {
+          golden = argv[++i];
+        } else {
+          printUsage(argv[0]);
+          return 1;
+        }
+      }
+      return runTrace(argv[2], seed, hasSeed, golden);
+    }
+
+    // Many seeded battles of one scenario, summarised
+    if (command == "montecarlo") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      MonteCarloSpec spec;
+      int threads = 0;
+      bool pin = false;
+      for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--battles" && i + 1 < argc) {
+          spec.battles = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+          spec.firstSeed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+          threads = std::atoi(argv[++i]);
+        } else if (arg == "--pin") {
+          pin = true;
+        } else if (arg == "--engine" && i + 1 < argc) {
+          spec.objectEngine = std::string(argv[++i]) == "object";
+        } else if (arg == "--verify") {
+          spec.verify = true;
+        } else {
+          printUsage(argv[0]);
+          return 1;
+        }
+      }
+      std::string scenario = argv[2];
+      GameConfig config;
+      if (scenario.compare(0, 4, "gen:") == 0) {
+        config = generateScenario(std::stoull(scenario.substr(4)));
+      } else {
+        GameParser parser;
+        config = parser.parseFile(scenario);
+      }
+      Scheduler scheduler(threads, pin);
+      return runMonteCarlo(config, spec, scheduler, std::cout);
+    }
+
+    // Fork the battle at a turn and compare one ship's possible actions
+    if (command == "rollout") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      RolloutSpec spec;
+      std::string symbol;
+      int atTurn = 0;
+      for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--ship" && i + 1 < argc) {
+          symbol = argv[++i];
+        } else if (arg == "--at" && i + 1 < argc) {
+          atTurn = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && i + 1 < argc) {
+          spec.depth = std::atoi(argv[++i]);
+        } else if (arg == "--samples" && i + 1 < argc) {
+          spec.samples = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+          spec.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+          printUsage(argv[0]);
+          return 1;
+        }
+      }
+      if (symbol.empty()) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      GameParser parser;
+      return runRollouts(parser.parseFile(argv[2]), symbol, atTurn, spec);
+    }
+
+    // Play a battle turn by turn from stdin, stepping back as well
+    if (command == "step") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      GameParser parser;
+      GameConfig config = parser.parseFile(argv[2]);
+      size_t keep = 100;
+      for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+          config.hasSeed = true;
+          config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--keep" && i + 1 < argc) {
+          keep = std::strtoul(argv[++i], nullptr, 10);
         } else {
-          std::cerr << "Unknown ship type: " << info.type << std::endl;
+          printUsage(argv[0]);
+          return 1;
         }
+      }
+      return runStepper(config, keep, std::cin, std::cout);
+    }
+
+    // Vectorised environment throughput
+    if (command == "bench-env") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      GameParser parser;
+      int envs = argc > 3 ? std::atoi(argv[3]) : 64;
+      int steps = argc > 4 ? std::atoi(argv[4]) : 1000;
+      return runEnvBench(parser.parseFile(argv[2]), envs, steps);
+    }
+
+    // Scenario text -> binary image that later runs start from directly
+    if (command == "compile") {
+      if (argc < 4) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      GameParser parser;
+      ScenarioImage::compile(parser.parseFile(argv[2]), argv[3]);
+      return 0;
+    }
+
+    // Telemetry file -> CSV on stdout
+    if (command == "telemetry-dump") {
+      if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+      }
+      TelemetryWriter::dump(argv[2], std::cout);
+      return 0;
+    }
+
+    // 1) Parse the config, or map a compiled image (no parsing at all)
+    GameParser parser;
+    GameConfig config;
+    ScenarioImage image;
+    bool compiled = ScenarioImage::isImage(argv[1]);
+    if (compiled) {
+      image.open(argv[1]);
+      config.hasSeed = false; // only --seed below
+      config.iterations = image.header().iterations;
+    } else {
+      config = parser.parseFile(argv[1]);
+    }
 
-        // Add the ship if it was successfully created
-        if (newShip) {
-          manager.addShip(newShip);
+    bool asyncOutput = false;
+    size_t outputBuffers = 2;
+    OutputPipeline::Policy outputPolicy = OutputPipeline::BLOCK;
+    std::string telemetryPath;
+    bool quiet = false;
+    for (int i = 2; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--seed" && i + 1 < argc) {
+        config.hasSeed = true;
+        config.seed = std::strtoull(argv[++i], nullptr, 10);
+      } else if (arg == "--async-output") {
+        asyncOutput = true;
+      } else if (arg == "--output-buffers" && i + 1 < argc) {
+        asyncOutput = true;
+        outputBuffers = std::strtoul(argv[++i], nullptr, 10);
+      } else if (arg == "--output-policy" && i + 1 < argc) {
+        asyncOutput = true;
+        std::string policy = argv[++i];
+        if (policy == "block") {
+          outputPolicy = OutputPipeline::BLOCK;
+        } else if (policy == "drop") {
+          outputPolicy = OutputPipeline::DROP;
+        } else {
+          printUsage(argv[0]);
+          return 1;
         }
-      } // end for count
+      } else if (arg == "--telemetry" && i + 1 < argc) {
+        telemetryPath = argv[++i];
+      } else if (arg == "--quiet") {
+        quiet = true;
+      } else {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+
+    // Optional: format / write the log on a separate thread
+    std::unique_ptr<OutputPipeline> pipeline;
+    std::unique_ptr<ScopedLog> redirect;
+    if (quiet) {
+      redirect.reset(new ScopedLog(nullLog()));
+    } else if (asyncOutput) {
+      pipeline.reset(new OutputPipeline(std::cout, outputBuffers, outputPolicy));
+      redirect.reset(new ScopedLog(pipeline->stream()));
+    }
+
+    // 2) Create a GameManager, then set up the terrain and ships from config
+    GameManager manager;
+    manager.setOutputPipeline(pipeline.get());
+    if (compiled) {
+      manager.loadImage(image, config.hasSeed ? &config.seed : nullptr);
+    } else {
+      manager.loadConfig(config);
+    }
+
+    // Optional: per-turn ship rows in a compressed column file
+    std::unique_ptr<TelemetryWriter> telemetry;
+    if (!telemetryPath.empty()) {
+      telemetry.reset(new TelemetryWriter(telemetryPath));
+      manager.setTurnObserver(telemetry.get());
     }
 
-    // 4) Run the simulation with config.iterations
+    // 3) Run the simulation with config.iterations
     manager.runSimulation(config.iterations);
 
+    if (telemetry) {
+      telemetry->finish();
+      std::cerr << "Telemetry: " << telemetry->getRows() << " rows, "
+                << telemetry->getBytes() << " bytes\n";
+    }
+
+    if (pipeline && pipeline->getDroppedFrames() > 0) {
+      std::cerr << "Output: dropped " << pipeline->getDroppedFrames()
+                << " of " << manager.getTurnsPlayed() << " turn frames\n";
+    }
+
+    // Audit builds: a turn that touched the heap fails the run
+    if (AllocAudit::enabled() && !AllocAudit::report(std::cerr)) {
+      return 3;
+    }
+
   } catch (const std::exception &ex) {
     std::cerr << "Error: " << ex.what() << std::endl;
     return 1;
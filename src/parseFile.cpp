@@ -1,4 +1,5 @@
 #include "parseFile.h"
+#include "ShipScript.h"
 #include <cctype> // std::isdigit
 #include <fstream>
 #include <iostream>
@@ -13,23 +14,73 @@ static std::string buildSymbol(const std::string &baseSymbol, int index) {
   return baseSymbol + std::to_string(index);
 }
 
+// Append one "shiptype" block (its header already read) to `out`: comments
+// and blank lines dropped, whitespace normalised, up to and with "end"
+static void readShipTypeBlock(std::istream &in, const std::string &header,
+                              std::string &out) {
+  std::string line = header;
+  for (;;) {
+    std::istringstream words(line.substr(0, line.find('#')));
+    std::string word, text;
+    while (words >> word) {
+      text += (text.empty() ? "" : " ") + word;
+    }
+    if (!text.empty()) {
+      out += text + "\n";
+    }
+    if (text == "end")
+      return;
+    if (!std::getline(in, line)) {
+      throw std::runtime_error("Missing 'end' after: " + header);
+    }
+  }
+}
+
+std::string GameParser::loadShipTypes(const std::string &filename) const {
+  std::ifstream fin(filename);
+  if (!fin.is_open()) {
+    throw std::runtime_error("Cannot open ship types file: " + filename);
+  }
+  std::string text, line;
+  while (std::getline(fin, line)) {
+    std::istringstream iss(line.substr(0, line.find('#')));
+    std::string token;
+    if (!(iss >> token))
+      continue;
+    if (token != "shiptype") {
+      throw std::runtime_error("Expected a shiptype block in " + filename +
+                               ": " + line);
+    }
+    readShipTypeBlock(fin, line, text);
+  }
+  ShipCatalog().compile(text); // report errors now, not at load time
+  return text;
+}
+
 GameConfig GameParser::parseFile(const std::string &filename) {
   std::ifstream fin(filename);
   if (!fin.is_open()) {
     throw std::runtime_error("Cannot open file: " + filename);
   }
+  GameConfig config = parseStream(fin);
+  fin.close();
+  return config;
+}
 
+GameConfig GameParser::parseStream(std::istream &fin) {
   GameConfig config;
   // Initialize some defaults
   config.iterations = 100;
-  config.width = 10;
-  config.height = 10;
-  // zero out terrain grid by default
-  for (int i = 0; i < 10; i++) {
-    for (int j = 0; j < 10; j++) {
-      config.terrainGrid[i][j] = 0;
-    }
-  }
+  config.width = WIDTH;
+  config.height = HEIGHT;
+  config.layout = Battlefield::DENSE;
+  config.combat = CombatBuffer::IMMEDIATE;
+  config.respawnsPerTurn = 2;
+  config.shipRespawns = 3;
+  config.hasSeed = false;
+  config.seed = 0;
+  config.sleeping = false;
+  config.stalemateWindow = 0;
 
   // Read lines
   std::string line;
@@ -48,6 +99,79 @@ GameConfig GameParser::parseFile(const std::string &filename) {
       iss >> config.width;
     } else if (token == "height") {
       iss >> config.height;
+    } else if (token == "respawnsPerTurn") {
+      iss >> config.respawnsPerTurn;
+    } else if (token == "shipRespawns") {
+      iss >> config.shipRespawns;
+    } else if (token == "seed") {
+      iss >> config.seed;
+      config.hasSeed = true;
+    } else if (token == "layout") {
+      // Example: "layout chunked" => sparse 64x64 tiles for huge oceans
+      //          "layout tiled" / "layout morton" => cache-friendly orders
+      std::string name;
+      iss >> name;
+      if (!Battlefield::parseLayout(name, config.layout)) {
+        throw std::runtime_error("Unknown layout: " + name);
+      }
+    } else if (token == "combat") {
+      // Example: "combat batched" => simultaneous fire, resolved per turn
+      std::string name;
+      iss >> name;
+      if (!CombatBuffer::parseMode(name, config.combat)) {
+        throw std::runtime_error("Unknown combat mode: " + name);
+      }
+    } else if (token == "rate") {
+      // Example: "rate Battleship 2" => a Battleship acts every 2nd turn
+      //          "rate Corvette 1 5" => every turn, before initiative 0
+      GameConfig::RateInfo rate;
+      rate.initiative = 0;
+      iss >> rate.type >> rate.period;
+      if (!(iss >> rate.initiative)) {
+        rate.initiative = 0;
+      }
+      ShipType type;
+      if (!parseShipType(rate.type, type)) {
+        throw std::runtime_error("Unknown ship type in rate: " + rate.type);
+      }
+      if (rate.period < 1) {
+        throw std::runtime_error("Rate period must be at least 1: " + line);
+      }
+      config.rates.push_back(rate);
+    } else if (token == "stalemate") {
+      iss >> config.stalemateWindow;
+    } else if (token == "activity") {
+      // Example: "activity sleep" => idle ships skip turns until woken
+      std::string name;
+      iss >> name;
+      if (name != "sleep" && name != "always") {
+        throw std::runtime_error("Unknown activity mode: " + name);
+      }
+      config.sleeping = (name == "sleep");
+    } else if (token == "shiptype") {
+      // Example: "shiptype Sniper like Battleship" ... "end"
+      std::string block;
+      readShipTypeBlock(fin, line, block);
+      config.shipTypes += block;
+    } else if (token == "shiptypes") {
+      // Example: "shiptypes fleet.wsh" => every block of that file
+      std::string file;
+      iss >> file;
+      config.shipTypes += loadShipTypes(file);
+    } else if (token == "island") {
+      // Example: "island 5 7" => one island cell at row 5, col 7
+      //          "island 5 7 3 4" => 3x4 block of islands starting there
+      // Handy for big boards where writing out the grid is not practical
+      int row = 0, col = 0, rows = 1, cols = 1;
+      iss >> row >> col;
+      if (!(iss >> rows >> cols)) {
+        rows = cols = 1;
+      }
+      for (int r = row; r < row + rows; r++) {
+        for (int c = col; c < col + cols; c++) {
+          config.islands.push_back(Position(r, c));
+        }
+      }
     } else if (token == "Team") {
       // Example: "Team A 4" => teamName="A", shipTypeCount=4
       std::string teamName;
@@ -79,7 +203,6 @@ GameConfig GameParser::parseFile(const std::string &filename) {
       // Because your example has 10 lines of "0 0 0 1..." etc.
       // We already have 'token' which should be the first int in row 0
       // We'll parse 'height' rows, each containing 'width' integers
-      // Here we assume config.height=10, config.width=10
       fin.seekg(-static_cast<int>(line.size()) - 1, std::ios::cur);
       // Move file pointer back so we can re-read the line fully
       for (int r = 0; r < config.height; r++) {
@@ -88,9 +211,11 @@ GameConfig GameParser::parseFile(const std::string &filename) {
         }
         std::istringstream gridIss(line);
         for (int c = 0; c < config.width; c++) {
-          int val;
+          int val = 0;
           gridIss >> val;
-          config.terrainGrid[r][c] = val;
+          if (val == 1) {
+            config.islands.push_back(Position(r, c));
+          }
         }
       }
     } else {
@@ -99,6 +224,52 @@ GameConfig GameParser::parseFile(const std::string &filename) {
     }
   } // end while
 
-  fin.close();
+  if (!config.shipTypes.empty()) {
+    ShipCatalog().compile(config.shipTypes); // syntax errors surface here
+  }
   return config;
 }
+
+std::string GameParser::serialize(const GameConfig &config) const {
+  std::ostringstream out;
+  out << "iterations " << config.iterations << "\n";
+  out << "width " << config.width << "\n";
+  out << "height " << config.height << "\n";
+  out << "respawnsPerTurn " << config.respawnsPerTurn << "\n";
+  out << "shipRespawns " << config.shipRespawns << "\n";
+  if (config.hasSeed) {
+    out << "seed " << config.seed << "\n";
+  }
+  out << "layout " << Battlefield::layoutName(config.layout) << "\n";
+  out << "combat " << CombatBuffer::modeName(config.combat) << "\n";
+  if (config.sleeping) {
+    out << "activity sleep\n";
+  }
+  if (config.stalemateWindow > 0) {
+    out << "stalemate " << config.stalemateWindow << "\n";
+  }
+  for (const GameConfig::RateInfo &r : config.rates) {
+    out << "rate " << r.type << " " << r.period << " " << r.initiative << "\n";
+  }
+  out << config.shipTypes;
+  for (const Position &p : config.islands) {
+    out << "island " << p.x << " " << p.y << "\n";
+  }
+
+  // Ships are grouped back into "Team" blocks, keeping their order
+  size_t i = 0;
+  while (i < config.allShips.size()) {
+    size_t j = i;
+    while (j < config.allShips.size() &&
+           config.allShips[j].team == config.allShips[i].team) {
+      j++;
+    }
+    out << "Team " << config.allShips[i].team << " " << (j - i) << "\n";
+    for (size_t k = i; k < j; k++) {
+      const GameConfig::ShipInfo &info = config.allShips[k];
+      out << info.type << " " << info.symbol << " " << info.count << "\n";
+    }
+    i = j;
+  }
+  return out.str();
+}